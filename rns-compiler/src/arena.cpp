@@ -0,0 +1,53 @@
+#include "arena.h"
+
+using namespace RNS;
+
+Arena Arena::create(Allocator* allocator, s64 size)
+{
+    u8* base = get_allocator_top(allocator);
+    Arena arena = {
+        .allocator = allocator,
+        .block_base = base,
+        .block_end = base + size,
+        .block_size = size,
+        .previous_blocks_used_size = 0,
+        .block_count = 0,
+    };
+
+    return arena;
+}
+
+void Arena::reserve(s64 size)
+{
+    u8* top = get_allocator_top(allocator);
+    if (block_end - top >= size + arena_margin)
+    {
+        return;
+    }
+
+    assert(block_count < arena_max_block_count);
+    previous_blocks_used_size += top - block_base;
+    s64 new_block_size = 2 * block_size > size + 2 * arena_margin ? 2 * block_size : size + 2 * arena_margin;
+    // @Info: the block keeps the allocator it was created with, to be freed with it, and the arena allocates from a copy of it
+    blocks[block_count] = default_create_allocator(new_block_size);
+    *allocator = blocks[block_count];
+    block_count++;
+
+    block_base = get_allocator_top(allocator);
+    block_end = block_base + new_block_size - 1;
+    block_size = new_block_size;
+}
+
+s64 Arena::get_used_size()
+{
+    return previous_blocks_used_size + (get_allocator_top(allocator) - block_base);
+}
+
+void Arena::free_blocks()
+{
+    for (u32 i = 0; i < block_count; i++)
+    {
+        default_free_allocator(&blocks[i]);
+    }
+    block_count = 0;
+}
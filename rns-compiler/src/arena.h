@@ -0,0 +1,42 @@
+#pragma once
+#include <RNS/types.h>
+#include <RNS/os.h>
+
+/* Growing arenas
+ * The arenas a compilation works in are carved out before it starts, sized from a memory profile or from the built-in sizes, and a
+ * source unlike the ones measured so far can need more than that. An Arena watches the bump allocator of one of them and knows
+ * where its block ends. The structures which grow with the source reserve room before they take a new chunk or a bigger table,
+ * and the phases reserve a margin before every statement for the small allocations in between. When what is left of the block
+ * doesn't cover it, the allocator is moved to a new block from the OS, at least twice as big as the last one. Everything which
+ * points to that allocator takes its memory from the new block from then on, and what was allocated before stays where it was.
+ * The blocks from the OS live until free_blocks.
+ */
+const s64 arena_margin = RNS_MEGABYTE(1);
+const u32 arena_max_block_count = 32;
+
+// @Info: the allocators are bump allocators, so the address the next allocation gets tells how much has been allocated so far.
+// The probe itself takes a byte, nothing next to what a phase allocates
+inline u8* get_allocator_top(RNS::Allocator* allocator)
+{
+    return new(allocator) u8;
+}
+
+struct Arena
+{
+    // @Info: the allocator which grows, wherever it lives. It can be pointed to another one which continues the same block
+    RNS::Allocator* allocator;
+    u8* block_base;
+    u8* block_end;
+    s64 block_size;
+    // @Info: bytes used in the blocks left behind
+    s64 previous_blocks_used_size;
+    RNS::Allocator blocks[arena_max_block_count];
+    u32 block_count;
+
+    // @Info: the allocator has to have size bytes left
+    static Arena create(RNS::Allocator* allocator, s64 size);
+    // @Info: makes room for size bytes and the margin, moving to a new block if the current one doesn't have it
+    void reserve(s64 size);
+    s64 get_used_size();
+    void free_blocks();
+};
@@ -0,0 +1,608 @@
+#include "compile_cache.h"
+#include "file_system.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#include <sys/utime.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <utime.h>
+#endif
+
+using namespace RNS;
+
+const u32 compile_cache_entry_magic = 0x45434E52; // "RNCE"
+const u32 compile_cache_entry_version = 1;
+const char compile_cache_entry_extension[] = ".ir";
+const char compile_cache_temporary_extension[] = ".tmp";
+const char compile_cache_index_name[] = "cache.index";
+const u32 compile_cache_index_version = 1;
+// @Info: a temporary file this old was left by a compiler which died before renaming it
+const u64 compile_cache_stale_temporary_seconds = 60 * 60;
+const s64 compile_cache_path_length = compile_cache_max_directory_length + 128;
+
+struct CompileCacheEntryHeader
+{
+    u32 magic;
+    u32 version;
+    CompileCacheKey key;
+    u64 output_length;
+};
+
+/* SHA-256
+ * A collision would silently hand back the output of another program, so the key needs a cryptographic hash, not a table one.
+ */
+static const u32 sha256_round_constants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static inline u32 rotate_right(u32 value, u32 count)
+{
+    return (value >> count) | (value << (32 - count));
+}
+
+struct SHA256
+{
+    u32 state[8];
+    u64 length;
+    u8 block[64];
+    u32 block_length;
+
+    static SHA256 create()
+    {
+        SHA256 sha = {
+            .state = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 },
+        };
+
+        return sha;
+    }
+
+    void process_block(const u8* bytes)
+    {
+        u32 w[64];
+        for (u32 i = 0; i < 16; i++)
+        {
+            w[i] = (static_cast<u32>(bytes[4 * i]) << 24) | (static_cast<u32>(bytes[4 * i + 1]) << 16) | (static_cast<u32>(bytes[4 * i + 2]) << 8) | bytes[4 * i + 3];
+        }
+        for (u32 i = 16; i < 64; i++)
+        {
+            u32 s0 = rotate_right(w[i - 15], 7) ^ rotate_right(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            u32 s1 = rotate_right(w[i - 2], 17) ^ rotate_right(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        u32 a = state[0], b = state[1], c = state[2], d = state[3], e = state[4], f = state[5], g = state[6], h = state[7];
+        for (u32 i = 0; i < 64; i++)
+        {
+            u32 s1 = rotate_right(e, 6) ^ rotate_right(e, 11) ^ rotate_right(e, 25);
+            u32 choice = (e & f) ^ (~e & g);
+            u32 t1 = h + s1 + choice + sha256_round_constants[i] + w[i];
+            u32 s0 = rotate_right(a, 2) ^ rotate_right(a, 13) ^ rotate_right(a, 22);
+            u32 majority = (a & b) ^ (a & c) ^ (b & c);
+            u32 t2 = s0 + majority;
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+
+    void update(const void* data, s64 size)
+    {
+        auto* bytes = static_cast<const u8*>(data);
+        length += size;
+
+        if (block_length)
+        {
+            s64 copy_size = 64 - block_length < size ? 64 - block_length : size;
+            memcpy(&block[block_length], bytes, copy_size);
+            block_length += static_cast<u32>(copy_size);
+            bytes += copy_size;
+            size -= copy_size;
+            if (block_length < 64)
+            {
+                return;
+            }
+            process_block(block);
+            block_length = 0;
+        }
+
+        for (; size >= 64; bytes += 64, size -= 64)
+        {
+            process_block(bytes);
+        }
+
+        memcpy(block, bytes, size);
+        block_length = static_cast<u32>(size);
+    }
+
+    CompileCacheKey finish()
+    {
+        u64 bit_length = length * 8;
+        u8 padding[72] = { 0x80 };
+        u32 padding_length = block_length < 56 ? 56 - block_length : 120 - block_length;
+        for (u32 i = 0; i < 8; i++)
+        {
+            padding[padding_length + i] = static_cast<u8>(bit_length >> (56 - 8 * i));
+        }
+        update(padding, padding_length + 8);
+        assert(block_length == 0);
+
+        CompileCacheKey key;
+        for (u32 i = 0; i < 8; i++)
+        {
+            key.bytes[4 * i] = static_cast<u8>(state[i] >> 24);
+            key.bytes[4 * i + 1] = static_cast<u8>(state[i] >> 16);
+            key.bytes[4 * i + 2] = static_cast<u8>(state[i] >> 8);
+            key.bytes[4 * i + 3] = static_cast<u8>(state[i]);
+        }
+
+        return key;
+    }
+
+    // @Info: strings are hashed with their length first, so the boundaries between them are part of the key
+    void update_string(RNS::String string)
+    {
+        u64 string_length = string.len;
+        update(&string_length, sizeof(string_length));
+        update(string.ptr, string.len);
+    }
+};
+
+/* File system
+ * Thin wrappers over what the cache needs from the native API. Failures are not fatal: a missing entry is a miss, and an entry
+ * which can't be written or removed only costs a future compilation.
+ */
+struct CacheFile
+{
+    char name[128];
+    s64 size;
+    u64 last_use;
+};
+
+#if defined(_WIN32)
+static bool create_directory(const char* path)
+{
+    return CreateDirectoryA(path, nullptr) || GetLastError() == ERROR_ALREADY_EXISTS;
+}
+
+static void touch_file(const char* path)
+{
+    _utime(path, nullptr);
+}
+
+// @Info: in the unit of CacheFile::last_use, 100 ns intervals
+const u64 file_time_units_per_second = 10000000;
+
+static u64 get_file_time_now()
+{
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    return (static_cast<u64>(now.dwHighDateTime) << 32) | now.dwLowDateTime;
+}
+
+// @Info: calls callback for every file in the directory with the extension and returns how many there are
+template <typename Callback>
+static s64 for_each_cache_file(const char* directory, const char* extension, Callback callback)
+{
+    char pattern[compile_cache_path_length];
+    snprintf(pattern, sizeof(pattern), "%s/*%s", directory, extension);
+
+    WIN32_FIND_DATAA find_data;
+    HANDLE find_handle = FindFirstFileA(pattern, &find_data);
+    if (find_handle == INVALID_HANDLE_VALUE)
+    {
+        return 0;
+    }
+
+    s64 file_count = 0;
+    do
+    {
+        if (!(find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) && strlen(find_data.cFileName) < sizeof(CacheFile::name))
+        {
+            CacheFile file = {
+                .size = (static_cast<s64>(find_data.nFileSizeHigh) << 32) | find_data.nFileSizeLow,
+                .last_use = (static_cast<u64>(find_data.ftLastWriteTime.dwHighDateTime) << 32) | find_data.ftLastWriteTime.dwLowDateTime,
+            };
+            strcpy(file.name, find_data.cFileName);
+            callback(file);
+            file_count++;
+        }
+    } while (FindNextFileA(find_handle, &find_data));
+    FindClose(find_handle);
+
+    return file_count;
+}
+#else
+static bool create_directory(const char* path)
+{
+    struct stat directory_stat;
+    return mkdir(path, 0755) == 0 || (stat(path, &directory_stat) == 0 && S_ISDIR(directory_stat.st_mode));
+}
+
+static void touch_file(const char* path)
+{
+    utime(path, nullptr);
+}
+
+// @Info: in the unit of CacheFile::last_use, seconds
+const u64 file_time_units_per_second = 1;
+
+static u64 get_file_time_now()
+{
+    return static_cast<u64>(time(nullptr));
+}
+
+template <typename Callback>
+static s64 for_each_cache_file(const char* directory, const char* extension, Callback callback)
+{
+    DIR* directory_handle = opendir(directory);
+    if (!directory_handle)
+    {
+        return 0;
+    }
+
+    s64 file_count = 0;
+    s64 extension_length = strlen(extension);
+    while (struct dirent* directory_entry = readdir(directory_handle))
+    {
+        s64 name_length = strlen(directory_entry->d_name);
+        if (name_length <= extension_length || name_length >= static_cast<s64>(sizeof(CacheFile::name)) || strcmp(&directory_entry->d_name[name_length - extension_length], extension) != 0)
+        {
+            continue;
+        }
+
+        char path[compile_cache_path_length];
+        snprintf(path, sizeof(path), "%s/%s", directory, directory_entry->d_name);
+        struct stat file_stat;
+        if (stat(path, &file_stat) != 0 || !S_ISREG(file_stat.st_mode))
+        {
+            continue;
+        }
+
+        CacheFile file = {
+            .size = file_stat.st_size,
+            .last_use = static_cast<u64>(file_stat.st_mtime),
+        };
+        strcpy(file.name, directory_entry->d_name);
+        callback(file);
+        file_count++;
+    }
+    closedir(directory_handle);
+
+    return file_count;
+}
+#endif
+
+static void get_entry_path(const char* directory, CompileCacheKey key, char* path)
+{
+    char key_string[2 * sizeof(key.bytes) + 1];
+    for (u32 i = 0; i < sizeof(key.bytes); i++)
+    {
+        snprintf(&key_string[2 * i], 3, "%02x", key.bytes[i]);
+    }
+    snprintf(path, compile_cache_path_length, "%s/%s%s", directory, key_string, compile_cache_entry_extension);
+}
+
+static int compare_last_use(const void* a, const void* b)
+{
+    u64 a_last_use = static_cast<const CacheFile*>(a)->last_use;
+    u64 b_last_use = static_cast<const CacheFile*>(b)->last_use;
+    return (a_last_use > b_last_use) - (a_last_use < b_last_use);
+}
+
+// @Info: the size of the entries, kept running in a file of the directory so a store doesn't have to list it. The compilers sharing
+// the directory may overwrite each other's update, which only holds an eviction back until the next scan counts the files again
+static bool read_cache_index(const char* directory, s64* total_size)
+{
+    char path[compile_cache_path_length];
+    snprintf(path, sizeof(path), "%s/%s", directory, compile_cache_index_name);
+    FILE* file = fopen(path, "rb");
+    if (!file)
+    {
+        return false;
+    }
+
+    u32 version;
+    long long size;
+    bool read = fscanf(file, "rns-compile-cache %u %lld", &version, &size) == 2 && version == compile_cache_index_version && size >= 0;
+    fclose(file);
+
+    *total_size = size;
+    return read;
+}
+
+static void write_cache_index(const char* directory, s64 total_size)
+{
+    char path[compile_cache_path_length];
+    snprintf(path, sizeof(path), "%s/%s", directory, compile_cache_index_name);
+    char temporary_path[compile_cache_path_length + 32];
+    snprintf(temporary_path, sizeof(temporary_path), "%s.%u%s", path, FileSystem::get_process_id(), compile_cache_temporary_extension);
+
+    FILE* file = fopen(temporary_path, "wb");
+    if (!file)
+    {
+        return;
+    }
+
+    bool written = fprintf(file, "rns-compile-cache %u %" PRId64 "\n", compile_cache_index_version, total_size) > 0;
+    written = fclose(file) == 0 && written;
+    if (!written || !FileSystem::replace_file(temporary_path, path))
+    {
+        remove(temporary_path);
+    }
+}
+
+static s64 get_file_size(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file)
+    {
+        return 0;
+    }
+
+    s64 file_size = fseek(file, 0, SEEK_END) == 0 ? ftell(file) : 0;
+    fclose(file);
+    return file_size > 0 ? file_size : 0;
+}
+
+// @Info: lists the directory, which only happens when there is no index yet or the running size goes past the limit. Removes the
+// temporary files left behind by compilers which died, counts the entries again, and if they really are over the limit removes
+// the least recently used ones until back under three quarters of it, so the next stores don't have to scan again straight away.
+// The index gets the size the directory ends with
+static u64 scan_cache(const char* directory, s64 max_size)
+{
+    u64 stale_time = get_file_time_now() - compile_cache_stale_temporary_seconds * file_time_units_per_second;
+    for_each_cache_file(directory, compile_cache_temporary_extension, [directory, stale_time](CacheFile& file)
+    {
+        if (file.last_use < stale_time)
+        {
+            char path[compile_cache_path_length];
+            snprintf(path, sizeof(path), "%s/%s", directory, file.name);
+            remove(path);
+        }
+    });
+
+    s64 total_size = 0;
+    s64 file_count = for_each_cache_file(directory, compile_cache_entry_extension, [&total_size](CacheFile& file)
+    {
+        total_size += file.size;
+    });
+    if (total_size <= max_size)
+    {
+        write_cache_index(directory, total_size);
+        return 0;
+    }
+
+    // @Info: the directory may change while it is listed again, so the second pass keeps at most as many files as the first found
+    Allocator file_allocator = default_create_allocator(file_count * sizeof(CacheFile) + 1024);
+    Buffer<CacheFile> files = Buffer<CacheFile>::create(&file_allocator, file_count);
+    for_each_cache_file(directory, compile_cache_entry_extension, [&files](CacheFile& file)
+    {
+        if (files.len < files.cap)
+        {
+            files.append(file);
+        }
+    });
+    qsort(files.ptr, files.len, sizeof(CacheFile), compare_last_use);
+
+    u64 eviction_count = 0;
+    s64 target_size = max_size / 4 * 3;
+    for (auto& file : files)
+    {
+        if (total_size <= target_size)
+        {
+            break;
+        }
+
+        char path[compile_cache_path_length];
+        snprintf(path, sizeof(path), "%s/%s", directory, file.name);
+        if (remove(path) == 0)
+        {
+            total_size -= file.size;
+            eviction_count++;
+        }
+    }
+
+    default_free_allocator(&file_allocator);
+    write_cache_index(directory, total_size);
+    return eviction_count;
+}
+
+// @Info: a rebuilt compiler may emit something else for the same sources, so the key covers the compiler itself and no entry
+// outlives the binary which wrote it
+static bool hash_compiler_executable(CompileCacheKey* compiler_hash)
+{
+    char path[compile_cache_path_length];
+    if (!FileSystem::get_executable_path(path, sizeof(path)))
+    {
+        return false;
+    }
+
+    FILE* file = fopen(path, "rb");
+    if (!file)
+    {
+        return false;
+    }
+
+    SHA256 sha = SHA256::create();
+    u8 block[RNS_KILOBYTE(64)];
+    usize read_size;
+    while ((read_size = fread(block, 1, sizeof(block), file)) != 0)
+    {
+        sha.update(block, static_cast<s64>(read_size));
+    }
+    bool read = ferror(file) == 0;
+    fclose(file);
+
+    *compiler_hash = sha.finish();
+    return read;
+}
+
+CompileCache CompileCache::create(const char* directory, s64 max_size)
+{
+    CompileCache cache = {
+        .max_size = max_size,
+    };
+
+    s64 directory_length = strlen(directory);
+    if (directory_length == 0 || directory_length >= compile_cache_max_directory_length)
+    {
+        printf("Invalid cache directory %s\n", directory);
+        return cache;
+    }
+
+    if (!create_directory(directory))
+    {
+        printf("Couldn't create the cache directory %s\n", directory);
+        return cache;
+    }
+
+    if (!hash_compiler_executable(&cache.compiler_hash))
+    {
+        printf("Couldn't read the compiler executable to tell its outputs apart, the cache is off\n");
+        return cache;
+    }
+
+    memcpy(cache.directory, directory, directory_length + 1);
+    return cache;
+}
+
+CompileCacheKey CompileCache::get_key(RNS::String version, RNS::String options, RNS::String* sources, u32 source_count)
+{
+    SHA256 sha = SHA256::create();
+    sha.update(&compile_cache_entry_version, sizeof(compile_cache_entry_version));
+    sha.update(compiler_hash.bytes, sizeof(compiler_hash.bytes));
+    sha.update_string(version);
+    sha.update_string(options);
+    sha.update(&source_count, sizeof(source_count));
+    for (u32 i = 0; i < source_count; i++)
+    {
+        sha.update_string(sources[i]);
+    }
+
+    return sha.finish();
+}
+
+bool CompileCache::load(CompileCacheKey key, Allocator* allocator, RNS::String* output)
+{
+    char path[compile_cache_path_length];
+    get_entry_path(directory, key, path);
+
+    FILE* file = fopen(path, "rb");
+    if (!file)
+    {
+        stats.misses++;
+        return false;
+    }
+
+    // @Info: the length is checked against the file before anything is allocated, so a damaged header can't ask for more memory
+    // than the entry holds
+    s64 file_size = fseek(file, 0, SEEK_END) == 0 ? ftell(file) : -1;
+    CompileCacheEntryHeader header;
+    bool valid = file_size >= static_cast<s64>(sizeof(header)) && fseek(file, 0, SEEK_SET) == 0 && fread(&header, sizeof(header), 1, file) == 1 && header.magic == compile_cache_entry_magic && header.version == compile_cache_entry_version && memcmp(&header.key, &key, sizeof(key)) == 0 && header.output_length == static_cast<u64>(file_size) - sizeof(header);
+    char* output_bytes = nullptr;
+    if (valid)
+    {
+        output_bytes = new(allocator) char[header.output_length + 1];
+        valid = fread(output_bytes, 1, header.output_length, file) == header.output_length;
+    }
+    fclose(file);
+
+    if (!valid)
+    {
+        // @Info: entries are only ever renamed into place complete, but the file system may still lose part of one in a crash
+        remove(path);
+        stats.misses++;
+        return false;
+    }
+
+    output_bytes[header.output_length] = 0;
+    *output = { output_bytes, static_cast<s64>(header.output_length) };
+    touch_file(path);
+    stats.hits++;
+    return true;
+}
+
+void CompileCache::store(CompileCacheKey key, RNS::String output)
+{
+    char path[compile_cache_path_length];
+    get_entry_path(directory, key, path);
+    // @Info: unique per process, so concurrent compilers of the same sources each write their own and the last rename wins
+    char temporary_path[compile_cache_path_length + 32];
+    snprintf(temporary_path, sizeof(temporary_path), "%s.%u%s", path, FileSystem::get_process_id(), compile_cache_temporary_extension);
+    // @Info: storing a key again replaces its entry, which the running size already counts
+    s64 replaced_size = get_file_size(path);
+
+    FILE* file = fopen(temporary_path, "wb");
+    if (!file)
+    {
+        return;
+    }
+
+    CompileCacheEntryHeader header = {
+        .magic = compile_cache_entry_magic,
+        .version = compile_cache_entry_version,
+        .key = key,
+        .output_length = static_cast<u64>(output.len),
+    };
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(output.ptr, 1, output.len, file) == static_cast<usize>(output.len);
+    written = fclose(file) == 0 && written;
+
+    if (!written || !FileSystem::replace_file(temporary_path, path))
+    {
+        remove(temporary_path);
+        return;
+    }
+
+    stats.stores++;
+    s64 total_size;
+    if (!read_cache_index(directory, &total_size))
+    {
+        stats.evictions += scan_cache(directory, max_size);
+        return;
+    }
+
+    total_size += static_cast<s64>(sizeof(header)) + output.len - replaced_size;
+    if (total_size > max_size)
+    {
+        stats.evictions += scan_cache(directory, max_size);
+        return;
+    }
+    write_cache_index(directory, total_size);
+}
+
+void CompileCache::print_stats()
+{
+    printf("Compilation cache: %" PRIu64 " hits, %" PRIu64 " misses, %" PRIu64 " stores, %" PRIu64 " evictions\n", stats.hits, stats.misses, stats.stores, stats.evictions);
+}
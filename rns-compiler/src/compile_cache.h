@@ -0,0 +1,53 @@
+#pragma once
+#include <RNS/types.h>
+#include <RNS/data_structures.h>
+
+/* Compilation cache
+ * Content-addressed store of the compiler output. The key is the SHA-256 of everything which decides the output: the compiler
+ * executable, its version, the options and the bytes of every source file, in order. A hit gives back the stored output without
+ * lexing, parsing or encoding anything. Every entry is a file of its own in the cache directory, named after its key, so several
+ * compilers (or a compile server and a plain compiler) can share the directory. Entries are written to a temporary file which is
+ * then renamed over the entry, so a reader never sees a partial one. Reading an entry touches it, and once the directory grows
+ * past its size limit the least recently used entries are removed.
+ * The size of the entries is kept running in an index file, so a store only lists the directory once that size goes past the limit.
+ * The scan counts the entries again, since compilers sharing the directory can lose each other's updates of the index, and removes
+ * the temporary files of compilers which died before renaming them.
+ */
+const s64 compile_cache_default_size = RNS_MEGABYTE(512);
+const s64 compile_cache_max_directory_length = 4096 - 128;
+
+struct CompileCacheKey
+{
+    u8 bytes[32];
+};
+
+struct CompileCacheStats
+{
+    u64 hits;
+    u64 misses;
+    u64 stores;
+    u64 evictions;
+};
+
+struct CompileCache
+{
+    char directory[compile_cache_max_directory_length];
+    s64 max_size;
+    // @Info: SHA-256 of the compiler executable, read once when the cache is created
+    CompileCacheKey compiler_hash;
+    CompileCacheStats stats;
+
+    // @Info: creates the directory if it doesn't exist
+    static CompileCache create(const char* directory, s64 max_size);
+
+    inline bool is_valid()
+    {
+        return directory[0] != 0;
+    }
+
+    CompileCacheKey get_key(RNS::String version, RNS::String options, RNS::String* sources, u32 source_count);
+    // @Info: on a hit the output is read into memory from the allocator
+    bool load(CompileCacheKey key, RNS::Allocator* allocator, RNS::String* output);
+    void store(CompileCacheKey key, RNS::String output);
+    void print_stats();
+};
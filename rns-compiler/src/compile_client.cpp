@@ -0,0 +1,185 @@
+#include <RNS/types.h>
+#include <RNS/data_structures.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <limits.h>
+#endif
+
+#include "compile_server.h"
+#include "local_socket.h"
+
+using namespace RNS;
+
+/* Compile server client
+ * Usage: rns-client [--socket path] [--stop] [--stdin] file.rns ...
+ * Sends the files to a server started with rns-compiler --server and prints what it streams back. The exit code is the one of
+ * the compilation, so the client can stand in for rns-compiler in a build system. The paths are made absolute first, since the
+ * server has its own working directory. --stdin also sends the source read from the standard input, and --stop shuts the server down.
+ */
+const s64 max_stdin_source_size = RNS_MEGABYTE(256);
+const s64 max_path_length = 4096;
+
+static bool get_absolute_path(const char* path, char* buffer)
+{
+#if defined(_WIN32)
+    return _fullpath(buffer, path, max_path_length) != nullptr;
+#else
+    static_assert(max_path_length >= PATH_MAX);
+    return realpath(path, buffer) != nullptr;
+#endif
+}
+
+static bool send_input(LocalSocket& socket, CompileInputKind kind, const char* bytes, s64 length)
+{
+    assert(length <= UINT32_MAX);
+    CompileInput input = {
+        .kind = kind,
+        .length = static_cast<u32>(length),
+    };
+
+    return socket.send_all(&input, sizeof(input)) && socket.send_all(bytes, length);
+}
+
+static s64 read_stdin(char* buffer, s64 capacity)
+{
+#if defined(_WIN32)
+    _setmode(_fileno(stdin), _O_BINARY);
+#endif
+    s64 length = 0;
+    while (length < capacity)
+    {
+        usize byte_count = fread(&buffer[length], 1, capacity - length, stdin);
+        if (byte_count == 0)
+        {
+            break;
+        }
+        length += byte_count;
+    }
+
+    return length;
+}
+
+// @Info: prints the reply as it arrives, except for the bytes which may still turn out to be the trailer, and returns its exit code
+static s32 print_reply(LocalSocket& socket)
+{
+    char buffer[16 * 1024 + sizeof(CompileReplyTrailer)];
+    s64 pending = 0;
+    for (;;)
+    {
+        s64 received = socket.receive(&buffer[pending], sizeof(buffer) - pending);
+        if (received <= 0)
+        {
+            break;
+        }
+        pending += received;
+
+        s64 printable = pending - static_cast<s64>(sizeof(CompileReplyTrailer));
+        if (printable > 0)
+        {
+            fwrite(buffer, 1, printable, stdout);
+            memmove(buffer, &buffer[printable], pending - printable);
+            pending -= printable;
+        }
+    }
+    fflush(stdout);
+
+    CompileReplyTrailer trailer;
+    if (pending != sizeof(trailer) || (memcpy(&trailer, buffer, sizeof(trailer)), trailer.magic != compile_protocol_magic))
+    {
+        printf("The compile server closed the connection before replying\n");
+        return -1;
+    }
+
+    return trailer.exit_code;
+}
+
+s32 rns_main(s32 argc, char* argv[])
+{
+    const char* socket_path = get_default_socket_path();
+    bool stop = false;
+    bool read_source_from_stdin = false;
+    u32 input_count = 0;
+    s32 first_file = argc;
+    for (s32 i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc)
+        {
+            socket_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--stop") == 0)
+        {
+            stop = true;
+        }
+        else if (strcmp(argv[i], "--stdin") == 0)
+        {
+            read_source_from_stdin = true;
+        }
+        else
+        {
+            first_file = i;
+            break;
+        }
+    }
+    input_count = static_cast<u32>(argc - first_file) + read_source_from_stdin;
+
+    if (!stop && !input_count)
+    {
+        printf("Usage: rns-client [--socket path] [--stop] [--stdin] file.rns ...\n");
+        return -1;
+    }
+
+    LocalSocket socket = LocalSocket::connect(socket_path);
+    if (!socket.is_valid())
+    {
+        printf("Couldn't connect to a compile server on %s, start one with rns-compiler --server\n", socket_path);
+        return -1;
+    }
+
+    CompileRequest request = {
+        .magic = compile_protocol_magic,
+        .version = compile_protocol_version,
+        .flags = stop ? static_cast<u32>(CompileRequestFlag::Shutdown) : 0,
+        .input_count = stop ? 0 : input_count,
+    };
+    bool sent = socket.send_all(&request, sizeof(request));
+
+    for (s32 i = first_file; sent && !stop && i < argc; i++)
+    {
+        char absolute_path[max_path_length];
+        const char* path = get_absolute_path(argv[i], absolute_path) ? absolute_path : argv[i];
+        sent = send_input(socket, CompileInputKind::Path, path, strlen(path));
+    }
+
+    Allocator source_allocator = {};
+    if (sent && !stop && read_source_from_stdin)
+    {
+        source_allocator = default_create_allocator(max_stdin_source_size + 1024);
+        char* source = new(&source_allocator) char[max_stdin_source_size];
+        s64 source_length = read_stdin(source, max_stdin_source_size);
+        sent = send_input(socket, CompileInputKind::Source, source, source_length);
+    }
+
+    s32 exit_code = -1;
+    if (sent)
+    {
+        exit_code = print_reply(socket);
+    }
+    else
+    {
+        printf("Couldn't send the compile request to the server\n");
+    }
+
+    socket.close();
+    if (read_source_from_stdin && !stop)
+    {
+        default_free_allocator(&source_allocator);
+    }
+    return exit_code;
+}
@@ -0,0 +1,373 @@
+#include <RNS/types.h>
+#include <RNS/compiler.h>
+#include <RNS/data_structures.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "compile_cache.h"
+#include "compile_server.h"
+#include "compiler_types.h"
+#include "driver.h"
+#include "local_socket.h"
+#include "memory_profile.h"
+#include "source_file.h"
+#include "thread.h"
+
+using namespace RNS;
+
+/* Compile server
+ * A plain compile spends most of its time on small files setting up: creating and faulting in a fresh page allocator, and building
+ * the tables the front-end needs. The server creates them once and compiles every request inside them. Requests only allocate past
+ * a mark taken at startup, and rewinding the allocators to it frees the memory of a request while its pages stay mapped for the
+ * next one. The global symbol table has an allocator of its own, before the mark, so the function names merged into it stay
+ * interned between requests. The rest of the identifiers are interned in the symbol table of the front-end of their file, which is
+ * built per request like the type system and the backend context: they are cheap to build, and the parser adds to them, so they
+ * are built again from the warm memory.
+ * A request which doesn't fit in what is left of the page allocator is turned down with an error reply, the server keeps running.
+ */
+const s64 compile_server_memory_size = RNS_GIGABYTE(2);
+const s64 compile_server_symbol_memory_size = RNS_MEGABYTE(256);
+const s64 compile_server_common_memory_size = RNS_MEGABYTE(100);
+const u32 compile_server_max_input_count = 4096;
+// @Info: room for a suballocator to be aligned, when checking an input fits
+const s64 compile_server_suballocator_alignment = RNS_KILOBYTE(4);
+
+#if defined(_WIN32)
+static inline bool create_pipe(s32 pipe_ends[2])
+{
+    return _pipe(pipe_ends, 64 * 1024, _O_BINARY) == 0;
+}
+
+static inline s32 duplicate_descriptor(s32 descriptor)
+{
+    return _dup(descriptor);
+}
+
+static inline void replace_descriptor(s32 source, s32 destination)
+{
+    _dup2(source, destination);
+}
+
+static inline s64 read_descriptor(s32 descriptor, void* buffer, u32 size)
+{
+    return _read(descriptor, buffer, size);
+}
+
+static inline void close_descriptor(s32 descriptor)
+{
+    _close(descriptor);
+}
+#else
+static inline bool create_pipe(s32 pipe_ends[2])
+{
+    return pipe(pipe_ends) == 0;
+}
+
+static inline s32 duplicate_descriptor(s32 descriptor)
+{
+    return dup(descriptor);
+}
+
+static inline void replace_descriptor(s32 source, s32 destination)
+{
+    dup2(source, destination);
+}
+
+static inline s64 read_descriptor(s32 descriptor, void* buffer, u32 size)
+{
+    return read(descriptor, buffer, size);
+}
+
+static inline void close_descriptor(s32 descriptor)
+{
+    close(descriptor);
+}
+#endif
+
+// @Info: the output is written to a pipe which a thread forwards to the client, so big outputs never block the compilation
+struct OutputCapture
+{
+    LocalSocket* client;
+    s32 saved_stdout;
+    s32 saved_stderr;
+    s32 pipe_read;
+    bool client_gone;
+    Thread forwarder;
+};
+
+static void forward_output(void* argument)
+{
+    auto* capture = static_cast<OutputCapture*>(argument);
+    char buffer[16 * 1024];
+    for (;;)
+    {
+        s64 byte_count = read_descriptor(capture->pipe_read, buffer, sizeof(buffer));
+        if (byte_count <= 0)
+        {
+            break;
+        }
+
+        // @Info: keep draining the pipe after the client went away, or the compilation would block on a full pipe
+        if (!capture->client_gone)
+        {
+            capture->client_gone = !capture->client->send_all(buffer, byte_count);
+        }
+    }
+}
+
+static bool begin_output_capture(OutputCapture* capture, LocalSocket* client)
+{
+    s32 pipe_ends[2];
+    if (!create_pipe(pipe_ends))
+    {
+        return false;
+    }
+
+    fflush(stdout);
+    fflush(stderr);
+    *capture = {
+        .client = client,
+        .saved_stdout = duplicate_descriptor(1),
+        .saved_stderr = duplicate_descriptor(2),
+        .pipe_read = pipe_ends[0],
+    };
+    replace_descriptor(pipe_ends[1], 1);
+    replace_descriptor(pipe_ends[1], 2);
+    close_descriptor(pipe_ends[1]);
+
+    if (!capture->forwarder.start(forward_output, capture))
+    {
+        // @Info: the output would fill the pipe with nobody reading it, so it goes to the console of the server instead
+        replace_descriptor(capture->saved_stdout, 1);
+        replace_descriptor(capture->saved_stderr, 2);
+        close_descriptor(capture->saved_stdout);
+        close_descriptor(capture->saved_stderr);
+        close_descriptor(capture->pipe_read);
+        return false;
+    }
+
+    return true;
+}
+
+static void end_output_capture(OutputCapture* capture)
+{
+    fflush(stdout);
+    fflush(stderr);
+    // @Info: this drops the last references to the write end of the pipe, so the forwarder sees the end of it once it's drained
+    replace_descriptor(capture->saved_stdout, 1);
+    replace_descriptor(capture->saved_stderr, 2);
+    close_descriptor(capture->saved_stdout);
+    close_descriptor(capture->saved_stderr);
+    capture->forwarder.join();
+    close_descriptor(capture->pipe_read);
+}
+
+// @Info: reads the bytes of an input which is dropped, so the client gets to the end of its request and reads the reply
+static bool skip_input(LocalSocket& client, u32 length)
+{
+    char buffer[16 * 1024];
+    while (length)
+    {
+        u32 chunk_length = length < sizeof(buffer) ? length : static_cast<u32>(sizeof(buffer));
+        if (!client.receive_all(buffer, chunk_length))
+        {
+            return false;
+        }
+        length -= chunk_length;
+    }
+
+    return true;
+}
+
+static void send_trailer(LocalSocket& client, s32 exit_code)
+{
+    CompileReplyTrailer trailer = {
+        .magic = compile_protocol_magic,
+        .exit_code = exit_code,
+    };
+    client.send_all(&trailer, sizeof(trailer));
+}
+
+// @Info: returns false once a client asked the server to shut down
+static bool serve_request(Compiler& compiler, u8* page_allocator_end, LocalSocket& client, const CompileOptions& options)
+{
+    CompileRequest request;
+    if (!client.receive_all(&request, sizeof(request)) || request.magic != compile_protocol_magic || request.version != compile_protocol_version || request.input_count > compile_server_max_input_count)
+    {
+        printf("Rejected a malformed compile request\n");
+        return true;
+    }
+
+    if (request.flags & static_cast<u32>(CompileRequestFlag::Shutdown))
+    {
+        send_trailer(client, 0);
+        return false;
+    }
+
+    OutputCapture capture;
+    bool capturing = begin_output_capture(&capture, &client);
+
+    SourceFile* source_files = new(&compiler.common_allocator) SourceFile[request.input_count];
+    RNS::String* sources = new(&compiler.common_allocator) RNS::String[request.input_count];
+    const char** source_names = new(&compiler.common_allocator) const char*[request.input_count];
+    u32 input_count = 0;
+    bool received = true;
+    bool fits = true;
+    bool result = true;
+    for (; input_count < request.input_count; input_count++)
+    {
+        source_files[input_count] = {};
+        CompileInput input;
+        if (!client.receive_all(&input, sizeof(input)))
+        {
+            received = false;
+            break;
+        }
+
+        // @Info: one byte more for the '\0' the lexer relies on, or the one ending the path
+        s64 input_memory_size = static_cast<s64>(input.length) + 64;
+        fits = fits && input_memory_size + compile_server_suballocator_alignment <= page_allocator_end - get_allocator_top(&compiler.page_allocator);
+        // @Info: once the request can't be compiled, the rest of its inputs are still read so the client gets to the reply
+        if (!fits || !result)
+        {
+            if (!skip_input(client, input.length))
+            {
+                received = false;
+                break;
+            }
+            continue;
+        }
+
+        Allocator input_allocator = create_suballocator(&compiler.page_allocator, input_memory_size);
+        char* input_bytes = new(&input_allocator) char[input.length + 1];
+        if (!client.receive_all(input_bytes, input.length))
+        {
+            received = false;
+            break;
+        }
+        input_bytes[input.length] = 0;
+
+        switch (input.kind)
+        {
+            case CompileInputKind::Path:
+                source_files[input_count] = SourceFile::map(input_bytes);
+                sources[input_count] = source_files[input_count].content;
+                source_names[input_count] = input_bytes;
+                break;
+            case CompileInputKind::Source:
+                sources[input_count] = { input_bytes, static_cast<s64>(input.length) };
+                source_names[input_count] = "<source>";
+                break;
+            default:
+                sources[input_count] = {};
+                break;
+        }
+
+        if (!sources[input_count].ptr)
+        {
+            result = false;
+        }
+    }
+
+    if (!received)
+    {
+        printf("Couldn't read the compile request\n");
+        result = false;
+    }
+    else if (!fits)
+    {
+        printf("The sources of the compile request don't fit in the memory of the server\n");
+        result = false;
+    }
+    else if (result)
+    {
+        s64 compile_memory_size = get_compile_memory_size(sources, input_count, options.memory_profile);
+        s64 free_memory_size = page_allocator_end - get_allocator_top(&compiler.page_allocator);
+        if (compile_memory_size > free_memory_size)
+        {
+            printf("Compiling the request takes %" PRId64 " KB, the server only has %" PRId64 " KB left\n", compile_memory_size / 1024, free_memory_size / 1024);
+            result = false;
+        }
+        else
+        {
+            result = compile_sources(compiler, sources, source_names, input_count, options);
+            if (!result)
+            {
+                printf("Compilation failed\n");
+            }
+        }
+    }
+
+    if (capturing)
+    {
+        end_output_capture(&capture);
+    }
+
+    for (u32 i = 0; i < input_count; i++)
+    {
+        if (source_files[i].content.ptr)
+        {
+            source_files[i].unmap();
+        }
+    }
+
+    send_trailer(client, result ? 0 : -1);
+    return true;
+}
+
+s32 run_compile_server(const char* socket_path, const CompileOptions& options)
+{
+    LocalSocket server = LocalSocket::listen(socket_path);
+    if (!server.is_valid())
+    {
+        printf("Couldn't listen on %s\n", socket_path);
+        return -1;
+    }
+
+    Compiler compiler = {
+        .page_allocator = default_create_allocator(compile_server_memory_size),
+        .errors_reported = false,
+    };
+    // @Info: what is left for a request is measured against the end of the page allocator
+    u8* page_allocator_end = get_allocator_top(&compiler.page_allocator) + compile_server_memory_size;
+    Allocator symbol_allocator = create_suballocator(&compiler.page_allocator, compile_server_symbol_memory_size);
+    compiler.symbols = SymbolTable::create(&symbol_allocator, 1024);
+    compiler.common_allocator = create_suballocator(&compiler.page_allocator, compile_server_common_memory_size);
+    Allocator page_allocator_mark = compiler.page_allocator;
+    Allocator common_allocator_mark = compiler.common_allocator;
+
+    printf("Compile server listening on %s\n", socket_path);
+    for (bool running = true; running;)
+    {
+        LocalSocket client = server.accept();
+        if (!client.is_valid())
+        {
+            continue;
+        }
+
+        running = serve_request(compiler, page_allocator_end, client, options);
+        client.close();
+
+        compiler.page_allocator = page_allocator_mark;
+        compiler.common_allocator = common_allocator_mark;
+        compiler.errors_reported = false;
+    }
+
+    server.close();
+    remove(socket_path);
+    default_free_allocator(&compiler.page_allocator);
+    if (options.cache)
+    {
+        options.cache->print_stats();
+    }
+    return 0;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <RNS/types.h>
+
+/* Compile server protocol
+ * A client connects and sends a CompileRequest followed by input_count inputs. Each input is a CompileInput followed by length
+ * bytes: an absolute path for CompileInputKind::Path, or the source itself for CompileInputKind::Source. The server streams back
+ * everything the compilation prints, IR and diagnostics alike, ends the reply with a CompileReplyTrailer and closes the connection.
+ * The trailer can only be told apart once the connection is closed, so clients hold back the last bytes they receive.
+ */
+const u32 compile_protocol_magic = 0x43534E52; // "RNSC"
+const u32 compile_protocol_version = 1;
+
+enum class CompileRequestFlag : u32
+{
+    // @Info: stops the server once it replied
+    Shutdown = 1 << 0,
+};
+
+struct CompileRequest
+{
+    u32 magic;
+    u32 version;
+    u32 flags;
+    u32 input_count;
+};
+
+enum class CompileInputKind : u32
+{
+    Path,
+    Source,
+};
+
+struct CompileInput
+{
+    CompileInputKind kind;
+    u32 length;
+};
+
+struct CompileReplyTrailer
+{
+    u32 magic;
+    s32 exit_code;
+};
+
+struct CompileOptions;
+
+// @Info: keeps the page allocator and the symbol table resident and compiles the requests sent to the socket one after the other,
+// until a client asks it to shut down. Every request is compiled with the same options, and shares the cache if there is one
+s32 run_compile_server(const char* socket_path, const CompileOptions& options);
@@ -1,4 +1,5 @@
 #include "compiler_types.h"
+#include "time_report.h"
 
 #include <stdio.h>
 
@@ -26,75 +27,134 @@ void Compiler::print_error(MetaContext context, const char* message_format, ...)
     fputc('\n', stdout);
 }
 
-Type* Type::get_pointer_type(Type* type, TypeBuffer& type_declarations)
+void Compiler::set_subsystem(Subsystem new_subsystem)
 {
-    RNS_NOT_IMPLEMENTED;
-    return nullptr;
+    if (phase_timer && new_subsystem != subsystem)
+    {
+        phase_timer->end_phase(*this);
+    }
+    subsystem = new_subsystem;
+}
+
+TypeRef Type::get_pointer_type(TypeRef type, TypeBuffer& type_declarations)
+{
+    Type pointer_type = {
+        .id = TypeID::PointerType,
+        .pointer_t = {
+            .appointee = type,
+        },
+    };
+
+    return type_declarations.intern(pointer_type);
 }
-Type* Type::get_label_type(TypeBuffer& type_declarations)
+TypeRef Type::get_label_type(TypeBuffer& type_declarations)
 {
     RNS_NOT_IMPLEMENTED;
-    return nullptr;
+    return no_type;
 }
 
-Type* Type::get_void_type(TypeBuffer& type_declarations)
+TypeRef Type::get_void_type(TypeBuffer& type_declarations)
 {
     RNS_NOT_IMPLEMENTED;
-    return nullptr;
+    return no_type;
 }
 
-TypeBuffer Type::init_type_system(Allocator* allocator)
+struct BuiltinVectorType
+{
+    BuiltinTypeID id;
+    BuiltinTypeID element_type;
+    u32 count;
+};
+
+static const BuiltinVectorType builtin_vector_types[] = {
+    { BuiltinTypeID::V16S8, BuiltinTypeID::S8, 16 },
+    { BuiltinTypeID::V16U8, BuiltinTypeID::U8, 16 },
+    { BuiltinTypeID::V8S16, BuiltinTypeID::S16, 8 },
+    { BuiltinTypeID::V8U16, BuiltinTypeID::U16, 8 },
+    { BuiltinTypeID::V4S32, BuiltinTypeID::S32, 4 },
+    { BuiltinTypeID::V4U32, BuiltinTypeID::U32, 4 },
+    { BuiltinTypeID::V2S64, BuiltinTypeID::S64, 2 },
+    { BuiltinTypeID::V2U64, BuiltinTypeID::U64, 2 },
+    { BuiltinTypeID::V4F32, BuiltinTypeID::F32, 4 },
+    { BuiltinTypeID::V2F64, BuiltinTypeID::F64, 2 },
+    { BuiltinTypeID::V32S8, BuiltinTypeID::S8, 32 },
+    { BuiltinTypeID::V32U8, BuiltinTypeID::U8, 32 },
+    { BuiltinTypeID::V16S16, BuiltinTypeID::S16, 16 },
+    { BuiltinTypeID::V16U16, BuiltinTypeID::U16, 16 },
+    { BuiltinTypeID::V8S32, BuiltinTypeID::S32, 8 },
+    { BuiltinTypeID::V8U32, BuiltinTypeID::U32, 8 },
+    { BuiltinTypeID::V4S64, BuiltinTypeID::S64, 4 },
+    { BuiltinTypeID::V4U64, BuiltinTypeID::U64, 4 },
+    { BuiltinTypeID::V8F32, BuiltinTypeID::F32, 8 },
+    { BuiltinTypeID::V4F64, BuiltinTypeID::F64, 4 },
+};
+static_assert(rns_array_length(builtin_vector_types) == static_cast<u8>(BuiltinTypeID::Count) - static_cast<u8>(BuiltinTypeID::V16S8));
+
+TypeBuffer Type::init_type_system(Allocator* allocator, Arena* arena)
 {
-    TypeBuffer type_declarations = type_declarations.create(allocator, 1024);
-    auto create_base_type = [&](const char* name, TypeID id)
+    TypeBuffer type_declarations = TypeBuffer::create(allocator, type_chunk_size, arena);
+
+    auto create_int_type = [&](u16 bits, bool is_signed)
     {
         Type type = {
-            .id = id,
-            .name = RNS::StringView::create(name, strlen(name)),
+            .id = TypeID::IntegerType,
+            .integer_t = {
+                .bits = bits,
+                .is_signed = is_signed,
+            },
         };
+
         return type;
     };
-    auto create_int_type = [&](const char* name, u16 bits, bool is_signed)
+
+    auto create_float_type = [&](u16 bits)
     {
-        auto type = create_base_type(name, TypeID::IntegerType);
-        type.integer_t = {
-            .bits = bits,
-            .is_signed = is_signed,
+        assert(bits == 32 || bits == 64);
+        Type type = {
+            .id = bits == 32 ? TypeID::FloatType : TypeID::DoubleType,
+            .float_t = {
+                .bits = bits,
+            },
         };
 
         return type;
     };
 
-    auto create_float_type = [&](const char* name, u16 bits)
+    auto builtin_name = [](BuiltinTypeID id)
     {
-        auto type = create_base_type(name, TypeID::IntegerType);
-        RNS_NOT_IMPLEMENTED;
+        const char* name = builtin_type_names[static_cast<u8>(id)];
+        return RNS::StringView::create(name, strlen(name));
     };
 
-    type_declarations.append(create_int_type("bool", 8, false));
-    type_declarations.append(create_int_type("u8",  8, false));
-    type_declarations.append(create_int_type("u16", 16, false));
-    type_declarations.append(create_int_type("u32", 32, false));
-    type_declarations.append(create_int_type("u64", 64, false));
-    type_declarations.append(create_int_type("s8",  8,  true));
-    type_declarations.append(create_int_type("s16", 16, true));
-    type_declarations.append(create_int_type("s32", 32, true));
-    type_declarations.append(create_int_type("s64", 64, true));
-    // @TODO: add fp types
+    type_declarations.append(create_int_type(8, false), builtin_name(BuiltinTypeID::Bool));
+    type_declarations.append(create_int_type(8, false), builtin_name(BuiltinTypeID::U8));
+    type_declarations.append(create_int_type(16, false), builtin_name(BuiltinTypeID::U16));
+    type_declarations.append(create_int_type(32, false), builtin_name(BuiltinTypeID::U32));
+    type_declarations.append(create_int_type(64, false), builtin_name(BuiltinTypeID::U64));
+    type_declarations.append(create_int_type(8, true), builtin_name(BuiltinTypeID::S8));
+    type_declarations.append(create_int_type(16, true), builtin_name(BuiltinTypeID::S16));
+    type_declarations.append(create_int_type(32, true), builtin_name(BuiltinTypeID::S32));
+    type_declarations.append(create_int_type(64, true), builtin_name(BuiltinTypeID::S64));
+    type_declarations.append(create_float_type(32), builtin_name(BuiltinTypeID::F32));
+    type_declarations.append(create_float_type(64), builtin_name(BuiltinTypeID::F64));
+    for (auto& vector_type : builtin_vector_types)
+    {
+        Type type = {
+            .id = TypeID::FixedVectorType,
+            .vector_t = {
+                .type = get_builtin_type(vector_type.element_type),
+                .count = vector_type.count,
+            },
+        };
+        type_declarations.append(type, builtin_name(vector_type.id));
+    }
+    assert(type_declarations.entries.len == get_builtin_type(BuiltinTypeID::Count));
 
     return type_declarations;
 }
 
-Type* Type::get_array_type(Type* elem_type, s64 elem_count, TypeBuffer& type_declarations)
+TypeRef Type::get_array_type(TypeRef elem_type, s64 elem_count, TypeBuffer& type_declarations)
 {
-    for (auto& type : type_declarations)
-    {
-        if (type.id == TypeID::ArrayType && (u64)type.array_t.type == (u64)elem_type && type.array_t.count == elem_count)
-        {
-            return &type;
-        }
-    }
-
     Type type = {
         .id = TypeID::ArrayType,
         .array_t = {
@@ -103,20 +163,517 @@ Type* Type::get_array_type(Type* elem_type, s64 elem_count, TypeBuffer& type_dec
         },
     };
 
-    auto* result = type_declarations.append(type);
+    return type_declarations.intern(type);
+}
+
+TypeRef Type::get_integer_type(u16 bits, bool signedness, TypeBuffer& type_declarations)
+{
+    Type type = {
+        .id = TypeID::IntegerType,
+        .integer_t = {
+            .bits = bits,
+            .is_signed = signedness,
+        },
+    };
+
+    // @Info: the builtin integers are the only ones the language has
+    if (TypeRef result = type_declarations.find(type))
+    {
+        return result;
+    }
+
+    RNS_NOT_IMPLEMENTED;
+    return no_type;
+}
+
+TypeRef Type::get_float_type(u16 bits, TypeBuffer& type_declarations)
+{
+    switch (bits)
+    {
+        case 32:
+            return get_builtin_type(BuiltinTypeID::F32);
+        case 64:
+            return get_builtin_type(BuiltinTypeID::F64);
+        default:
+            RNS_NOT_IMPLEMENTED;
+            return no_type;
+    }
+}
+
+TypeRef Type::declare_struct_type(RNS::StringView name, TypeBuffer& type_declarations)
+{
+    Type type = {
+        .id = TypeID::StructType,
+    };
+
+    return type_declarations.append(type, name);
+}
+
+void Type::define_struct_type(TypeRef declared_type, StructType struct_type, TypeBuffer& type_declarations)
+{
+    s64 field_count = struct_type.field_count;
+    auto* field_names = struct_type.field_names;
+    auto* field_types = struct_type.field_types;
+
+    if (!struct_type.declaration_order)
+    {
+        // @Info: structs have a handful of fields, and an insertion sort keeps fields of the same alignment in declaration order
+        for (s64 i = 1; i < field_count; i++)
+        {
+            SymbolID field_name = field_names[i];
+            TypeRef field_type = field_types[i];
+            u32 alignment = type_declarations.get_layout(field_type).alignment;
+            s64 j = i;
+            for (; j > 0 && type_declarations.get_layout(field_types[j - 1]).alignment < alignment; j--)
+            {
+                field_names[j] = field_names[j - 1];
+                field_types[j] = field_types[j - 1];
+            }
+            field_names[j] = field_name;
+            field_types[j] = field_type;
+        }
+    }
+
+    if (type_declarations.arena)
+    {
+        type_declarations.arena->reserve(field_count * sizeof(s64));
+    }
+    struct_type.field_offsets = new(type_declarations.allocator) s64[field_count];
+    s64 offset = 0;
+    for (s64 i = 0; i < field_count; i++)
+    {
+        TypeLayout field_layout = type_declarations.get_layout(field_types[i]);
+        offset = (offset + field_layout.alignment - 1) & ~static_cast<s64>(field_layout.alignment - 1);
+        struct_type.field_offsets[i] = offset;
+        offset += field_layout.size;
+    }
+
+    Type type = {
+        .id = TypeID::StructType,
+        .struct_t = struct_type,
+    };
+
+    type_declarations.set(declared_type, type);
+}
+
+// @Info: the kinds of types which are the same type whenever they have the same structure. The others are told apart by name
+static bool is_structural_type(TypeID id)
+{
+    switch (id)
+    {
+        case TypeID::IntegerType:
+        case TypeID::FloatType:
+        case TypeID::DoubleType:
+        case TypeID::ArrayType:
+        case TypeID::PointerType:
+        case TypeID::FixedVectorType:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static u32 hash_type(Type& type)
+{
+    u64 kind_key = static_cast<u64>(type.id);
+    u64 field_key = 0;
+    switch (type.id)
+    {
+        case TypeID::IntegerType:
+            field_key = type.integer_t.bits | (static_cast<u64>(type.integer_t.is_signed) << 16);
+            break;
+        case TypeID::FloatType:
+        case TypeID::DoubleType:
+            field_key = type.float_t.bits;
+            break;
+        case TypeID::ArrayType:
+            kind_key ^= static_cast<u64>(type.array_t.count) << 8;
+            field_key = type.array_t.type;
+            break;
+        case TypeID::PointerType:
+            field_key = type.pointer_t.appointee;
+            break;
+        case TypeID::FixedVectorType:
+            kind_key ^= static_cast<u64>(type.vector_t.count) << 8;
+            field_key = type.vector_t.type;
+            break;
+        default:
+            RNS_UNREACHABLE;
+            break;
+    }
+
+    u64 hash = (kind_key * 0x9E3779B97F4A7C15ull) ^ field_key;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 32;
+    hash *= 0xC4CEB9FE1A85EC53ull;
+    hash ^= hash >> 29;
+
+    return static_cast<u32>(hash);
+}
+
+static bool is_same_type(Type& a, Type& b)
+{
+    if (a.id != b.id)
+    {
+        return false;
+    }
+
+    switch (a.id)
+    {
+        case TypeID::IntegerType:
+            return a.integer_t.bits == b.integer_t.bits && a.integer_t.is_signed == b.integer_t.is_signed;
+        case TypeID::FloatType:
+        case TypeID::DoubleType:
+            return a.float_t.bits == b.float_t.bits;
+        case TypeID::ArrayType:
+            return a.array_t.type == b.array_t.type && a.array_t.count == b.array_t.count;
+        case TypeID::PointerType:
+            return a.pointer_t.appointee == b.pointer_t.appointee;
+        case TypeID::FixedVectorType:
+            return a.vector_t.type == b.vector_t.type && a.vector_t.count == b.vector_t.count;
+        default:
+            RNS_UNREACHABLE;
+            return false;
+    }
+}
+
+// @Info: the types a type is made of are always added before it, so their layouts are already there. The exception is a struct
+// whose fields point to it, but a pointer doesn't need the layout of its appointee
+static TypeLayout get_type_layout(TypeBuffer& type_declarations, Type& type)
+{
+    switch (type.id)
+    {
+        case TypeID::IntegerType:
+        {
+            u32 size = type.integer_t.bits / 8;
+            return { .size = size, .alignment = size };
+        }
+        case TypeID::FloatType:
+        case TypeID::DoubleType:
+        {
+            u32 size = type.float_t.bits / 8;
+            return { .size = size, .alignment = size };
+        }
+        case TypeID::ArrayType:
+        {
+            TypeLayout element_layout = type_declarations.get_layout(type.array_t.type);
+            return { .size = element_layout.size * type.array_t.count, .alignment = element_layout.alignment };
+        }
+        case TypeID::PointerType:
+            return { .size = sizeof(void*), .alignment = alignof(void*) };
+        case TypeID::FixedVectorType:
+        {
+            // @Info: vectors are aligned to their size, which aligned vector loads and stores need
+            s64 size = type_declarations.get_layout(type.vector_t.type).size * type.vector_t.count;
+            return { .size = size, .alignment = static_cast<u32>(size) };
+        }
+        case TypeID::StructType:
+        {
+            // @Info: the field offsets are worked out by get_struct_type, what is left is the padding at the end
+            auto& struct_type = type.struct_t;
+            TypeLayout layout = { .size = 0, .alignment = struct_type.cache_line_aligned ? cache_line_size : 1 };
+            for (s64 i = 0; i < struct_type.field_count; i++)
+            {
+                TypeLayout field_layout = type_declarations.get_layout(struct_type.field_types[i]);
+                layout.alignment = field_layout.alignment > layout.alignment ? field_layout.alignment : layout.alignment;
+                s64 field_end = struct_type.field_offsets[i] + field_layout.size;
+                layout.size = field_end > layout.size ? field_end : layout.size;
+            }
+            layout.size = (layout.size + layout.alignment - 1) & ~static_cast<s64>(layout.alignment - 1);
+            return layout;
+        }
+        default:
+            return { .size = 0, .alignment = 1 };
+    }
+}
+
+static TypeRef* create_slots(Allocator* allocator, u32 slot_count)
+{
+    TypeRef* slots = new(allocator) TypeRef[slot_count];
+    memset(slots, 0, slot_count * sizeof(TypeRef));
+    return slots;
+}
+
+TypeBuffer TypeBuffer::create(Allocator* allocator, s64 capacity, Arena* arena)
+{
+    assert(capacity > 0);
+    u32 slot_count = 2;
+    while (slot_count < 2 * capacity)
+    {
+        slot_count <<= 1;
+    }
+
+    TypeBuffer type_buffer = {
+        .entries = ChunkedBuffer<TypeEntry, type_chunk_size>::create(allocator, arena),
+        .type_slots = create_slots(allocator, slot_count),
+        .type_slot_mask = slot_count - 1,
+        .name_slots = create_slots(allocator, slot_count),
+        .name_slot_mask = slot_count - 1,
+        .named_type_count = 0,
+        .allocator = allocator,
+        .arena = arena,
+    };
+    // @Info: entry 0, zeroed, backs no_type
+    type_buffer.entries.append();
+
+    return type_buffer;
+}
+
+// @Info: the slot holding an equal type, or the empty slot where it goes
+u32 TypeBuffer::find_slot(Type& type, u32 hash)
+{
+    u32 slot = hash & type_slot_mask;
+    for (; type_slots[slot]; slot = (slot + 1) & type_slot_mask)
+    {
+        if (is_same_type((*this)[type_slots[slot]], type))
+        {
+            break;
+        }
+    }
+
+    return slot;
+}
+
+void TypeBuffer::grow_type_slots()
+{
+    u32 slot_count = (type_slot_mask + 1) * 2;
+    if (arena)
+    {
+        arena->reserve(slot_count * sizeof(TypeRef));
+    }
+    type_slots = create_slots(allocator, slot_count);
+    type_slot_mask = slot_count - 1;
+
+    for (TypeRef type_ref = 1; type_ref < entries.len; type_ref++)
+    {
+        Type& type = (*this)[type_ref];
+        if (is_structural_type(type.id))
+        {
+            u32 slot = find_slot(type, hash_type(type));
+            // @Info: of two equal types only the first one was indexed, the builtin bool before u8
+            if (!type_slots[slot])
+            {
+                type_slots[slot] = type_ref;
+            }
+        }
+    }
+}
+
+void TypeBuffer::grow_name_slots()
+{
+    u32 slot_count = (name_slot_mask + 1) * 2;
+    if (arena)
+    {
+        arena->reserve(slot_count * sizeof(TypeRef));
+    }
+    name_slots = create_slots(allocator, slot_count);
+    name_slot_mask = slot_count - 1;
+
+    for (TypeRef type_ref = 1; type_ref < entries.len; type_ref++)
+    {
+        RNS::StringView name = get_name(type_ref);
+        if (name.len)
+        {
+            u32 slot = hash_string(name.get(), name.len) & name_slot_mask;
+            for (; name_slots[slot]; slot = (slot + 1) & name_slot_mask);
+            name_slots[slot] = type_ref;
+        }
+    }
+}
+
+TypeRef TypeBuffer::append(Type type, RNS::StringView name)
+{
+    bool is_structural = is_structural_type(type.id);
+    if (is_structural && 2 * static_cast<u64>(entries.len + 1) > type_slot_mask + 1)
+    {
+        grow_type_slots();
+    }
+    if (name.len && 2 * static_cast<u64>(named_type_count + 1) > name_slot_mask + 1)
+    {
+        grow_name_slots();
+    }
+
+    assert(entries.len < UINT32_MAX);
+    TypeRef result = static_cast<TypeRef>(entries.append());
+    get_entry(result) = {
+        .type = type,
+        .name = name,
+        .layout = get_type_layout(*this, type),
+    };
+
+    if (is_structural)
+    {
+        u32 slot = find_slot(type, hash_type(type));
+        if (!type_slots[slot])
+        {
+            type_slots[slot] = result;
+        }
+    }
+
+    if (name.len)
+    {
+        u32 slot = hash_string(name.get(), name.len) & name_slot_mask;
+        for (; name_slots[slot]; slot = (slot + 1) & name_slot_mask);
+        name_slots[slot] = result;
+        named_type_count++;
+    }
+
     return result;
 }
 
-Type* Type::get_integer_type(u16 bits, bool signedness, TypeBuffer& type_declarations)
+void TypeBuffer::set(TypeRef type_ref, Type type)
+{
+    assert(!is_structural_type(type.id) && (*this)[type_ref].id == type.id);
+    auto& entry = get_entry(type_ref);
+    entry.type = type;
+    entry.layout = get_type_layout(*this, type);
+}
+
+TypeRef TypeBuffer::find(Type type)
 {
-    for (auto& type : type_declarations)
+    assert(is_structural_type(type.id));
+    return type_slots[find_slot(type, hash_type(type))];
+}
+
+TypeRef TypeBuffer::intern(Type type)
+{
+    if (TypeRef existing_type = find(type))
+    {
+        return existing_type;
+    }
+
+    return append(type);
+}
+
+TypeRef TypeBuffer::find_by_name(RNS::StringView name)
+{
+    for (u32 slot = hash_string(name.get(), name.len) & name_slot_mask; name_slots[slot]; slot = (slot + 1) & name_slot_mask)
     {
-        if (type.id == TypeID::IntegerType && type.integer_t.bits == bits && type.integer_t.is_signed == signedness)
+        if (get_name(name_slots[slot]).equal(name))
         {
-            return &type;
+            return name_slots[slot];
         }
     }
 
-    RNS_NOT_IMPLEMENTED;
-    return nullptr;
+    return no_type;
+}
+
+SymbolTable SymbolTable::create(Allocator* allocator, s64 capacity, Arena* arena)
+{
+    assert(capacity > 0);
+    s64 slot_count = 2;
+    while (slot_count < 2 * capacity)
+    {
+        slot_count <<= 1;
+    }
+
+    SymbolTable symbol_table = {
+        .symbols = new(allocator) Symbol[capacity],
+        // @Info: slot 0 of the array backs no_symbol
+        .len = 1,
+        .cap = capacity,
+        .slots = new(allocator) SymbolID[slot_count],
+        .slot_mask = static_cast<u32>(slot_count - 1),
+        .allocator = allocator,
+        .arena = arena,
+        .allocated_size = capacity * static_cast<s64>(sizeof(Symbol)) + slot_count * static_cast<s64>(sizeof(SymbolID)),
+    };
+    symbol_table.symbols[no_symbol] = {};
+    memset(symbol_table.slots, 0, slot_count * sizeof(SymbolID));
+
+    return symbol_table;
+}
+
+SymbolID SymbolTable::intern(const char* name, s64 name_len, u32 hash)
+{
+    u32 slot = hash & slot_mask;
+    for (; slots[slot]; slot = (slot + 1) & slot_mask)
+    {
+        Symbol& symbol = symbols[slots[slot]];
+        if (symbol.hash == hash && symbol.name.len == name_len && memcmp(symbol.name.get(), name, name_len) == 0)
+        {
+            return slots[slot];
+        }
+    }
+
+    // @Info: the slot array is always at least twice the symbol capacity, so growing with the array keeps the load factor under 0.5
+    if (len == cap)
+    {
+        grow();
+        for (slot = hash & slot_mask; slots[slot]; slot = (slot + 1) & slot_mask);
+    }
+
+    // @Info: names are copied into chunks that never move, so views handed out by get_name stay valid while the table grows
+    if (name_chunk_len + name_len + 1 > name_chunk_cap)
+    {
+        name_chunk_cap = name_len + 1 > symbol_name_chunk_size ? name_len + 1 : symbol_name_chunk_size;
+        if (arena)
+        {
+            arena->reserve(name_chunk_cap);
+        }
+        name_chunk = new(allocator) char[name_chunk_cap];
+        name_chunk_len = 0;
+        allocated_size += name_chunk_cap;
+    }
+    char* name_copy = &name_chunk[name_chunk_len];
+    memcpy(name_copy, name, name_len);
+    name_copy[name_len] = 0;
+    name_chunk_len += name_len + 1;
+
+    SymbolID id = static_cast<SymbolID>(len++);
+    symbols[id] = {
+        .name = RNS::StringView::create(name_copy, name_len),
+        .hash = hash,
+    };
+    slots[slot] = id;
+
+    return id;
+}
+
+// @Info: the names already copied stay in their chunks, only the last chunk is reused
+void SymbolTable::clear()
+{
+    len = 1;
+    name_chunk_len = 0;
+    memset(slots, 0, (static_cast<s64>(slot_mask) + 1) * sizeof(SymbolID));
+}
+
+void SymbolTable::grow()
+{
+    s64 new_cap = cap * 2;
+    if (arena)
+    {
+        // @Info: the slots are at least twice the symbols, and at most four times when they were already bigger
+        arena->reserve(new_cap * static_cast<s64>(sizeof(Symbol) + 4 * sizeof(SymbolID)));
+    }
+    Symbol* new_symbols = new(allocator) Symbol[new_cap];
+    memcpy(new_symbols, symbols, len * sizeof(Symbol));
+    symbols = new_symbols;
+    cap = new_cap;
+
+    u32 slot_count = (slot_mask + 1) * 2;
+    while (slot_count < 2 * cap)
+    {
+        slot_count <<= 1;
+    }
+    slots = new(allocator) SymbolID[slot_count];
+    memset(slots, 0, slot_count * sizeof(SymbolID));
+    slot_mask = slot_count - 1;
+    allocated_size += new_cap * static_cast<s64>(sizeof(Symbol)) + slot_count * static_cast<s64>(sizeof(SymbolID));
+
+    for (SymbolID id = 1; id < len; id++)
+    {
+        u32 slot = symbols[id].hash & slot_mask;
+        for (; slots[slot]; slot = (slot + 1) & slot_mask);
+        slots[slot] = id;
+    }
+}
+
+AST::NodeBuffer AST::NodeBuffer::create(Allocator* allocator, Arena* arena)
+{
+    NodeBuffer node_buffer = {
+        .nodes = ChunkedBuffer<Node, node_chunk_size>::create(allocator, arena),
+    };
+
+    return node_buffer;
 }
@@ -3,12 +3,97 @@
 #include <RNS/types.h>
 #include <RNS/data_structures.h>
 #include <RNS/os.h>
+#include <string.h>
+
+#include "arena.h"
 
 using RNS::Allocator;
 
 extern "C" s32 printf(const char*, ...);
+struct PhaseTimer;
 namespace User
 {
+    inline u32 hash_string(const char* ptr, s64 len)
+    {
+        u64 hash = 0x9E3779B97F4A7C15ull ^ static_cast<u64>(len);
+        s64 i = 0;
+        for (; i + 8 <= len; i += 8)
+        {
+            u64 word;
+            memcpy(&word, ptr + i, sizeof(word));
+            hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+            hash ^= hash >> 32;
+        }
+
+        u64 tail = 0;
+        for (u32 shift = 0; i < len; i++, shift += 8)
+        {
+            tail |= static_cast<u64>(static_cast<u8>(ptr[i])) << shift;
+        }
+        hash = (hash ^ tail) * 0xC4CEB9FE1A85EC53ull;
+        hash ^= hash >> 29;
+
+        return static_cast<u32>(hash);
+    }
+
+    using SymbolID = u32;
+    // @Info: symbol 0 is reserved, so a zeroed name never matches an interned one
+    const SymbolID no_symbol = 0;
+
+    struct Symbol
+    {
+        RNS::StringView name;
+        u32 hash;
+    };
+
+    // @Info: names are copied into chunks of this size, bigger names get a chunk of their own
+    const s64 symbol_name_chunk_size = 64 * 1024;
+
+    // @Info: every distinct identifier is stored once and named by a dense id, so comparing names is comparing integers
+    struct SymbolTable
+    {
+        Symbol* symbols;
+        s64 len;
+        s64 cap;
+        SymbolID* slots; // 0 is an empty slot
+        u32 slot_mask;
+        char* name_chunk;
+        s64 name_chunk_len;
+        s64 name_chunk_cap;
+        Allocator* allocator;
+        // @Info: the arena of the allocator, reserved in before growing. Null when the allocator can't grow
+        Arena* arena;
+        // @Info: bytes taken from the allocator so far, including the arrays left behind when growing
+        s64 allocated_size;
+
+        static SymbolTable create(Allocator* allocator, s64 capacity, Arena* arena = nullptr);
+        SymbolID intern(const char* name, s64 len, u32 hash);
+        void clear();
+
+        inline SymbolID intern(const char* name, s64 len)
+        {
+            return intern(name, len, hash_string(name, len));
+        }
+
+        inline RNS::StringView get_name(SymbolID id)
+        {
+            assert(id != no_symbol && id < len);
+            return symbols[id].name;
+        }
+
+    private:
+        void grow();
+    };
+
+    // @Info: the most a table created with a smaller capacity takes to hold that many symbols, with names of that many bytes in total.
+    // Its arrays end up at most twice the symbol count, four times in slots, and the ones left behind by growing add up to less than
+    // the last ones. Every name chunk wastes less than the name which didn't fit in it
+    inline s64 get_symbol_table_memory_size(s64 symbol_count, s64 names_size)
+    {
+        s64 arrays_size = 2 * 2 * symbol_count * static_cast<s64>(sizeof(Symbol) + 4 * sizeof(SymbolID));
+        return arrays_size + 2 * (names_size + symbol_count) + symbol_name_chunk_size;
+    }
+
     struct MetaContext
     {
         const char* filename;
@@ -30,10 +115,17 @@ namespace User
 
         RNS::Allocator page_allocator;
         RNS::Allocator common_allocator;
+        // @Info: the arena watching the common allocator, null when it can't grow
+        Arena* common_arena;
+        SymbolTable symbols;
         Subsystem subsystem;
         u32 errors_reported;
+        // @Info: only set when the phases are being timed
+        PhaseTimer* phase_timer;
 
         void print_error(MetaContext context, const char* message, ...);
+        // @Info: subsystems change through here, so the time spent in each one can be told apart
+        void set_subsystem(Subsystem new_subsystem);
     };
 
     enum class UnaryOp
@@ -142,11 +234,99 @@ namespace User
     };
 
     struct Type;
-    using TypeBuffer = RNS::Buffer<Type>;
+    struct TypeBuffer;
 
-    struct FloatType
+    // @Info: dense handle of a type in the type table of its compiler. The table hash-conses its types, so two handles of the same
+    // table are equal exactly when their types are
+    using TypeRef = u32;
+    // @Info: handle 0 is reserved, so a zeroed handle never names a type
+    const TypeRef no_type = 0;
+
+    // @Info: the builtin types are the first entries of the type declarations, right after no_type, in this order
+    enum class BuiltinTypeID : u8
+    {
+        Bool,
+        U8,
+        U16,
+        U32,
+        U64,
+        S8,
+        S16,
+        S32,
+        S64,
+        F32,
+        F64,
+        // @Info: 128-bit vectors
+        V16S8,
+        V16U8,
+        V8S16,
+        V8U16,
+        V4S32,
+        V4U32,
+        V2S64,
+        V2U64,
+        V4F32,
+        V2F64,
+        // @Info: 256-bit vectors
+        V32S8,
+        V32U8,
+        V16S16,
+        V16U16,
+        V8S32,
+        V8U32,
+        V4S64,
+        V4U64,
+        V8F32,
+        V4F64,
+        Count,
+    };
+
+    inline constexpr const char* builtin_type_names[] =
+    {
+        "bool",
+        "u8",
+        "u16",
+        "u32",
+        "u64",
+        "s8",
+        "s16",
+        "s32",
+        "s64",
+        "f32",
+        "f64",
+        "v16s8",
+        "v16u8",
+        "v8s16",
+        "v8u16",
+        "v4s32",
+        "v4u32",
+        "v2s64",
+        "v2u64",
+        "v4f32",
+        "v2f64",
+        "v32s8",
+        "v32u8",
+        "v16s16",
+        "v16u16",
+        "v8s32",
+        "v8u32",
+        "v4s64",
+        "v4u64",
+        "v8f32",
+        "v4f64",
+    };
+
+    static_assert(static_cast<u8>(BuiltinTypeID::Count) == rns_array_length(builtin_type_names));
+
+    inline TypeRef get_builtin_type(BuiltinTypeID id)
     {
+        return static_cast<TypeRef>(id) + 1;
+    }
 
+    // @Info: f32 is a TypeID::FloatType and f64 a TypeID::DoubleType, bits is kept so both can be handled together
+    struct FloatType
+    {
+        u16 bits;
     };
 
     struct DoubleType
@@ -159,15 +339,26 @@ namespace User
         bool is_signed;
     };
 
+    // @Info: field names are symbols of the file which declares the type
     struct DataStructureType
     {
-        s64 arg_count;
-        RNS::String* field_names;
-        Type* field_types;
+        s64 field_count;
+        SymbolID* field_names;
+        TypeRef* field_types;
     };
 
+    /* Struct layout
+     * Unless the struct asks for its declaration order, its fields are reordered by decreasing alignment. Sizes being multiples of
+     * alignments, a field then always starts where the previous one ends, so the only padding left is at the end of the struct.
+     * Once laid out the fields are kept in memory order, which is the order the backend lowers them in and the one their index
+     * refers to. A struct aligned to the cache line starts on one and is padded to a whole number of them, so two of them never
+     * share a line.
+     */
     struct StructType : public DataStructureType
     {
+        s64* field_offsets;
+        bool declaration_order;
+        bool cache_line_aligned;
     };
 
     struct UnionType : public DataStructureType
@@ -180,46 +371,210 @@ namespace User
 
     struct ArrayType
     {
-        Type* type;
+        TypeRef type;
         s64 count;
     };
 
-    using TypeRefBuffer = RNS::Buffer<Type*>;
+    /* Vector types
+     * The builtin vectors are TypeID::FixedVectorType values of 128 or 256 bits with integer or float lanes, lowered to LLVM vectors.
+     * Arithmetic and comparisons work lane by lane, and a scalar used where a vector is expected is splat to every lane first.
+     * Comparisons give a vector of the same type with every bit of a lane set where the comparison holds, as SIMD instruction
+     * sets do, so the result can be used as a mask. Lanes are read and written with a subscript.
+     */
+    struct VectorType
+    {
+        TypeRef type;
+        u32 count;
+    };
+
+    using TypeRefBuffer = RNS::Buffer<TypeRef>;
 
     struct FunctionType
     {
         TypeRefBuffer arg_types;
-        Type* ret_type;
+        TypeRef ret_type;
     };
 
     struct PointerType
     {
-        Type* appointee;
+        TypeRef appointee;
         // @TODO: come back here if we want to diminish pointers memory footprint
         // u16 bits;
     };
 
+    // @Info: the name of a type is kept by the type table, so that function type expressions in the nodes stay small
     struct Type
     {
         TypeID id;
-        RNS::StringView name;
         union
         {
             IntegerType integer_t;
+            FloatType float_t;
             StructType struct_t;
             UnionType union_t;
             EnumType enum_t;
             FunctionType function_t;
             PointerType pointer_t;
             ArrayType array_t;
+            VectorType vector_t;
         };
 
-        static Type* get_void_type(TypeBuffer& type_declarations);
-        static Type* get_label_type(TypeBuffer& type_declarations);
-        static Type* get_integer_type(u16 bits, bool signedness, TypeBuffer& type_declarations);
-        static Type* get_pointer_type(Type* type, TypeBuffer& type_declarations);
-        static Type* get_array_type(Type* type, s64 count, TypeBuffer& type_declarations);
-        static TypeBuffer init_type_system(Allocator* allocator);
+        static TypeRef get_void_type(TypeBuffer& type_declarations);
+        static TypeRef get_label_type(TypeBuffer& type_declarations);
+        static TypeRef get_integer_type(u16 bits, bool signedness, TypeBuffer& type_declarations);
+        static TypeRef get_float_type(u16 bits, TypeBuffer& type_declarations);
+        static TypeRef get_pointer_type(TypeRef type, TypeBuffer& type_declarations);
+        static TypeRef get_array_type(TypeRef type, s64 count, TypeBuffer& type_declarations);
+        // @Info: adds a struct with that name and no fields yet, so that its own fields can point to it
+        static TypeRef declare_struct_type(RNS::StringView name, TypeBuffer& type_declarations);
+        // @Info: lays out the fields, reordering the arrays of the struct in place, and fills in the declared struct with them
+        static void define_struct_type(TypeRef declared_type, StructType struct_type, TypeBuffer& type_declarations);
+        static TypeBuffer init_type_system(Allocator* allocator, Arena* arena = nullptr);
+    };
+
+    const u32 cache_line_size = 64;
+
+    /* Chunked buffer
+     * Elements in chunks of chunk_size which never move, so a reference to one stays valid while the buffer grows. Appending takes
+     * the next element of the last chunk, and only once every chunk_size elements a new chunk, zeroed, is taken from the allocator.
+     * The chunk array is the only thing copied when growing, and it doubles.
+     */
+    template<typename T, s64 chunk_size>
+    struct ChunkedBuffer
+    {
+        T** chunks;
+        s64 chunk_count;
+        s64 chunk_cap;
+        s64 len;
+        Allocator* allocator;
+        // @Info: null when the allocator can't grow
+        Arena* arena;
+
+        static ChunkedBuffer create(Allocator* allocator, Arena* arena)
+        {
+            const s64 initial_chunk_cap = 16;
+            ChunkedBuffer buffer = {
+                .chunks = new(allocator) T*[initial_chunk_cap],
+                .chunk_count = 0,
+                .chunk_cap = initial_chunk_cap,
+                .len = 0,
+                .allocator = allocator,
+                .arena = arena,
+            };
+
+            return buffer;
+        }
+
+        // @Info: returns the index of the new element, which is zeroed
+        inline s64 append()
+        {
+            if (len == chunk_count * chunk_size)
+            {
+                add_chunk();
+            }
+            return len++;
+        }
+
+        inline T& operator[](s64 index)
+        {
+            assert(index >= 0 && index < len);
+            return chunks[index / chunk_size][index % chunk_size];
+        }
+
+    private:
+        void add_chunk()
+        {
+            if (arena)
+            {
+                arena->reserve(chunk_size * sizeof(T) + 2 * chunk_cap * sizeof(T*));
+            }
+            if (chunk_count == chunk_cap)
+            {
+                T** new_chunks = new(allocator) T*[chunk_cap * 2];
+                memcpy(new_chunks, chunks, chunk_count * sizeof(T*));
+                chunks = new_chunks;
+                chunk_cap *= 2;
+            }
+
+            T* chunk = new(allocator) T[chunk_size];
+            memset(chunk, 0, chunk_size * sizeof(T));
+            chunks[chunk_count++] = chunk;
+        }
+    };
+
+    // @Info: types per chunk of the type table, a power of two so a handle splits into a chunk and a position with a shift and a mask
+    const s64 type_chunk_size = 256;
+
+    // @Info: size and alignment in bytes of a value of the type, worked out once when the type is added
+    struct TypeLayout
+    {
+        s64 size;
+        u32 alignment;
+    };
+
+    struct TypeEntry
+    {
+        Type type;
+        RNS::StringView name;
+        TypeLayout layout;
+    };
+
+    /* Type table
+     * Every type is stored once and hash-consed: intern looks a type up by its structure (the kind, then the bits and signedness of
+     * an integer, the bits of a float, the element type and count of an array or the appointee of a pointer) and only adds it if it
+     * isn't there yet. Two equal types therefore get the same TypeRef, and comparing types is comparing integers. Named types are
+     * indexed by name as well, for the lexer.
+     * Types live in a chunked buffer, so references to them stay valid while the table grows. Both indices are open
+     * addressing tables of handles, rebuilt twice as big whenever they would go over a load factor of 0.5.
+     */
+    struct TypeBuffer
+    {
+        ChunkedBuffer<TypeEntry, type_chunk_size> entries;
+        TypeRef* type_slots; // no_type is an empty slot
+        u32 type_slot_mask;
+        TypeRef* name_slots;
+        u32 name_slot_mask;
+        s64 named_type_count;
+        Allocator* allocator;
+        // @Info: null when the allocator can't grow
+        Arena* arena;
+
+        static TypeBuffer create(Allocator* allocator, s64 capacity, Arena* arena = nullptr);
+        // @Info: adds the type without looking for an equal one first, which the builtin types need: bool and u8 have the same
+        // structure, and the first one added keeps the structural slot
+        TypeRef append(Type type, RNS::StringView name = {});
+        // @Info: returns the type of the table with the same structure, adding it if there is none
+        TypeRef intern(Type type);
+        // @Info: replaces a type which isn't indexed by structure, a declared struct, and works its layout out again
+        void set(TypeRef type_ref, Type type);
+        TypeRef find(Type type);
+        TypeRef find_by_name(RNS::StringView name);
+
+        inline TypeEntry& get_entry(TypeRef type)
+        {
+            assert(type != no_type);
+            return entries[type];
+        }
+
+        inline Type& operator[](TypeRef type)
+        {
+            return get_entry(type).type;
+        }
+
+        inline RNS::StringView get_name(TypeRef type)
+        {
+            return get_entry(type).name;
+        }
+
+        inline TypeLayout get_layout(TypeRef type)
+        {
+            return get_entry(type).layout;
+        }
+
+    private:
+        u32 find_slot(Type& type, u32 hash);
+        void grow_type_slots();
+        void grow_name_slots();
     };
 }
 
@@ -234,6 +589,16 @@ struct ConstantInt
 };
 static_assert(sizeof(ConstantInt) == 2 * sizeof(s64));
 
+struct ConstantFloat
+{
+    f64 lit;
+    // @Info: where the literal is in the source, to decode it again once its type is known
+    u32 source_start;
+    u16 source_len;
+    u16 bit_count;
+};
+static_assert(sizeof(ConstantFloat) == 2 * sizeof(s64));
+
 namespace Lexer
 {
     enum class TokenID : u8
@@ -356,6 +721,7 @@ namespace Lexer
         While,
         Break,
         Continue,
+        Struct,
         Count,
     };
 
@@ -365,7 +731,7 @@ namespace Lexer
         Foo,
     };
 
-    struct Token
+    struct TokenValue
     {
         union
         {
@@ -373,15 +739,19 @@ namespace Lexer
             f64 float_lit;
             char char_lit;
             char* str_lit;
-            char* symbol;
+            SymbolID symbol;
             KeywordID keyword;
-            Type* type;
+            TypeRef type;
             IntrinsicID intrinsic;
         };
+    };
 
+    static_assert(sizeof(TokenValue) == sizeof(u64));
+
+    // @Info: tokens are stored as a structure of arrays in LexerResult. This is the view of a single token the parser works with
+    struct Token : public TokenValue
+    {
         u64 start;
-        u32 line;
-        u32 column;
         u32 offset;
 
         TokenID id;
@@ -428,12 +798,63 @@ namespace Lexer
         }
     };
 
-    static_assert(sizeof(Token) == 4 * (sizeof(u64)));
+    /* Structure-of-arrays token stream
+     * The token ids are kept in their own byte array, so scanning ahead only touches one byte per token. The payloads and the source
+     * positions, which are needed far less often, live in parallel arrays indexed by the token index.
+     */
+    // @Info: zero-based
+    struct SourceLocation
+    {
+        u32 line;
+        u32 column;
+    };
+
+    // @Info: offsets where each line starts, built lazily with a vectorized scan for newlines. Lines and columns are recovered
+    // from a byte offset with a binary search, so the lexer doesn't have to track them
+    struct LineIndex
+    {
+        const char* file;
+        s64 file_size;
+        Allocator* allocator;
+        // @Info: null when the allocator can't grow
+        Arena* arena;
+        u32* line_starts;
+        s64 line_count;
+
+        static LineIndex create(Allocator* allocator, RNS::String file, Arena* arena = nullptr);
+        SourceLocation get_location(u32 offset);
+
+    private:
+        void build();
+    };
 
     struct LexerResult
     {
-        Token* ptr;
+        TokenID* ids;
+        TokenValue* values;
+        u32* starts;
+        u32* lengths;
         s64 len;
+        // @Info: tokens the arrays have room for
+        s64 cap;
+        // @Info: bytes allocated for the tokens and string literals, the symbol table keeps its own count
+        s64 allocated_size;
+        LineIndex line_index;
+
+        inline SourceLocation get_location(s64 index)
+        {
+            assert(index < len);
+            return line_index.get_location(starts[index]);
+        }
+
+        inline void get_token(s64 index, Token* token)
+        {
+            assert(index < len);
+            static_cast<TokenValue&>(*token) = values[index];
+            token->start = starts[index];
+            token->offset = lengths[index];
+            token->id = ids[index];
+        }
     };
 
 }
@@ -454,10 +875,12 @@ namespace AST
     {
         TypeExpr,
         IntLit,
+        FloatLit,
         ArrayLit,
         UnaryOp,
         BinOp,
         Subscript,
+        MemberAccess,
         Ret,
         VarDecl,
         VarExpr,
@@ -518,9 +941,9 @@ namespace AST
 
     struct VarDecl
     {
-        RNS::String name;
+        SymbolID name;
         // @TODO: should consider fully integrating the type in here
-        Type* type;
+        TypeRef type;
         Node* value;
         Node* scope;
         void* backend_ref;
@@ -555,7 +978,7 @@ namespace AST
         NodeRefBuffer scope_blocks;
         NodeRefBuffer arguments;
         NodeRefBuffer variables;
-        RNS::String name;
+        SymbolID name;
         Node* type;
     };
 
@@ -563,6 +986,8 @@ namespace AST
     {
         NodeRefBuffer arguments;
         Node* expr;
+        // @Info: functions can be called before they are defined, those calls are resolved by name once the file is parsed
+        SymbolID name;
     };
 
     struct Subscript
@@ -571,10 +996,17 @@ namespace AST
         Node* index_ref;
     };
 
+    // @Info: the field index is its position in memory, see StructType
+    struct MemberAccess
+    {
+        Node* expr_ref;
+        u32 field_index;
+    };
+
     struct ArrayLiteral
     {
         NodeRefBuffer elements;
-        Type* type;
+        TypeRef type;
     };
 
     struct Node
@@ -585,6 +1017,7 @@ namespace AST
         union
         {
             ConstantInt int_lit;
+            ConstantFloat float_lit;
             UnaryOperation unary_op;
             BinaryOperation bin_op;
             RetExpr ret;
@@ -598,21 +1031,31 @@ namespace AST
             FunctionDeclaration function;
             Type type_expr;
             Subscript subscript;
+            MemberAccess member_access;
             ArrayLiteral array_lit;
         };
     };
 
-    // @TODO: we are transforming this to inherit from the RNS-lib buffer. This may have some drawbacks. Come back to this when the compiler is more mature.
-    struct NodeBuffer : public RNS::Buffer<Node>
+    const s64 node_chunk_size = 1024;
+
+    /* Node buffer
+     * The nodes of a file, in a chunked buffer of node_chunk_size nodes per chunk, so a Node* stays valid while the buffer grows and
+     * the parser can link nodes as it goes.
+     */
+    struct NodeBuffer
     {
-        Node* append(NodeType type, Node* parent)
+        ChunkedBuffer<Node, node_chunk_size> nodes;
+
+        static NodeBuffer create(RNS::Allocator* allocator, Arena* arena = nullptr);
+
+        // @Info: the parser counts on the fields it doesn't set being zero, which they are in a new chunk
+        inline Node* append(NodeType type, Node* parent)
         {
             if (type != NodeType::Function)
             {
                 assert(parent);
             }
-            assert(len + 1 <= cap);
-            Node* result = &ptr[len++];
+            Node* result = &nodes[nodes.append()];
             result->type = type;
             result->parent = parent;
             if (type == NodeType::VarDecl)
@@ -622,6 +1065,11 @@ namespace AST
 
             return result;
         }
+
+        inline Node& operator[](s64 index)
+        {
+            return nodes[index];
+        }
     };
 
 
@@ -630,6 +1078,10 @@ namespace AST
         NodeBuffer node_buffer;
         FunctionTypeBuffer function_type_declarations;
         FunctionDeclarationBuffer function_declarations;
+        // @Info: calls to functions the file doesn't define, with their expr left null until the files are merged
+        NodeRefBuffer external_invoke_expressions;
+        // @Info: the float literals only need typing when the file has some
+        s64 float_literal_count;
     };
 }
 
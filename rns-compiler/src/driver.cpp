@@ -0,0 +1,752 @@
+#include <RNS/types.h>
+#include <RNS/compiler.h>
+#include <RNS/data_structures.h>
+#include <RNS/profiler.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#define USE_LLVM 0
+
+#include "driver.h"
+#include "lexer.h"
+#include "parser.h"
+#include "llvm_bytecode.h"
+#include "memory_profile.h"
+#include "thread.h"
+#include "time_report.h"
+#include "trace.h"
+
+using namespace RNS;
+
+enum class CompilerIR
+{
+    WASM,
+    LLVM_CUSTOM,
+#if USE_LLVM
+    LLVM,
+#endif
+};
+
+/* Multi-file front-end
+ * Every source file is lexed and parsed on its own by a pool of workers. A file gets its own Compiler, with its own symbol table and
+ * its own type system, so the workers share nothing while they run. The files are handed out before the workers start, each one to
+ * the worker with the fewest source bytes so far, and a worker parses its files one after the other in one set of arenas. The lexer
+ * arena is taken back after every file. What the parser returns has to stay until the backend is done, so the other arenas hold
+ * the files of the worker back to back, and the memory reserved grows with the worker count and the source size, not with the
+ * file count.
+ * Afterwards the function declarations of every file are merged in file order into one module for the backend. Function names
+ * are interned again into the global symbol table, which gives the same symbol ids no matter which worker finished first.
+ * Types are merged the same way: the types of every file are interned in file order into one type table, and the TypeRefs in the
+ * nodes of the file are rewritten to the ones of that table. Builtin types are at the same place in every table and keep their
+ * TypeRef. A struct has to be declared in every file which uses it, so files declaring the same struct share it, while two
+ * different structs with one name are an error.
+ */
+struct FrontEnd
+{
+    RNS::String source;
+    const char* name;
+    Compiler compiler;
+    AST::Result result;
+    TypeBuffer type_declarations;
+    // @Info: the allocators of the worker while the file was parsed, which the tables of the file point to
+    Allocator type_allocator;
+    Allocator parser_allocator;
+    PhaseTimer* timer;
+    // @Info: used bytes of every arena by the file, indexed by MemoryArena
+    s64 arena_used_sizes[memory_arena_count];
+};
+
+struct FrontEndWorker
+{
+    FrontEnd* front_ends;
+    // @Info: the files of the worker, indices into front_ends
+    u32* files;
+    u32 file_count;
+    s64 source_size;
+    s64 largest_source_size;
+    Allocator lexer_allocator;
+    Allocator common_allocator;
+    Allocator type_allocator;
+    Allocator parser_allocator;
+    // @Info: the arenas of the allocators above, which grow when the files need more than was carved out for them
+    Arena common_arena;
+    Arena type_arena;
+    Arena parser_arena;
+    // @Info: reserved and used bytes of the arenas of the worker, indexed by MemoryArena. The lexer arena is used by one file at a
+    // time, so what it used is the peak of its files
+    s64 arena_sizes[memory_arena_count];
+    s64 arena_used_sizes[memory_arena_count];
+};
+
+// @Info: the arenas every worker carves out of the page allocator
+const MemoryArena front_end_arenas[] = { MemoryArena::FrontEndCommon, MemoryArena::TypeSystem, MemoryArena::Lexer, MemoryArena::Parser };
+// @Info: room in the page allocator for the suballocators of a worker to be aligned and for the probes measuring them
+const s64 front_end_memory_slack = RNS_KILOBYTE(64);
+// @Info: what every file takes from each arena it shares with the other files of its worker, whatever its size: its symbol table,
+// its type table and the tables of its parser
+const s64 front_end_file_memory_size = RNS_KILOBYTE(256);
+
+// @Info: part of the cache key along with the hash of the compiler executable and the options. The hash already tells apart
+// every build, the version is there for entries written by a compiler which reads the same sources in a different way.
+const RNS::String compiler_version = { "0.2", 3 };
+
+static s64 get_ir_text_initial_size(s64 source_size)
+{
+    // @Info: the text grows by doubling, so reserving room for three times this covers any IR up to twice as big
+    return RNS_KILOBYTE(64) + 2 * source_size;
+}
+
+static RNS::String get_compile_options(CompilerIR compiler_ir)
+{
+    switch (compiler_ir)
+    {
+        case CompilerIR::LLVM_CUSTOM:
+            return { "ir=llvm_custom", 14 };
+        default:
+            RNS_UNREACHABLE;
+            return {};
+    }
+}
+
+// @Info: how many files and how much source every worker gets. It only depends on the sources and the thread count, so the memory
+// the compilation takes is known before it starts
+struct FrontEndPlan
+{
+    u32 worker_count;
+    u32 file_counts[max_worker_count];
+    s64 source_sizes[max_worker_count];
+    s64 largest_source_sizes[max_worker_count];
+};
+
+// @Info: fills the worker of every file unless file_workers is null
+static FrontEndPlan plan_front_end(RNS::String* sources, u32 source_count, u32* file_workers)
+{
+    u32 thread_count = get_hardware_thread_count();
+    FrontEndPlan plan = {
+        .worker_count = thread_count < source_count ? thread_count : source_count,
+    };
+    plan.worker_count = plan.worker_count < max_worker_count ? plan.worker_count : max_worker_count;
+
+    for (u32 i = 0; i < source_count; i++)
+    {
+        // @Info: ties go to the worker with fewer files, so every worker gets at least one even when files are empty
+        u32 worker = 0;
+        for (u32 candidate = 1; candidate < plan.worker_count; candidate++)
+        {
+            bool less_source = plan.source_sizes[candidate] < plan.source_sizes[worker];
+            bool fewer_files = plan.source_sizes[candidate] == plan.source_sizes[worker] && plan.file_counts[candidate] < plan.file_counts[worker];
+            worker = less_source || fewer_files ? candidate : worker;
+        }
+
+        plan.file_counts[worker]++;
+        plan.source_sizes[worker] += sources[i].len;
+        plan.largest_source_sizes[worker] = sources[i].len > plan.largest_source_sizes[worker] ? sources[i].len : plan.largest_source_sizes[worker];
+        if (file_workers)
+        {
+            file_workers[i] = worker;
+        }
+    }
+
+    return plan;
+}
+
+// @Info: fills the size of every arena of the worker and returns the bytes they take from the page allocator together
+static s64 get_front_end_worker_memory_size(const MemoryProfile* profile, const FrontEndPlan& plan, u32 worker, s64* arena_sizes)
+{
+    s64 memory_size = front_end_memory_slack;
+    for (MemoryArena arena : front_end_arenas)
+    {
+        u32 arena_index = static_cast<u32>(arena);
+        if (arena == MemoryArena::Lexer)
+        {
+            arena_sizes[arena_index] = get_arena_size(profile, arena, plan.largest_source_sizes[worker]);
+        }
+        else
+        {
+            arena_sizes[arena_index] = get_arena_size(profile, arena, plan.source_sizes[worker]) + (plan.file_counts[worker] - 1) * front_end_file_memory_size;
+        }
+        memory_size += arena_sizes[arena_index];
+    }
+
+    return memory_size;
+}
+
+static void parse_front_end(FrontEndWorker& worker, FrontEnd& front_end)
+{
+    auto& compiler = front_end.compiler;
+    s64* arena_used_sizes = front_end.arena_used_sizes;
+    RNS_TRACE_SCOPE("Front-end", front_end.name);
+    if (front_end.timer)
+    {
+        front_end.timer->start(compiler);
+    }
+
+    // @Info: the file continues the arenas of the worker where the file before it left them, except the lexer arena, which every
+    // file starts from the beginning
+    compiler.page_allocator = worker.lexer_allocator;
+    compiler.common_allocator = worker.common_allocator;
+    front_end.type_allocator = worker.type_allocator;
+    front_end.parser_allocator = worker.parser_allocator;
+    // @Info: the arenas follow the copies the file allocates from, so a new block taken while parsing it is where the next file continues
+    worker.common_arena.allocator = &compiler.common_allocator;
+    worker.type_arena.allocator = &front_end.type_allocator;
+    worker.parser_arena.allocator = &front_end.parser_allocator;
+    compiler.common_arena = &worker.common_arena;
+    s64 common_used_size = worker.common_arena.get_used_size();
+    s64 type_used_size = worker.type_arena.get_used_size();
+    s64 parser_used_size = worker.parser_arena.get_used_size();
+
+    compiler.symbols = SymbolTable::create(&compiler.common_allocator, 1024, compiler.common_arena);
+    // @Info: the type system is not shared, because the parser adds array and function types to it
+    front_end.type_declarations = Type::init_type_system(&front_end.type_allocator, &worker.type_arena);
+    TypeBuffer& type_declarations = front_end.type_declarations;
+
+    // @Info: tokens are lexed on demand while parsing, and only the token stream itself takes memory from the page allocator
+    u8* lexer_base = get_allocator_top(&compiler.page_allocator);
+    TokenStream token_stream = TokenStream::create(compiler, front_end.source, type_declarations);
+    arena_used_sizes[static_cast<u32>(MemoryArena::Lexer)] = get_allocator_top(&compiler.page_allocator) - lexer_base;
+
+    if (!compiler.errors_reported)
+    {
+        front_end.result = parse(compiler, token_stream, type_declarations, front_end.parser_allocator, &worker.parser_arena);
+    }
+
+    arena_used_sizes[static_cast<u32>(MemoryArena::FrontEndCommon)] = worker.common_arena.get_used_size() - common_used_size;
+    arena_used_sizes[static_cast<u32>(MemoryArena::TypeSystem)] = worker.type_arena.get_used_size() - type_used_size;
+    arena_used_sizes[static_cast<u32>(MemoryArena::Parser)] = worker.parser_arena.get_used_size() - parser_used_size;
+
+    worker.common_allocator = compiler.common_allocator;
+    worker.type_allocator = front_end.type_allocator;
+    worker.parser_allocator = front_end.parser_allocator;
+    // @Info: the copies of the file are left behind, the next file continues from the allocators of the worker
+    worker.common_arena.allocator = &worker.common_allocator;
+    worker.type_arena.allocator = &worker.type_allocator;
+    worker.parser_arena.allocator = &worker.parser_allocator;
+    compiler.common_arena = nullptr;
+    for (MemoryArena arena : front_end_arenas)
+    {
+        u32 arena_index = static_cast<u32>(arena);
+        if (arena == MemoryArena::Lexer)
+        {
+            worker.arena_used_sizes[arena_index] = arena_used_sizes[arena_index] > worker.arena_used_sizes[arena_index] ? arena_used_sizes[arena_index] : worker.arena_used_sizes[arena_index];
+        }
+        else
+        {
+            worker.arena_used_sizes[arena_index] += arena_used_sizes[arena_index];
+        }
+    }
+
+    if (front_end.timer)
+    {
+        front_end.timer->stop(compiler);
+        front_end.timer->add_memory(Compiler::Subsystem::Lexer, arena_used_sizes[static_cast<u32>(MemoryArena::Lexer)] + arena_used_sizes[static_cast<u32>(MemoryArena::FrontEndCommon)]);
+        front_end.timer->add_memory(Compiler::Subsystem::Parser, arena_used_sizes[static_cast<u32>(MemoryArena::Parser)] + arena_used_sizes[static_cast<u32>(MemoryArena::TypeSystem)]);
+    }
+}
+
+static void front_end_task(void* context, u32 index)
+{
+    auto& worker = static_cast<FrontEndWorker*>(context)[index];
+    for (u32 i = 0; i < worker.file_count; i++)
+    {
+        parse_front_end(worker, worker.front_ends[worker.files[i]]);
+    }
+}
+
+// @Info: the nodes and the tables of the files live in these blocks too, so they go once the backend is done with them
+static void free_front_end_workers(FrontEndWorker* workers, u32 worker_count)
+{
+    for (u32 i = 0; i < worker_count; i++)
+    {
+        workers[i].common_arena.free_blocks();
+        workers[i].type_arena.free_blocks();
+        workers[i].parser_arena.free_blocks();
+    }
+}
+
+static void reserve_common(Compiler& compiler, s64 size)
+{
+    if (compiler.common_arena)
+    {
+        compiler.common_arena->reserve(size);
+    }
+}
+
+static bool struct_types_equal(StructType& a, StructType& b)
+{
+    if (a.field_count != b.field_count || a.cache_line_aligned != b.cache_line_aligned)
+    {
+        return false;
+    }
+    // @Info: the field names are symbols of different files, so only types and offsets are compared
+    for (s64 i = 0; i < a.field_count; i++)
+    {
+        if (a.field_types[i] != b.field_types[i] || a.field_offsets[i] != b.field_offsets[i])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// @Info: adds a type of the file to the module table, after the types it is made of, and records what it became. A struct is
+// recorded before its fields are merged, since they can point to it
+static bool merge_type(Compiler& compiler, TypeBuffer& module_types, TypeBuffer& file_types, TypeRef* type_map, TypeRef file_type)
+{
+    if (type_map[file_type])
+    {
+        return true;
+    }
+
+    auto merge_child = [&](TypeRef& child)
+    {
+        bool merged = merge_type(compiler, module_types, file_types, type_map, child);
+        child = type_map[child];
+        return merged;
+    };
+
+    Type type = file_types[file_type];
+    auto name = file_types.get_name(file_type);
+    switch (type.id)
+    {
+        case TypeID::ArrayType:
+            if (!merge_child(type.array_t.type))
+            {
+                return false;
+            }
+            break;
+        case TypeID::PointerType:
+            if (!merge_child(type.pointer_t.appointee))
+            {
+                return false;
+            }
+            break;
+        case TypeID::FixedVectorType:
+            if (!merge_child(type.vector_t.type))
+            {
+                return false;
+            }
+            break;
+        case TypeID::StructType:
+        {
+            TypeRef module_type = module_types.find_by_name(name);
+            bool declared_before = module_type != no_type;
+            type_map[file_type] = declared_before ? module_type : Type::declare_struct_type(name, module_types);
+
+            auto& struct_type = type.struct_t;
+            reserve_common(compiler, struct_type.field_count * sizeof(TypeRef));
+            auto* field_types = new(&compiler.common_allocator) TypeRef[struct_type.field_count];
+            for (s64 field = 0; field < struct_type.field_count; field++)
+            {
+                field_types[field] = struct_type.field_types[field];
+                if (!merge_child(field_types[field]))
+                {
+                    return false;
+                }
+            }
+            struct_type.field_types = field_types;
+
+            if (!declared_before)
+            {
+                module_types.set(module_type = type_map[file_type], type);
+            }
+            else if (!struct_types_equal(module_types[module_type].struct_t, type.struct_t))
+            {
+                compiler.print_error({}, "Struct %.*s is declared differently in more than one file", static_cast<s32>(name.len), name.get());
+                return false;
+            }
+            return true;
+        }
+        case TypeID::IntegerType:
+        case TypeID::FloatType:
+        case TypeID::DoubleType:
+            break;
+        default:
+            RNS_NOT_IMPLEMENTED;
+            break;
+    }
+
+    type_map[file_type] = name.len ? module_types.append(type, name) : module_types.intern(type);
+    return true;
+}
+
+// @Info: adds the types of the file to the module table and returns what each TypeRef of the file became, or null if they clash
+static TypeRef* merge_type_declarations(Compiler& compiler, TypeBuffer& module_types, TypeBuffer& file_types)
+{
+    reserve_common(compiler, file_types.entries.len * sizeof(TypeRef));
+    TypeRef* type_map = new(&compiler.common_allocator) TypeRef[file_types.entries.len];
+    memset(type_map, 0, file_types.entries.len * sizeof(TypeRef));
+    s64 builtin_type_end = get_builtin_type(BuiltinTypeID::Count);
+    for (s64 i = 1; i < builtin_type_end; i++)
+    {
+        type_map[i] = static_cast<TypeRef>(i);
+    }
+
+    for (s64 i = builtin_type_end; i < file_types.entries.len; i++)
+    {
+        if (!merge_type(compiler, module_types, file_types, type_map, static_cast<TypeRef>(i)))
+        {
+            return nullptr;
+        }
+    }
+
+    return type_map;
+}
+
+static void remap_node_types(NodeBuffer& node_buffer, TypeRef* type_map)
+{
+    for (s64 i = 0; i < node_buffer.nodes.len; i++)
+    {
+        auto& node = node_buffer[i];
+        switch (node.type)
+        {
+            case NodeType::VarDecl:
+                node.var_decl.type = type_map[node.var_decl.type];
+                break;
+            case NodeType::ArrayLit:
+                node.array_lit.type = type_map[node.array_lit.type];
+                break;
+            case NodeType::TypeExpr:
+            {
+                assert(node.type_expr.id == TypeID::FunctionType);
+                auto& function_type = node.type_expr.function_t;
+                function_type.ret_type = type_map[function_type.ret_type];
+                for (auto& arg_type : function_type.arg_types)
+                {
+                    arg_type = type_map[arg_type];
+                }
+            } break;
+            default:
+                break;
+        }
+    }
+}
+
+static bool merge_front_ends(Compiler& compiler, FrontEnd* front_ends, u32 front_end_count, AST::Result* module, TypeBuffer* module_types)
+{
+    RNS_PROFILE_FUNCTION();
+    s64 function_count = 0;
+    s64 function_type_count = 0;
+    for (u32 i = 0; i < front_end_count; i++)
+    {
+        auto& result = front_ends[i].result;
+        function_count += result.function_declarations.len;
+        function_type_count += result.function_type_declarations.len;
+
+        for (auto* function : result.function_declarations)
+        {
+            Symbol& name = front_ends[i].compiler.symbols.symbols[function->function.name];
+            function->function.name = compiler.symbols.intern(name.name.get(), name.name.len, name.hash);
+        }
+    }
+
+    // @Info: a single file already has the table of the module
+    if (front_end_count == 1)
+    {
+        *module_types = front_ends[0].type_declarations;
+    }
+    else
+    {
+        RNS_TRACE_SCOPE("Merge types");
+        *module_types = Type::init_type_system(&compiler.common_allocator, compiler.common_arena);
+        for (u32 i = 0; i < front_end_count; i++)
+        {
+            TypeRef* type_map = merge_type_declarations(compiler, *module_types, front_ends[i].type_declarations);
+            if (!type_map)
+            {
+                return false;
+            }
+            remap_node_types(front_ends[i].result.node_buffer, type_map);
+        }
+    }
+
+    // @Info: nodes stay in the buffers of their files, the backend reaches them through the function declarations
+    reserve_common(compiler, function_type_count * sizeof(*module->function_type_declarations.ptr) + function_count * sizeof(*module->function_declarations.ptr) + compiler.symbols.len * sizeof(Node*));
+    *module = {
+        .function_type_declarations = FunctionTypeBuffer::create(&compiler.common_allocator, function_type_count),
+        .function_declarations = FunctionDeclarationBuffer::create(&compiler.common_allocator, function_count),
+    };
+
+    // @Info: the function each module symbol names. The parser already turns down a name defined twice in a file, so one found here
+    // comes from another file, and calls to it couldn't tell the two apart
+    s64 function_name_count = compiler.symbols.len;
+    Node** function_by_name = new(&compiler.common_allocator) Node*[function_name_count];
+    memset(function_by_name, 0, function_name_count * sizeof(Node*));
+    for (u32 i = 0; i < front_end_count; i++)
+    {
+        auto& result = front_ends[i].result;
+        for (auto* function : result.function_declarations)
+        {
+            SymbolID name = function->function.name;
+            if (function_by_name[name])
+            {
+                auto function_name = compiler.symbols.get_name(name);
+                compiler.print_error({}, "Function %.*s is defined in more than one file", static_cast<s32>(function_name.len), function_name.get());
+                return false;
+            }
+            function_by_name[name] = function;
+            module->function_declarations.append(function);
+        }
+        for (auto* function_type : result.function_type_declarations)
+        {
+            module->function_type_declarations.append(function_type);
+        }
+    }
+
+    // @Info: calls to functions of other files, by the name of the function in the module. Names no file defines may be interned
+    // past the end of the table, so they are checked against its length first
+    for (u32 i = 0; i < front_end_count; i++)
+    {
+        auto& front_end = front_ends[i];
+        for (auto* invoke_expr_node : front_end.result.external_invoke_expressions)
+        {
+            auto& invoke_expr = invoke_expr_node->invoke_expr;
+            Symbol& name = front_end.compiler.symbols.symbols[invoke_expr.name];
+            SymbolID module_name = compiler.symbols.intern(name.name.get(), name.name.len, name.hash);
+            invoke_expr.expr = module_name < function_name_count ? function_by_name[module_name] : nullptr;
+            if (!invoke_expr.expr)
+            {
+                compiler.print_error({}, "Unknown function %.*s", static_cast<s32>(name.name.len), name.name.get());
+                return false;
+            }
+        }
+    }
+
+    // @Info: every call is resolved by now, so literals next to a call to another file get their type like any other
+    for (u32 i = 0; i < front_end_count; i++)
+    {
+        auto& front_end = front_ends[i];
+        if (front_end.result.float_literal_count && !type_float_literals(compiler, front_end.source, *module_types, front_end.result.function_declarations))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+s64 get_compile_memory_size(RNS::String* sources, u32 source_count, const MemoryProfile* profile)
+{
+    s64 source_size = 0;
+    for (u32 i = 0; i < source_count; i++)
+    {
+        source_size += sources[i].len;
+    }
+
+    s64 memory_size = 0;
+    FrontEndPlan plan = plan_front_end(sources, source_count, nullptr);
+    for (u32 worker = 0; worker < plan.worker_count; worker++)
+    {
+        s64 arena_sizes[memory_arena_count];
+        memory_size += get_front_end_worker_memory_size(profile, plan, worker, arena_sizes);
+    }
+
+    return memory_size + get_arena_size(profile, MemoryArena::Backend, source_size) + 3 * get_ir_text_initial_size(source_size);
+}
+
+static bool compile_module(Compiler& compiler, RNS::String* sources, const char** source_names, u32 source_count, const CompileOptions& options, TimeReport* report)
+{
+    CompileCache* cache = options.cache;
+    MemoryProfile* profile = options.memory_profile;
+    s64 source_size = 0;
+    for (u32 i = 0; i < source_count; i++)
+    {
+        source_size += sources[i].len;
+    }
+
+    CompilerIR compiler_ir = CompilerIR::LLVM_CUSTOM;
+    CompileCacheKey cache_key;
+    if (cache)
+    {
+        RNS_TRACE_SCOPE("Cache lookup");
+        cache_key = cache->get_key(compiler_version, get_compile_options(compiler_ir), sources, source_count);
+        RNS::String cached_ir;
+        if (cache->load(cache_key, &compiler.page_allocator, &cached_ir))
+        {
+            fwrite(cached_ir.ptr, 1, cached_ir.len, stdout);
+            return true;
+        }
+    }
+
+    reserve_common(compiler, source_count * (sizeof(FrontEnd) + 2 * sizeof(u32)));
+    FrontEnd* front_ends = new(&compiler.common_allocator) FrontEnd[source_count];
+    for (u32 i = 0; i < source_count; i++)
+    {
+        front_ends[i] = {
+            .source = sources[i],
+            .name = source_names[i],
+            .compiler = {
+                .errors_reported = false,
+            },
+            .timer = report ? &report->files[i].timer : nullptr,
+        };
+    }
+
+    u32* file_workers = new(&compiler.common_allocator) u32[source_count];
+    FrontEndPlan plan = plan_front_end(sources, source_count, file_workers);
+    u32* worker_files = new(&compiler.common_allocator) u32[source_count];
+    FrontEndWorker workers[max_worker_count];
+    // @Info: the suballocators are carved out here, before the workers start, since allocating from the page allocator is not thread-safe
+    for (u32 worker_index = 0, file_offset = 0; worker_index < plan.worker_count; worker_index++)
+    {
+        auto& worker = workers[worker_index];
+        worker = {
+            .front_ends = front_ends,
+            .files = &worker_files[file_offset],
+            .source_size = plan.source_sizes[worker_index],
+            .largest_source_size = plan.largest_source_sizes[worker_index],
+        };
+        file_offset += plan.file_counts[worker_index];
+        for (u32 i = 0; i < source_count; i++)
+        {
+            if (file_workers[i] == worker_index)
+            {
+                worker.files[worker.file_count++] = i;
+            }
+        }
+
+        get_front_end_worker_memory_size(profile, plan, worker_index, worker.arena_sizes);
+        worker.lexer_allocator = create_suballocator(&compiler.page_allocator, worker.arena_sizes[static_cast<u32>(MemoryArena::Lexer)]);
+        worker.common_allocator = create_suballocator(&compiler.page_allocator, worker.arena_sizes[static_cast<u32>(MemoryArena::FrontEndCommon)]);
+        worker.type_allocator = create_suballocator(&compiler.page_allocator, worker.arena_sizes[static_cast<u32>(MemoryArena::TypeSystem)]);
+        worker.parser_allocator = create_suballocator(&compiler.page_allocator, worker.arena_sizes[static_cast<u32>(MemoryArena::Parser)]);
+        worker.common_arena = Arena::create(&worker.common_allocator, worker.arena_sizes[static_cast<u32>(MemoryArena::FrontEndCommon)]);
+        worker.type_arena = Arena::create(&worker.type_allocator, worker.arena_sizes[static_cast<u32>(MemoryArena::TypeSystem)]);
+        worker.parser_arena = Arena::create(&worker.parser_allocator, worker.arena_sizes[static_cast<u32>(MemoryArena::Parser)]);
+    }
+
+    run_tasks(front_end_task, workers, plan.worker_count, plan.worker_count);
+
+    if (profile)
+    {
+        for (u32 worker_index = 0; worker_index < plan.worker_count; worker_index++)
+        {
+            auto& worker = workers[worker_index];
+            for (MemoryArena arena : front_end_arenas)
+            {
+                u32 arena_index = static_cast<u32>(arena);
+                s64 arena_source_size = arena == MemoryArena::Lexer ? worker.largest_source_size : worker.source_size;
+                profile->record(arena, arena_source_size, worker.arena_sizes[arena_index], worker.arena_used_sizes[arena_index]);
+            }
+        }
+    }
+
+    for (u32 i = 0; i < source_count; i++)
+    {
+        if (report)
+        {
+            report->files[i].node_count = front_ends[i].result.node_buffer.nodes.len;
+        }
+
+        auto& front_end_compiler = front_ends[i].compiler;
+        if (front_end_compiler.errors_reported)
+        {
+            printf(front_end_compiler.subsystem == Compiler::Subsystem::Lexer ? "Lexer failed!\n" : "Parsing failed.\n");
+            free_front_end_workers(workers, plan.worker_count);
+            return false;
+        }
+    }
+
+    compiler.set_subsystem(Compiler::Subsystem::Parser);
+    if (report)
+    {
+        report->timer.start(compiler);
+    }
+
+    AST::Result module;
+    TypeBuffer module_types;
+    u8* merge_allocator_base = get_allocator_top(&compiler.common_allocator);
+    s64 merge_used_size = compiler.common_arena ? compiler.common_arena->get_used_size() : 0;
+    if (!merge_front_ends(compiler, front_ends, source_count, &module, &module_types))
+    {
+        printf("Parsing failed.\n");
+        free_front_end_workers(workers, plan.worker_count);
+        return false;
+    }
+    if (report)
+    {
+        s64 merge_memory_size = compiler.common_arena ? compiler.common_arena->get_used_size() - merge_used_size : get_allocator_top(&compiler.common_allocator) - merge_allocator_base;
+        report->timer.add_memory(Compiler::Subsystem::Parser, merge_memory_size);
+    }
+
+    s64 backend_memory_size = get_arena_size(profile, MemoryArena::Backend, source_size);
+    Allocator backend_allocator = create_suballocator(&compiler.page_allocator, backend_memory_size);
+    Arena backend_arena = Arena::create(&backend_allocator, backend_memory_size);
+    s64 ir_memory_size = 3 * get_ir_text_initial_size(source_size);
+    Allocator ir_allocator = create_suballocator(&compiler.page_allocator, ir_memory_size);
+    Arena ir_arena = Arena::create(&ir_allocator, ir_memory_size);
+    IRText ir = IRText::create(&ir_allocator, get_ir_text_initial_size(source_size), &ir_arena);
+
+    switch (compiler_ir)
+    {
+        case CompilerIR::LLVM_CUSTOM:
+        {
+            RNS::encode(compiler, backend_arena, module.node_buffer, module_types, module.function_type_declarations, module.function_declarations, ir);
+        } break;
+        default:
+            RNS_UNREACHABLE;
+            break;
+    }
+
+    s64 backend_used_size = backend_arena.get_used_size();
+    backend_arena.free_blocks();
+    free_front_end_workers(workers, plan.worker_count);
+    if (profile)
+    {
+        profile->record(MemoryArena::Backend, source_size, backend_memory_size, backend_used_size);
+    }
+    if (report)
+    {
+        // @Info: the IR text leaves its old buffers behind as it grows, only what was written counts
+        report->timer.add_memory(Compiler::Subsystem::IR, backend_used_size + ir.len);
+    }
+
+    fwrite(ir.ptr, 1, ir.len, stdout);
+    if (compiler.errors_reported)
+    {
+        printf("IR generation failed\n");
+        ir_arena.free_blocks();
+        return false;
+    }
+
+    if (cache)
+    {
+        RNS_TRACE_SCOPE("Cache store");
+        cache->store(cache_key, ir.get());
+    }
+
+    ir_arena.free_blocks();
+    return true;
+}
+
+bool compile_sources(Compiler& compiler, RNS::String* sources, const char** source_names, u32 source_count, const CompileOptions& options)
+{
+    RNS_TRACE_SCOPE("Compile");
+    if (!options.print_time_report && !options.time_report_json_path)
+    {
+        return compile_module(compiler, sources, source_names, source_count, options, nullptr);
+    }
+
+    reserve_common(compiler, source_count * sizeof(FileTimeReport));
+    TimeReport report = TimeReport::create(&compiler.common_allocator, source_names, source_count);
+    report.begin();
+    bool result = compile_module(compiler, sources, source_names, source_count, options, &report);
+    if (compiler.phase_timer)
+    {
+        compiler.phase_timer->stop(compiler);
+    }
+    report.end();
+
+    if (options.print_time_report)
+    {
+        report.print();
+    }
+    if (options.time_report_json_path)
+    {
+        report.write_json(options.time_report_json_path);
+    }
+
+    return result;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <RNS/types.h>
+#include <RNS/data_structures.h>
+#include "compiler_types.h"
+#include "compile_cache.h"
+#include "memory_profile.h"
+
+struct CompileOptions
+{
+    CompileCache* cache;
+    // @Info: prints wall time, CPU time and memory per phase and per file once done
+    bool print_time_report;
+    // @Info: writes the same report as JSON to this path
+    const char* time_report_json_path;
+    // @Info: measures what every arena of the compilation uses, and sizes them from what it measured before
+    MemoryProfile* memory_profile;
+};
+
+// @Info: bytes compile_sources takes from the page allocator of the compiler for these sources. The profile can be null
+s64 get_compile_memory_size(RNS::String* sources, u32 source_count, const MemoryProfile* profile);
+// @Info: lexes and parses the sources in parallel and emits them as one module. The symbol table and the common allocator of the
+// compiler are shared by every source, and its page allocator needs get_compile_memory_size bytes left. With a cache, sources it
+// has already seen skip the compilation and print the output stored for them. The names are only used to report on the sources
+bool compile_sources(Compiler& compiler, RNS::String* sources, const char** source_names, u32 source_count, const CompileOptions& options);
@@ -0,0 +1,53 @@
+#include "file_system.h"
+
+#include <stdio.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace FileSystem
+{
+#if defined(_WIN32)
+    bool replace_file(const char* source_path, const char* destination_path)
+    {
+        return MoveFileExA(source_path, destination_path, MOVEFILE_REPLACE_EXISTING);
+    }
+
+    u32 get_process_id()
+    {
+        return GetCurrentProcessId();
+    }
+
+    bool get_executable_path(char* path, s64 path_size)
+    {
+        DWORD path_length = GetModuleFileNameA(nullptr, path, static_cast<DWORD>(path_size));
+        return path_length != 0 && path_length < path_size;
+    }
+#else
+    bool replace_file(const char* source_path, const char* destination_path)
+    {
+        return rename(source_path, destination_path) == 0;
+    }
+
+    u32 get_process_id()
+    {
+        return static_cast<u32>(getpid());
+    }
+
+    bool get_executable_path(char* path, s64 path_size)
+    {
+        ssize_t path_length = readlink("/proc/self/exe", path, path_size);
+        if (path_length <= 0 || path_length >= path_size)
+        {
+            return false;
+        }
+        path[path_length] = 0;
+        return true;
+    }
+#endif
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include <RNS/types.h>
+
+// @Info: the native calls shared by the parts of the compiler which write files other compilers may be reading at the same time
+namespace FileSystem
+{
+    // @Info: renames the file over the destination, replacing it if it exists, in a single step readers can't see half done
+    bool replace_file(const char* source_path, const char* destination_path);
+    // @Info: tells apart the temporary files of compilers writing to the same place
+    u32 get_process_id();
+    // @Info: path of the running compiler, false if it doesn't fit in the buffer or the system can't tell
+    bool get_executable_path(char* path, s64 path_size);
+}
@@ -1,9 +1,27 @@
 #include "lexer.h"
+#include "thread.h"
+#include "power_of_five_table.h"
+#include "trace.h"
 
 #include <RNS/os.h>
 #include <RNS/profiler.h>
 #include <string.h>
 #include <stdlib.h>
+#include <float.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define LEXER_SIMD_WIDTH 32
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LEXER_SIMD_WIDTH 16
+#else
+#define LEXER_SIMD_WIDTH 0
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 using namespace RNS;
 #define CaseAlphabeticUpper \
@@ -103,7 +121,7 @@ DecimalDigits
 //static_assert(sizeof(Token) == 2 * sizeof(s64));
 
 #define KW_DEF(x) #x
-const char* keywords[] =
+constexpr const char* keywords[] =
 {
 KW_DEF(return),
 KW_DEF(if),
@@ -112,226 +130,1726 @@ KW_DEF(for),
 KW_DEF(while),
 KW_DEF(break),
 KW_DEF(continue),
+KW_DEF(struct),
 };
 
 const auto keyword_count = rns_array_length(keywords);
 static_assert(static_cast<u8>(KeywordID::Count) == keyword_count);
 
-struct TokenBuffer
+/* Perfect hash over the keywords and the builtin type names.
+ * The table and its seed are computed at compile time, so classifying a name costs one hash of at most name_table_max_length bytes,
+ * one table load and one compare.
+ */
+const u32 name_table_bits = 7;
+const u32 name_table_size = 1 << name_table_bits;
+const u32 name_table_max_length = 8;
+const auto name_table_entry_count = keyword_count + static_cast<u8>(BuiltinTypeID::Count);
+
+static constexpr u32 name_table_hash(const char* name, s64 len, u32 seed)
 {
-    Token* ptr;
-    s64 len;
-    s64 cap;
-    s64 line_count;
-    s64 file_size;
-    const char* file;
-    RNS::StringBuffer sb;
+    u32 hash = 2166136261u ^ seed;
+    for (s64 i = 0; i < len; i++)
+    {
+        hash ^= static_cast<u8>(name[i]);
+        hash *= 16777619u;
+    }
+    hash ^= hash >> 15;
+    hash *= 0x2C1B3C6Du;
+    hash ^= hash >> 12;
+
+    return hash >> (32 - name_table_bits);
+}
 
-    Token* new_token(TokenID type, u64 start, u32 end, u32 line, u32 column)
+static constexpr u8 constexpr_length(const char* str)
+{
+    u8 len = 0;
+    while (str[len])
     {
-        assert(len + 1 < cap);
-        Token* token = &ptr[len++];
-        token->id = type;
-        token->start = start;
-        token->line = line;
-        token->column = column;
-        token->offset = end - start;
-        //token->print_token_id();
-        return token;
+        len++;
     }
+    return len;
+}
+
+struct NameTable
+{
+    struct Entry
+    {
+        const char* name;
+        u8 len;
+        TokenID token_id;
+        u8 value;
+    };
+
+    Entry entries[name_table_entry_count];
+    u8 slots[name_table_size]; // entry index + 1, 0 is an empty slot
+    u32 seed;
 };
 
+static constexpr NameTable create_name_table()
+{
+    NameTable table = {};
+    u32 entry_count = 0;
+    for (u32 i = 0; i < keyword_count; i++)
+    {
+        table.entries[entry_count++] = { keywords[i], constexpr_length(keywords[i]), TokenID::Keyword, static_cast<u8>(i) };
+    }
+    for (u32 i = 0; i < static_cast<u8>(BuiltinTypeID::Count); i++)
+    {
+        table.entries[entry_count++] = { builtin_type_names[i], constexpr_length(builtin_type_names[i]), TokenID::Type, static_cast<u8>(i) };
+    }
+
+    for (u32 seed = 0; seed < UINT16_MAX; seed++)
+    {
+        for (auto& slot : table.slots)
+        {
+            slot = 0;
+        }
+
+        bool collision = false;
+        for (u32 i = 0; i < entry_count && !collision; i++)
+        {
+            auto& entry = table.entries[i];
+            u32 slot = name_table_hash(entry.name, entry.len, seed);
+            collision = table.slots[slot] != 0;
+            table.slots[slot] = static_cast<u8>(i + 1);
+        }
+
+        if (!collision)
+        {
+            table.seed = seed;
+            return table;
+        }
+    }
+
+    table.seed = UINT32_MAX;
+    return table;
+}
+
+static constexpr NameTable name_table = create_name_table();
+static_assert(name_table.seed != UINT32_MAX, "No perfect hash seed found for the keyword and builtin type names");
+static_assert([]()
+{
+    for (auto& entry : name_table.entries)
+    {
+        if (entry.len > name_table_max_length)
+        {
+            return false;
+        }
+    }
+    return true;
+}());
+
 struct NameMatch
 {
     TokenID token_id;
     union
     {
         KeywordID keyword;
-        Type* type;
+        TypeRef type;
         IntrinsicID intrinsic;
     };
 };
 
 static inline NameMatch match_name(StringView name, TypeBuffer& type_declarations)
 {
-    for (auto i = 0; i < keyword_count; i++)
+    if (name.len <= name_table_max_length)
     {
-        const char* kw_str = keywords[i];
-        auto kw_len = strlen(kw_str);
-        if (kw_len == name.len && strncmp(kw_str, name.get(), name.len) == 0)
+        const char* name_ptr = name.get();
+        u8 slot = name_table.slots[name_table_hash(name_ptr, name.len, name_table.seed)];
+        if (slot)
         {
-            return { .token_id = TokenID::Keyword, .keyword = static_cast<KeywordID>(i) };
+            auto& entry = name_table.entries[slot - 1];
+            if (entry.len == name.len && memcmp(entry.name, name_ptr, name.len) == 0)
+            {
+                if (entry.token_id == TokenID::Keyword)
+                {
+                    return { .token_id = TokenID::Keyword, .keyword = static_cast<KeywordID>(entry.value) };
+                }
+
+                return { .token_id = TokenID::Type, .type = get_builtin_type(static_cast<BuiltinTypeID>(entry.value)) };
+            }
         }
     }
 
-    for (auto& type : type_declarations)
+    if (type_declarations.named_type_count > static_cast<s64>(BuiltinTypeID::Count))
     {
-        if (type.name.equal(name))
+        if (TypeRef type = type_declarations.find_by_name(name))
         {
-            return { .token_id = TokenID::Type, .type = &type };
+            return { .token_id = TokenID::Type, .type = type };
         }
     }
-    
+
     return { .token_id = TokenID::Symbol };
 }
 
-LexerResult lex(Compiler& compiler, RNS::String file_content, TypeBuffer& type_declarations)
+static inline u32 count_trailing_zeros(u32 mask)
 {
-    RNS_PROFILE_FUNCTION();
-    compiler.subsystem = Compiler::Subsystem::Lexer;
-
-    Allocator token_allocator = create_suballocator(&compiler.page_allocator, RNS_MEGABYTE(100));
-    Allocator name_allocator = create_suballocator(&compiler.page_allocator, RNS_MEGABYTE(100));
-
-    s64 tokens_to_allocate = 64 + ((s64)file_content.len / 2);
-    s64 chars_to_allocate_in_string_buffer = 64 + tokens_to_allocate;
-    TokenBuffer token_buffer = {
-        .ptr = new(&token_allocator) Token[tokens_to_allocate],
-        .len = 0,
-        .cap = tokens_to_allocate,
-        .file_size = file_content.len,
-        .file = file_content.ptr,
-        .sb = StringBuffer::create(&name_allocator, chars_to_allocate_in_string_buffer),
-    };
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
 
+static inline u32 pop_count(u32 mask)
+{
+#if defined(_MSC_VER)
+    // @Info: __popcnt would require POPCNT, which the SSE2 builds don't assume
+    mask = mask - ((mask >> 1) & 0x55555555);
+    mask = (mask & 0x33333333) + ((mask >> 2) & 0x33333333);
+    return (((mask + (mask >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+#else
+    return __builtin_popcount(mask);
+#endif
+}
 
-    Token* token = nullptr;
+/* Vectorized character classification.
+ * Each helper classifies LEXER_SIMD_WIDTH bytes at once and returns a bitmask with one bit per byte. The vector loops only run while a
+ * whole block fits inside the file; the remaining bytes go through the scalar switches, which stop at the '\0' that follows the file.
+ */
+#if LEXER_SIMD_WIDTH == 32
+using CharBlock = __m256i;
+const u32 char_block_full_mask = UINT32_MAX;
 
-    u32 current_line_start = 0;
-    for (s64 i = 0; i < file_content.len; i++)
-    {
-        char c = file_content[i];
-        s64 start;
-        s64 end;
+static inline CharBlock load_block(const char* ptr)
+{
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr));
+}
+
+static inline CharBlock block_equal(CharBlock block, char c)
+{
+    return _mm256_cmpeq_epi8(block, _mm256_set1_epi8(c));
+}
+
+static inline CharBlock block_or(CharBlock a, CharBlock b)
+{
+    return _mm256_or_si256(a, b);
+}
+
+static inline CharBlock block_in_range(CharBlock block, char low, char high)
+{
+    return _mm256_and_si256(_mm256_cmpgt_epi8(block, _mm256_set1_epi8(low - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8(high + 1), block));
+}
+
+static inline u32 block_mask(CharBlock block)
+{
+    return static_cast<u32>(_mm256_movemask_epi8(block));
+}
+#elif LEXER_SIMD_WIDTH == 16
+using CharBlock = __m128i;
+const u32 char_block_full_mask = UINT16_MAX;
+
+static inline CharBlock load_block(const char* ptr)
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+}
+
+static inline CharBlock block_equal(CharBlock block, char c)
+{
+    return _mm_cmpeq_epi8(block, _mm_set1_epi8(c));
+}
+
+static inline CharBlock block_or(CharBlock a, CharBlock b)
+{
+    return _mm_or_si128(a, b);
+}
+
+static inline CharBlock block_in_range(CharBlock block, char low, char high)
+{
+    return _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8(low - 1)), _mm_cmplt_epi8(block, _mm_set1_epi8(high + 1)));
+}
 
-        for (;;)
+static inline u32 block_mask(CharBlock block)
+{
+    return static_cast<u32>(_mm_movemask_epi8(block));
+}
+#endif
+
+#if LEXER_SIMD_WIDTH
+// @Info: this must match the SymbolEnd macro
+static inline u32 symbol_end_mask(CharBlock block)
+{
+    CharBlock result = block_or(block_equal(block, '\n'), block_equal(block, ' '));
+    result = block_or(result, block_or(block_equal(block, ','), block_equal(block, ':')));
+    result = block_or(result, block_or(block_equal(block, ';'), block_equal(block, '.')));
+    result = block_or(result, block_or(block_equal(block, '\\'), block_equal(block, '&')));
+    result = block_or(result, block_or(block_equal(block, '('), block_equal(block, ')')));
+    result = block_or(result, block_or(block_equal(block, '['), block_equal(block, ']')));
+    return block_mask(result);
+}
+#endif
+
+static inline s64 skip_blanks(TokenBuffer& token_buffer, s64 i)
+{
+    const char* file = token_buffer.file;
+#if LEXER_SIMD_WIDTH
+    while (i + LEXER_SIMD_WIDTH <= token_buffer.lex_end)
+    {
+        CharBlock block = load_block(&file[i]);
+        u32 non_blank_mask = ~block_mask(block_or(block_equal(block, '\n'), block_equal(block, ' '))) & char_block_full_mask;
+        if (non_blank_mask)
         {
-            switch (c)
-            {
-                case '\n':
-                    token_buffer.line_count++;
-                    assert(token_buffer.line_count <= UINT16_MAX);
-                    c = file_content[++i];
-                    current_line_start = i;
-                    break;
-                case ' ':
-                    c = file_content[++i];
-                    break;
-                default:
-                    goto end_blank;
-            }
+            return i + count_trailing_zeros(non_blank_mask);
         }
-    end_blank:
 
-        switch (c)
+        i += LEXER_SIMD_WIDTH;
+    }
+#endif
+
+    for (;; i++)
+    {
+        switch (file[i])
         {
-            SymbolStart:
-            {
-                start = i;
-                for (;;)
-                {
-                    switch (c)
-                    {
-                    SymbolEnd:
-                        goto end_symbol;
-                        default:
-                            c = file_content[++i];
-                    }
-                }
-            end_symbol:
-                end = i;
-                i--;
-                auto len = end - start;
-                const char* string_view_ptr = &token_buffer.file[start];
-                StringView name = StringView::create(string_view_ptr, len);
-                auto match = match_name(name, type_declarations);
-                Token* t = token_buffer.new_token(match.token_id, start, end, token_buffer.line_count, start - current_line_start);
-                switch (match.token_id)
+            BlankChars:
+                // @Info: the blanks at lex_end and after belong to the next range
+                if (i >= token_buffer.lex_end)
                 {
-                    case TokenID::Keyword:
-                        t->keyword = match.keyword;
-                        break;
-                    case TokenID::Type:
-                        t->type = match.type;
-                        break;
-                        // @TODO: intrinsics should not be names at all, they should go under the intrinsic character (presumably '@'?) switch case
-                    case TokenID::Intrinsic:
-                        t->intrinsic = match.intrinsic;
-                        break;
-                    case TokenID::Symbol:
-                        t->symbol = token_buffer.sb.append(&token_buffer.file[start], len);
-                        break;
-                    default:
-                        RNS_UNREACHABLE;
-                        break;
+                    return i;
                 }
                 break;
-            }
-            NumberStart:
-            {
-                start = i;
-                const auto number_buffer_max_digits = 32;
-                char number_buffer[number_buffer_max_digits];
-                auto number_buffer_len = 0;
-                for (;;)
+            default:
+                return i;
+        }
+    }
+}
+
+static inline s64 find_symbol_end(TokenBuffer& token_buffer, s64 i)
+{
+    const char* file = token_buffer.file;
+#if LEXER_SIMD_WIDTH
+    while (i + LEXER_SIMD_WIDTH <= token_buffer.file_size)
+    {
+        u32 end_mask = symbol_end_mask(load_block(&file[i]));
+        if (end_mask)
+        {
+            return i + count_trailing_zeros(end_mask);
+        }
+
+        i += LEXER_SIMD_WIDTH;
+    }
+#endif
+
+    for (;; i++)
+    {
+        switch (file[i])
+        {
+            SymbolEnd:
+                return i;
+            case '\0':
+                if (i >= token_buffer.file_size)
                 {
-                    switch (c)
-                    {
-                    NumberStart:
-                        number_buffer[number_buffer_len++] = c;
-                        assert(number_buffer_len + 1 <= number_buffer_max_digits);
-                        c = file_content[++i];
-                        break;
-                        default:
-                            goto end_number;
-                    }
+                    return i;
                 }
-            end_number:
-                end = i;
-                number_buffer[number_buffer_len] = 0;
-                i--;
-                Token* t = token_buffer.new_token(TokenID::IntegerLit, start, end, token_buffer.line_count, start - current_line_start);
-                char* dummy_ptr = nullptr;
-                t->int_lit = strtoull(number_buffer, &dummy_ptr, 10);
                 break;
-            }
-            case '\"':
-            {
-                start = i;
+            default:
+                break;
+        }
+    }
+}
 
-                do
-                {
-                    c = file_content[++i];
-                } while (c != '\"');
+// @Info: this covers every character an integer literal can have (digits, separators, prefixes and hexadecimal digits), so a
+// literal followed by letters is reported as a whole instead of being split in two tokens
+static inline s64 find_number_end(TokenBuffer& token_buffer, s64 i)
+{
+    const char* file = token_buffer.file;
+#if LEXER_SIMD_WIDTH
+    while (i + LEXER_SIMD_WIDTH <= token_buffer.file_size)
+    {
+        CharBlock block = load_block(&file[i]);
+        CharBlock literal_chars = block_or(block_in_range(block, '0', '9'), block_equal(block, '_'));
+        literal_chars = block_or(literal_chars, block_or(block_in_range(block, 'a', 'z'), block_in_range(block, 'A', 'Z')));
+        u32 end_mask = ~block_mask(literal_chars) & char_block_full_mask;
+        if (end_mask)
+        {
+            return i + count_trailing_zeros(end_mask);
+        }
 
-                end = i + 1;
-                Token* t = token_buffer.new_token(TokenID::StringLit, start, end, token_buffer.line_count, start - current_line_start);
-                s64 string_len = (i - (start + 1));
-                t->str_lit = token_buffer.sb.append(&token_buffer.file[start], string_len);
-                break;
-            }
-            case '\'':
-            {
-                start = i;
-                char char_lit = file_content[++i];
-                end = ++i;
+        i += LEXER_SIMD_WIDTH;
+    }
+#endif
 
-                Token* t = token_buffer.new_token(TokenID::CharLit, start, end, token_buffer.line_count, start - current_line_start);
-                t->char_lit = char_lit;
-                break;
-            }
-            case '\0':
-                break;
-            case '\t':
-            case '\r':
-                assert(false);
+    for (;; i++)
+    {
+        switch (file[i])
+        {
+            SymbolStart:
+            DecimalDigits:
                 break;
             default:
-                (void)token_buffer.new_token(static_cast<TokenID>(c), (start = i), (end = (i + 1)), token_buffer.line_count, i - current_line_start);
-                break;
+                return i;
+        }
+    }
+}
+
+LineIndex LineIndex::create(Allocator* allocator, RNS::String file, Arena* arena)
+{
+    LineIndex line_index = {
+        .file = file.ptr,
+        .file_size = file.len,
+        .allocator = allocator,
+        .arena = arena,
+    };
+
+    return line_index;
+}
+
+static s64 count_newlines(const char* file, s64 file_size)
+{
+    s64 newline_count = 0;
+    s64 i = 0;
+#if LEXER_SIMD_WIDTH
+    for (; i + LEXER_SIMD_WIDTH <= file_size; i += LEXER_SIMD_WIDTH)
+    {
+        newline_count += pop_count(block_mask(block_equal(load_block(&file[i]), '\n')));
+    }
+#endif
+    for (; i < file_size; i++)
+    {
+        newline_count += file[i] == '\n';
+    }
+
+    return newline_count;
+}
+
+void LineIndex::build()
+{
+    line_count = count_newlines(file, file_size) + 1;
+    if (arena)
+    {
+        arena->reserve(line_count * sizeof(u32));
+    }
+    line_starts = new(allocator) u32[line_count];
+
+    s64 line = 0;
+    line_starts[line++] = 0;
+    s64 i = 0;
+#if LEXER_SIMD_WIDTH
+    for (; i + LEXER_SIMD_WIDTH <= file_size; i += LEXER_SIMD_WIDTH)
+    {
+        u32 newline_mask = block_mask(block_equal(load_block(&file[i]), '\n'));
+        while (newline_mask)
+        {
+            line_starts[line++] = static_cast<u32>(i + count_trailing_zeros(newline_mask) + 1);
+            newline_mask &= newline_mask - 1;
+        }
+    }
+#endif
+    for (; i < file_size; i++)
+    {
+        if (file[i] == '\n')
+        {
+            line_starts[line++] = static_cast<u32>(i + 1);
+        }
+    }
+    assert(line == line_count);
+}
+
+SourceLocation LineIndex::get_location(u32 offset)
+{
+    if (!line_starts)
+    {
+        build();
+    }
+
+    // @Info: find the last line starting at or before the offset
+    s64 low = 0;
+    s64 high = line_count;
+    while (high - low > 1)
+    {
+        s64 middle = low + (high - low) / 2;
+        if (line_starts[middle] <= offset)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle;
         }
     }
-    token_buffer.line_count++;
 
-    return { token_buffer.ptr, token_buffer.len };
+    return { .line = static_cast<u32>(low), .column = offset - line_starts[low] };
+}
+
+/* Integer literals
+ * Literals are decimal, hexadecimal with a 0x prefix or binary with a 0b prefix, and any of their digits can be separated by '_'.
+ * They are decoded in place: whenever eight digits in a row are left they are checked and combined at once with SWAR arithmetic
+ * (SIMD within a register) on a single 64-bit load, and separators and the tail of the literal go digit by digit.
+ * Every step checks for overflow before accumulating, so a literal which doesn't fit in 64 bits is an error instead of wrapping.
+ */
+const u64 swar_ones = 0x0101010101010101;
+const u64 swar_high_bits = 0x8080808080808080;
+
+static inline u64 load_eight_chars(const char* ptr)
+{
+    // @Info: the first char ends up in the lowest byte, we only target little endian
+    u64 chunk;
+    memcpy(&chunk, ptr, sizeof(chunk));
+    return chunk;
+}
+
+// @Info: high bit of every byte set if low < byte < high, only valid for bytes under 0x80
+static inline u64 swar_between(u64 chunk, u8 low, u8 high)
+{
+    return ((swar_ones * (127 + high) - chunk) & ~chunk & (chunk + swar_ones * (127 - low))) & swar_high_bits;
+}
+
+static inline bool is_eight_decimal_digits(u64 chunk)
+{
+    return (((chunk + swar_ones * 0x46) | (chunk - swar_ones * '0')) & swar_high_bits) == 0;
+}
+
+static inline u64 parse_eight_decimal_digits(u64 chunk)
+{
+    chunk -= swar_ones * '0';
+    // @Info: pairs of digits into 16-bit lanes, then pairs of lanes into 32-bit ones
+    chunk = (chunk * 10) + (chunk >> 8);
+    const u64 mask = 0x000000FF000000FF;
+    const u64 multiplier_high = 100 + (1000000ull << 32);
+    const u64 multiplier_low = 1 + (10000ull << 32);
+    return (((chunk & mask) * multiplier_high) + (((chunk >> 16) & mask) * multiplier_low)) >> 32;
+}
+
+static inline bool is_eight_hexadecimal_digits(u64 chunk)
+{
+    // @Info: or-ing 0x20 lowercases the letters and leaves the digits as they are
+    u64 lowercase = chunk | (swar_ones * 0x20);
+    u64 valid = swar_between(lowercase, '0' - 1, '9' + 1) | swar_between(lowercase, 'a' - 1, 'f' + 1);
+    return (chunk & swar_high_bits) == 0 && valid == swar_high_bits;
+}
+
+static inline u64 parse_eight_hexadecimal_digits(u64 chunk)
+{
+    // @Info: the low nibble of '0'-'9' is its value, letters have bit 6 set and their low nibble is their value minus 9
+    u64 nibbles = (chunk & (swar_ones * 0x0F)) + 9 * ((chunk >> 6) & swar_ones);
+    // @Info: the first char is the most significant digit, so the lower byte of every pair goes on top
+    u64 bytes = ((nibbles & 0x000F000F000F000F) << 4) | ((nibbles & 0x0F000F000F000F00) >> 8);
+    u64 halfwords = ((bytes & 0x000000FF000000FF) << 8) | ((bytes & 0x00FF000000FF0000) >> 16);
+    return ((halfwords & 0x000000000000FFFF) << 16) | ((halfwords & 0x0000FFFF00000000) >> 32);
+}
+
+static inline bool is_eight_binary_digits(u64 chunk)
+{
+    return (chunk & ~swar_ones) == swar_ones * '0';
+}
+
+static inline u64 parse_eight_binary_digits(u64 chunk)
+{
+    // @Info: every bit lands in the top byte, the first char on the highest bit
+    return ((chunk & swar_ones) * 0x8040201008040201) >> 56;
+}
+
+static inline u32 get_digit_value(char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+
+    char lowercase = c | 0x20;
+    if (lowercase >= 'a' && lowercase <= 'z')
+    {
+        return lowercase - 'a' + 10;
+    }
+
+    return UINT32_MAX;
+}
+
+// @Info: returns the error message, or nullptr on success
+static const char* decode_integer_literal(const char* literal, s64 len, u64* value)
+{
+    u32 base = 10;
+    s64 i = 0;
+    if (len >= 2 && literal[0] == '0')
+    {
+        switch (literal[1] | 0x20)
+        {
+            case 'x':
+                base = 16;
+                i = 2;
+                break;
+            case 'b':
+                base = 2;
+                i = 2;
+                break;
+            default:
+                break;
+        }
+    }
+
+    u64 result = 0;
+    bool has_digits = false;
+    while (i < len)
+    {
+        if (i + 8 <= len)
+        {
+            u64 chunk = load_eight_chars(&literal[i]);
+            switch (base)
+            {
+                case 10:
+                    if (is_eight_decimal_digits(chunk))
+                    {
+                        const u64 eight_digit_base = 100000000;
+                        u64 digits = parse_eight_decimal_digits(chunk);
+                        if (result > UINT64_MAX / eight_digit_base || result * eight_digit_base > UINT64_MAX - digits)
+                        {
+                            return "Integer literal is too large";
+                        }
+                        result = result * eight_digit_base + digits;
+                        has_digits = true;
+                        i += 8;
+                        continue;
+                    }
+                    break;
+                case 16:
+                    if (is_eight_hexadecimal_digits(chunk))
+                    {
+                        if (result >> 32)
+                        {
+                            return "Integer literal is too large";
+                        }
+                        result = (result << 32) | parse_eight_hexadecimal_digits(chunk);
+                        has_digits = true;
+                        i += 8;
+                        continue;
+                    }
+                    break;
+                case 2:
+                    if (is_eight_binary_digits(chunk))
+                    {
+                        if (result >> 56)
+                        {
+                            return "Integer literal is too large";
+                        }
+                        result = (result << 8) | parse_eight_binary_digits(chunk);
+                        has_digits = true;
+                        i += 8;
+                        continue;
+                    }
+                    break;
+                default:
+                    RNS_UNREACHABLE;
+                    break;
+            }
+        }
+
+        char c = literal[i++];
+        if (c == '_')
+        {
+            continue;
+        }
+
+        u32 digit = get_digit_value(c);
+        if (digit >= base)
+        {
+            return "Invalid digit in integer literal";
+        }
+        if (result > (UINT64_MAX - digit) / base)
+        {
+            return "Integer literal is too large";
+        }
+        result = result * base + digit;
+        has_digits = true;
+    }
+
+    if (!has_digits)
+    {
+        return "Integer literal has no digits";
+    }
+
+    *value = result;
+    return nullptr;
+}
+
+/* Float literals
+ * Decimal float literals have a fractional part, an exponent or both (1.5, 2e-3, 6.02e23). Hexadecimal ones have a binary exponent
+ * (0x1.8p3). Like integer literals, their digits can be separated by '_'.
+ * Decimal literals are converted with the Eisel-Lemire algorithm. The first 19 significant digits become a 64-bit mantissa w, which
+ * is multiplied by the 128-bit approximation of 5^q from power_of_five_table.h. The top bits of that product are the correctly
+ * rounded binary mantissa, and the few halfway cases are detected exactly. When the literal has more than 19 significant digits,
+ * w and w + 1 bracket its value, so if both round to the same float that float is the answer. Only when they don't do we fall back
+ * to the C library, which in practice doesn't happen for literals written by people or by our generators.
+ * Hexadecimal literals are exact in binary, so they are rounded to nearest even directly.
+ * Literals are always rounded straight to their target format. An f32 literal is never rounded to f64 first, which would round twice.
+ * @Info: there is no Clinger fast path (exact mantissa times an exact power of ten) since the optimized builds use /fp:fast, which
+ * doesn't guarantee a correctly rounded division.
+ */
+struct FloatFormat
+{
+    u32 mantissa_bits; // explicit ones, without the implicit leading bit
+    s32 minimum_exponent;
+    s32 infinite_power;
+    s32 smallest_power_of_ten; // below this, any 64-bit mantissa rounds to zero
+    s32 largest_power_of_ten; // above this, any mantissa rounds to infinity
+    s32 min_exponent_round_to_even;
+    s32 max_exponent_round_to_even;
+};
+
+const FloatFormat f64_format = { 52, -1023, 0x7FF, -342, 308, -4, 23 };
+const FloatFormat f32_format = { 23, -127, 0xFF, -65, 38, -17, 10 };
+const u32 float_literal_max_significant_digits = 19;
+
+struct Product128
+{
+    u64 low;
+    u64 high;
+};
+
+static inline Product128 multiply_full(u64 a, u64 b)
+{
+#if defined(_MSC_VER)
+    Product128 product;
+    product.low = _umul128(a, b, &product.high);
+    return product;
+#else
+    unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    return { static_cast<u64>(product), static_cast<u64>(product >> 64) };
+#endif
+}
+
+static inline u32 count_leading_zeros64(u64 value)
+{
+    assert(value);
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return 63 - index;
+#else
+    return __builtin_clzll(value);
+#endif
+}
+
+static inline u32 count_trailing_zeros64(u64 value)
+{
+    assert(value);
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return index;
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+
+// @Info: mantissa without the implicit bit, and the biased exponent
+struct AdjustedMantissa
+{
+    u64 mantissa;
+    s32 power2;
+};
+
+static AdjustedMantissa eisel_lemire(s64 q, u64 w, const FloatFormat& format)
+{
+    if (w == 0 || q < format.smallest_power_of_ten)
+    {
+        return { 0, 0 };
+    }
+    if (q > format.largest_power_of_ten)
+    {
+        return { 0, format.infinite_power };
+    }
+
+    u32 leading_zeros = count_leading_zeros64(w);
+    w <<= leading_zeros;
+
+    // @Info: mantissa_bits + 3 bits of the product are enough to round correctly, the low half of the power is only needed when
+    // the first product is too close to call
+    const u64 precision_mask = UINT64_MAX >> (format.mantissa_bits + 3);
+    s64 index = 2 * (q - power_of_five_min_exponent);
+    Product128 product = multiply_full(w, power_of_five_128[index]);
+    if ((product.high & precision_mask) == precision_mask)
+    {
+        Product128 low_product = multiply_full(w, power_of_five_128[index + 1]);
+        product.low += low_product.high;
+        if (low_product.high > product.low)
+        {
+            product.high++;
+        }
+    }
+
+    u32 upper_bit = static_cast<u32>(product.high >> 63);
+    u32 shift = upper_bit + 64 - format.mantissa_bits - 3;
+    AdjustedMantissa result = {
+        .mantissa = product.high >> shift,
+        // @Info: ((152170 + 65536) * q) >> 16 is floor(log2(10^q)) for the whole range of the table
+        .power2 = static_cast<s32>((((152170 + 65536) * q) >> 16) + 63 + upper_bit - leading_zeros - format.minimum_exponent),
+    };
+
+    if (result.power2 <= 0)
+    {
+        // @Info: subnormal, or zero if even the implicit bit is shifted out
+        if (-result.power2 + 1 >= 64)
+        {
+            return { 0, 0 };
+        }
+        result.mantissa >>= -result.power2 + 1;
+        result.mantissa += result.mantissa & 1;
+        result.mantissa >>= 1;
+        result.power2 = result.mantissa < (1ull << format.mantissa_bits) ? 0 : 1;
+        return result;
+    }
+
+    // @Info: exact halfway cases can only happen for small powers of ten, and those round to even
+    if (product.low <= 1 && q >= format.min_exponent_round_to_even && q <= format.max_exponent_round_to_even && (result.mantissa & 3) == 1)
+    {
+        if ((result.mantissa << shift) == product.high)
+        {
+            result.mantissa &= ~1ull;
+        }
+    }
+
+    result.mantissa += result.mantissa & 1;
+    result.mantissa >>= 1;
+    if (result.mantissa >= (2ull << format.mantissa_bits))
+    {
+        result.mantissa = 1ull << format.mantissa_bits;
+        result.power2++;
+    }
+    result.mantissa &= ~(1ull << format.mantissa_bits);
+
+    if (result.power2 >= format.infinite_power)
+    {
+        return { 0, format.infinite_power };
+    }
+
+    return result;
+}
+
+static inline f64 float_from_bits(u64 bits, const FloatFormat& format)
+{
+    if (format.mantissa_bits == f32_format.mantissa_bits)
+    {
+        u32 bits32 = static_cast<u32>(bits);
+        f32 result;
+        memcpy(&result, &bits32, sizeof(result));
+        return result;
+    }
+
+    f64 result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+// @Info: huge exponents saturate instead of overflowing, the result is zero or out of range long before that
+static const char* parse_float_exponent(const char* literal, s64 len, s64* i, s64* exponent)
+{
+    bool negative = false;
+    if (*i < len && (literal[*i] == '+' || literal[*i] == '-'))
+    {
+        negative = literal[*i] == '-';
+        (*i)++;
+    }
+
+    s64 result = 0;
+    bool has_digits = false;
+    for (; *i < len; (*i)++)
+    {
+        char c = literal[*i];
+        if (c == '_')
+        {
+            continue;
+        }
+        if (c < '0' || c > '9')
+        {
+            break;
+        }
+        if (result < 1000000)
+        {
+            result = result * 10 + (c - '0');
+        }
+        has_digits = true;
+    }
+
+    if (!has_digits)
+    {
+        return "Float literal exponent has no digits";
+    }
+
+    *exponent = negative ? -result : result;
+    return nullptr;
+}
+
+static const char* decode_float_literal_slow(const char* literal, s64 len, const FloatFormat& format, f64* value)
+{
+    // @Info: the C library wants the literal without separators and null-terminated
+    const s64 buffer_size = 1024;
+    char buffer[buffer_size];
+    s64 buffer_len = 0;
+    for (s64 i = 0; i < len; i++)
+    {
+        if (literal[i] != '_')
+        {
+            if (buffer_len + 1 >= buffer_size)
+            {
+                return "Float literal is too long";
+            }
+            buffer[buffer_len++] = literal[i];
+        }
+    }
+    buffer[buffer_len] = 0;
+
+    if (format.mantissa_bits == f32_format.mantissa_bits)
+    {
+        f32 result = strtof(buffer, nullptr);
+        if (result > FLT_MAX)
+        {
+            return "Float literal is out of range";
+        }
+        *value = result;
+    }
+    else
+    {
+        f64 result = strtod(buffer, nullptr);
+        if (result > DBL_MAX)
+        {
+            return "Float literal is out of range";
+        }
+        *value = result;
+    }
+
+    return nullptr;
+}
+
+static const char* decode_hexadecimal_float_literal(const char* literal, s64 len, const FloatFormat& format, f64* value)
+{
+    // @Info: the first 60 bits of digits are kept, the ones after that only matter for rounding
+    u64 mantissa = 0;
+    s64 exponent = 0;
+    bool sticky = false;
+    bool fraction = false;
+    bool has_digits = false;
+    s64 i = 2;
+    for (; i < len; i++)
+    {
+        char c = literal[i];
+        if (c == '_')
+        {
+            continue;
+        }
+        if (c == '.' && !fraction)
+        {
+            fraction = true;
+            continue;
+        }
+
+        u32 digit = get_digit_value(c);
+        if (digit >= 16)
+        {
+            break;
+        }
+        has_digits = true;
+        if (mantissa >> 60 == 0)
+        {
+            mantissa = (mantissa << 4) | digit;
+            exponent -= fraction ? 4 : 0;
+        }
+        else
+        {
+            sticky |= digit != 0;
+            exponent += fraction ? 0 : 4;
+        }
+    }
+
+    if (!has_digits)
+    {
+        return "Float literal has no digits";
+    }
+    if (i >= len || (literal[i] | 0x20) != 'p')
+    {
+        return "Hexadecimal float literal requires a 'p' exponent";
+    }
+
+    s64 binary_exponent;
+    i++;
+    if (const char* error_message = parse_float_exponent(literal, len, &i, &binary_exponent))
+    {
+        return error_message;
+    }
+    if (i != len)
+    {
+        return "Invalid digit in float literal";
+    }
+    exponent += binary_exponent;
+
+    if (mantissa == 0)
+    {
+        *value = 0;
+        return nullptr;
+    }
+
+    u32 leading_zeros = count_leading_zeros64(mantissa);
+    mantissa <<= leading_zeros;
+    exponent -= leading_zeros;
+
+    // @Info: the value is mantissa * 2^exponent with the top bit of the mantissa set, so its leading bit weighs 2^(exponent + 63)
+    s64 biased_exponent = exponent + 63 - format.minimum_exponent;
+    s64 shift = 63 - format.mantissa_bits;
+    if (biased_exponent <= 0)
+    {
+        shift += 1 - biased_exponent;
+    }
+    if (shift > 64)
+    {
+        // @Info: less than half the smallest subnormal
+        *value = 0;
+        return nullptr;
+    }
+
+    u64 kept = shift == 64 ? 0 : mantissa >> shift;
+    u64 remainder = shift == 64 ? mantissa : mantissa & ((1ull << shift) - 1);
+    u64 half = 1ull << (shift - 1);
+    if (remainder > half || (remainder == half && (sticky || (kept & 1))))
+    {
+        kept++;
+    }
+
+    u64 bits;
+    if (biased_exponent <= 0)
+    {
+        // @Info: a subnormal which rounds up to the smallest normal number gets its exponent bit from the carry
+        bits = kept;
+    }
+    else
+    {
+        if (kept >> (format.mantissa_bits + 1))
+        {
+            kept >>= 1;
+            biased_exponent++;
+        }
+        if (biased_exponent >= format.infinite_power)
+        {
+            return "Float literal is out of range";
+        }
+        bits = (kept & ((1ull << format.mantissa_bits) - 1)) | (static_cast<u64>(biased_exponent) << format.mantissa_bits);
+    }
+
+    *value = float_from_bits(bits, format);
+    return nullptr;
+}
+
+const char* decode_float_literal(const char* literal, s64 len, u16 bits, f64* value)
+{
+    assert(bits == 32 || bits == 64);
+    const FloatFormat& format = bits == 32 ? f32_format : f64_format;
+    if (len >= 2 && literal[0] == '0' && (literal[1] | 0x20) == 'x')
+    {
+        return decode_hexadecimal_float_literal(literal, len, format, value);
+    }
+
+    u64 mantissa = 0;
+    s64 digit_count = 0;
+    s64 exponent = 0;
+    bool truncated = false;
+    bool fraction = false;
+    s64 i = 0;
+    while (i < len)
+    {
+        if (i + 8 <= len && digit_count + 8 <= float_literal_max_significant_digits)
+        {
+            u64 chunk = load_eight_chars(&literal[i]);
+            if (is_eight_decimal_digits(chunk))
+            {
+                // @Info: leading zeros are not significant, the first char is in the lowest byte
+                u64 digit_bytes = chunk - swar_ones * '0';
+                digit_count += mantissa ? 8 : (digit_bytes ? 8 - count_trailing_zeros64(digit_bytes) / 8 : 0);
+                mantissa = mantissa * 100000000 + parse_eight_decimal_digits(chunk);
+                exponent -= fraction ? 8 : 0;
+                i += 8;
+                continue;
+            }
+        }
+
+        char c = literal[i];
+        if (c == '_')
+        {
+            i++;
+            continue;
+        }
+        if (c == '.' && !fraction)
+        {
+            fraction = true;
+            i++;
+            continue;
+        }
+        if (c < '0' || c > '9')
+        {
+            break;
+        }
+        i++;
+
+        if (digit_count < float_literal_max_significant_digits)
+        {
+            mantissa = mantissa * 10 + (c - '0');
+            digit_count += mantissa != 0;
+            exponent -= fraction;
+        }
+        else
+        {
+            truncated |= c != '0';
+            exponent += !fraction;
+        }
+    }
+
+    if (i < len && (literal[i] | 0x20) == 'e')
+    {
+        s64 decimal_exponent;
+        i++;
+        if (const char* error_message = parse_float_exponent(literal, len, &i, &decimal_exponent))
+        {
+            return error_message;
+        }
+        exponent += decimal_exponent;
+    }
+    if (i != len)
+    {
+        return "Invalid digit in float literal";
+    }
+
+    AdjustedMantissa result = eisel_lemire(exponent, mantissa, format);
+    if (truncated)
+    {
+        AdjustedMantissa upper_bound = eisel_lemire(exponent, mantissa + 1, format);
+        if (upper_bound.mantissa != result.mantissa || upper_bound.power2 != result.power2)
+        {
+            return decode_float_literal_slow(literal, len, format, value);
+        }
+    }
+
+    if (result.power2 == format.infinite_power)
+    {
+        return "Float literal is out of range";
+    }
+
+    *value = float_from_bits(result.mantissa | (static_cast<u64>(result.power2) << format.mantissa_bits), format);
+    return nullptr;
+}
+
+static inline bool is_float_literal(const char* literal, s64 len)
+{
+    bool is_hexadecimal = len >= 2 && literal[0] == '0' && (literal[1] | 0x20) == 'x';
+    bool is_binary = len >= 2 && literal[0] == '0' && (literal[1] | 0x20) == 'b';
+    for (s64 i = 0; i < len; i++)
+    {
+        char c = literal[i] | 0x20;
+        if (literal[i] == '.' || (is_hexadecimal && c == 'p') || (!is_hexadecimal && !is_binary && c == 'e'))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// @Info: extends a literal which find_number_end stopped at a '.' or at the sign of an exponent
+static inline s64 find_float_literal_end(TokenBuffer& token_buffer, s64 start, s64 end)
+{
+    const char* file = token_buffer.file;
+    bool is_hexadecimal = end - start >= 2 && file[start] == '0' && (file[start + 1] | 0x20) == 'x';
+
+    // @Info: a '.' has to be followed by a digit to belong to the literal, so member accesses and ranges are left alone
+    if (file[end] == '.' && get_digit_value(file[end + 1]) < (is_hexadecimal ? 16u : 10u))
+    {
+        end = find_number_end(token_buffer, end + 1);
+    }
+
+    char exponent_char = file[end - 1] | 0x20;
+    if ((exponent_char == (is_hexadecimal ? 'p' : 'e')) && (file[end] == '+' || file[end] == '-') && get_digit_value(file[end + 1]) < 10)
+    {
+        end = find_number_end(token_buffer, end + 1);
+    }
+
+    return end;
+}
+
+/* Lexes the tokens which start in [i, lex_end), or until token_limit tokens are in the buffer.
+ * Returns the offset where lexing stopped, which is past lex_end when the last token runs over it, or the offset of the error if there is one.
+ * It never asserts on the input: the parallel lexer runs it speculatively on ranges which may start in the middle of a literal.
+ */
+static s64 lex_range(TokenBuffer& token_buffer, SymbolTable& symbols, TypeBuffer& type_declarations, s64 i)
+{
+    const char* file = token_buffer.file;
+
+    auto error = [&](s64 offset, const char* message)
+    {
+        token_buffer.error_offset = offset;
+        token_buffer.error_message = message;
+        return offset;
+    };
+
+    for (; i < token_buffer.lex_end && token_buffer.tokens.len < token_buffer.token_limit; i++)
+    {
+        i = skip_blanks(token_buffer, i);
+        if (i >= token_buffer.lex_end)
+        {
+            break;
+        }
+
+        char c = file[i];
+        s64 start;
+        s64 end;
+
+        switch (c)
+        {
+            SymbolStart:
+            {
+                start = i;
+                end = find_symbol_end(token_buffer, i + 1);
+                i = end - 1;
+                auto len = end - start;
+                const char* string_view_ptr = &file[start];
+                StringView name = StringView::create(string_view_ptr, len);
+                auto match = match_name(name, type_declarations);
+                TokenValue* t = token_buffer.new_token(match.token_id, start, end);
+                switch (match.token_id)
+                {
+                    case TokenID::Keyword:
+                        t->keyword = match.keyword;
+                        break;
+                    case TokenID::Type:
+                        t->type = match.type;
+                        break;
+                        // @TODO: intrinsics should not be names at all, they should go under the intrinsic character (presumably '@'?) switch case
+                    case TokenID::Intrinsic:
+                        t->intrinsic = match.intrinsic;
+                        break;
+                    case TokenID::Symbol:
+                        t->symbol = symbols.intern(&file[start], len);
+                        break;
+                    default:
+                        RNS_UNREACHABLE;
+                        break;
+                }
+                break;
+            }
+            NumberStart:
+            {
+                start = i;
+                end = find_float_literal_end(token_buffer, start, find_number_end(token_buffer, i + 1));
+                i = end - 1;
+                if (is_float_literal(&file[start], end - start))
+                {
+                    // @Info: float literals are f64 until their type is known, the parser decodes them again for f32
+                    f64 float_lit;
+                    if (const char* error_message = decode_float_literal(&file[start], end - start, 64, &float_lit))
+                    {
+                        return error(start, error_message);
+                    }
+                    TokenValue* t = token_buffer.new_token(TokenID::FloatLit, start, end);
+                    t->float_lit = float_lit;
+                    break;
+                }
+
+                u64 int_lit;
+                if (const char* error_message = decode_integer_literal(&file[start], end - start, &int_lit))
+                {
+                    return error(start, error_message);
+                }
+                TokenValue* t = token_buffer.new_token(TokenID::IntegerLit, start, end);
+                t->int_lit = int_lit;
+                break;
+            }
+            case '\"':
+            {
+                start = i;
+
+                do
+                {
+                    c = file[++i];
+                } while (c != '\"' && i < token_buffer.file_size);
+
+                if (i >= token_buffer.file_size)
+                {
+                    return error(start, "Unterminated string literal");
+                }
+
+                end = i + 1;
+                TokenValue* t = token_buffer.new_token(TokenID::StringLit, start, end);
+                s64 string_len = (i - (start + 1));
+                t->str_lit = token_buffer.append_string(&file[start], string_len);
+                break;
+            }
+            case '\'':
+            {
+                start = i;
+                char char_lit = file[++i];
+                end = ++i;
+
+                TokenValue* t = token_buffer.new_token(TokenID::CharLit, start, end);
+                t->char_lit = char_lit;
+                break;
+            }
+            case '\0':
+                break;
+            case '\t':
+            case '\r':
+                return error(i, "Unexpected character");
+            default:
+                (void)token_buffer.new_token(static_cast<TokenID>(c), (start = i), (end = (i + 1)));
+                break;
+        }
+    }
+
+    return i;
+}
+
+static void report_lexer_error(Compiler& compiler, TokenBuffer& token_buffer)
+{
+    LineIndex line_index = LineIndex::create(&compiler.common_allocator, { token_buffer.file, token_buffer.file_size }, compiler.common_arena);
+    SourceLocation location = line_index.get_location(static_cast<u32>(token_buffer.error_offset));
+    compiler.print_error({}, "%s at line %u, column %u", token_buffer.error_message, location.line + 1, location.column + 1);
+}
+
+/* Parallel lexing
+ * The file is cut into one chunk per hardware thread, right after a newline, and every chunk is lexed speculatively as if nothing
+ * was open at its start, with its own token array, string buffer and symbol table.
+ * The chunks are then validated in order: a chunk is only kept if the previous one stopped exactly at its beginning, which is
+ * what happens when the cut was not inside a literal. Otherwise it is lexed again from where the previous chunk actually stopped.
+ * Finally the local symbols are interned in chunk order, which yields the same ids as lexing serially, and the chunks are copied
+ * into the final array in parallel, rebasing their symbol ids. Token offsets are absolute from the start, so they need no fixing.
+ */
+const s64 parallel_lexing_min_file_size = RNS_MEGABYTE(1);
+const s64 parallel_lexing_min_chunk_size = 256 * 1024;
+const u32 parallel_lexing_max_chunk_count = 64;
+// @Info: room for a suballocator to be aligned, when working out how much the lexer takes from the page allocator
+const s64 lexer_suballocator_alignment = RNS_KILOBYTE(4);
+
+struct LexerChunk
+{
+    TokenBuffer token_buffer;
+    SymbolTable symbols;
+    TypeBuffer* type_declarations;
+    Allocator allocator;
+    s64 begin;
+    s64 stop;
+
+    s64 token_offset;
+    SymbolID* symbol_remap;
+    LexerResult output;
+
+    Thread thread;
+};
+
+static void lex_chunk(void* argument)
+{
+    auto* chunk = static_cast<LexerChunk*>(argument);
+    chunk->stop = lex_range(chunk->token_buffer, chunk->symbols, *chunk->type_declarations, chunk->begin);
+}
+
+static void copy_chunk_tokens(void* argument)
+{
+    auto* chunk = static_cast<LexerChunk*>(argument);
+    auto& tokens = chunk->token_buffer.tokens;
+    auto& output = chunk->output;
+    s64 offset = chunk->token_offset;
+    s64 count = tokens.len;
+
+    memcpy(&output.ids[offset], tokens.ids, count * sizeof(TokenID));
+    memcpy(&output.starts[offset], tokens.starts, count * sizeof(u32));
+    memcpy(&output.lengths[offset], tokens.lengths, count * sizeof(u32));
+    for (s64 i = 0; i < count; i++)
+    {
+        TokenValue value = tokens.values[i];
+        if (tokens.ids[i] == TokenID::Symbol)
+        {
+            value.symbol = chunk->symbol_remap[value.symbol];
+        }
+        output.values[offset + i] = value;
+    }
+}
+
+static void run_chunks(LexerChunk* chunks, u32 chunk_count, ThreadFunction function)
+{
+    // @Info: the calling thread takes the first chunk
+    for (u32 i = 1; i < chunk_count; i++)
+    {
+        if (!chunks[i].thread.start(function, &chunks[i]))
+        {
+            function(&chunks[i]);
+        }
+    }
+
+    function(&chunks[0]);
+
+    for (u32 i = 1; i < chunk_count; i++)
+    {
+        if (chunks[i].thread.handle)
+        {
+            chunks[i].thread.join();
+        }
+    }
+}
+
+const s64 chunk_symbol_table_initial_capacity = 256;
+
+// @Info: a chunk can't hold more distinct identifiers than tokens. Lexing the chunk again keeps the arrays of the table but copies
+// the names once more
+static s64 get_chunk_symbol_table_memory_size(s64 chunk_len)
+{
+    s64 symbol_count = chunk_symbol_table_initial_capacity + TokenBuffer::estimate_token_count(chunk_len);
+    return get_symbol_table_memory_size(symbol_count, chunk_len) + 2 * (chunk_len + symbol_count) + symbol_name_chunk_size;
+}
+
+// @Info: room for the tokens, two string buffers in case the chunk has to be lexed again, and the local symbol table
+static s64 get_chunk_memory_size(s64 chunk_len)
+{
+    s64 chunk_token_count = TokenBuffer::estimate_token_count(chunk_len);
+    return chunk_token_count * token_size + 2 * (128 + chunk_token_count) + get_chunk_symbol_table_memory_size(chunk_len) + RNS_MEGABYTE(1);
+}
+
+static LexerResult lex_parallel(Compiler& compiler, RNS::String file_content, TypeBuffer& type_declarations, u32 chunk_count)
+{
+    LexerChunk chunks[parallel_lexing_max_chunk_count] = {};
+
+    s64 begin = 0;
+    u32 cut_chunk_count = 0;
+    for (u32 i = 0; i < chunk_count && begin < file_content.len; i++)
+    {
+        s64 end = file_content.len;
+        if (i + 1 < chunk_count)
+        {
+            s64 target = file_content.len / chunk_count * (i + 1);
+            if (target > begin)
+            {
+                auto* newline = static_cast<const char*>(memchr(&file_content.ptr[target], '\n', file_content.len - target));
+                end = newline ? (newline - file_content.ptr) + 1 : file_content.len;
+            }
+            else
+            {
+                continue;
+            }
+        }
+
+        auto& chunk = chunks[cut_chunk_count++];
+        s64 chunk_len = end - begin;
+        s64 chunk_token_count = TokenBuffer::estimate_token_count(chunk_len);
+        chunk.allocator = create_suballocator(&compiler.page_allocator, get_chunk_memory_size(chunk_len));
+        chunk.token_buffer = TokenBuffer::create(&chunk.allocator, &chunk.allocator, file_content, chunk_token_count, 64 + chunk_token_count);
+        chunk.token_buffer.lex_end = end;
+        chunk.symbols = SymbolTable::create(&chunk.allocator, chunk_symbol_table_initial_capacity);
+        chunk.type_declarations = &type_declarations;
+        chunk.begin = begin;
+
+        begin = end;
+    }
+
+    run_chunks(chunks, cut_chunk_count, lex_chunk);
+
+    s64 expected_begin = 0;
+    s64 token_count = 0;
+    s64 allocated_size = 0;
+    for (u32 i = 0; i < cut_chunk_count; i++)
+    {
+        auto& chunk = chunks[i];
+        auto& token_buffer = chunk.token_buffer;
+        // @Info: if the previous chunk didn't stop exactly at the cut, it ran past it and this chunk started lexing in the middle of a token
+        if (chunk.begin != expected_begin)
+        {
+            token_buffer.tokens.len = 0;
+            token_buffer.error_offset = -1;
+            token_buffer.sb = StringBuffer::create(&chunk.allocator, 64 + token_buffer.cap);
+            token_buffer.tokens.allocated_size += 64 + token_buffer.cap;
+            chunk.symbols.clear();
+            chunk.stop = expected_begin < token_buffer.lex_end ? lex_range(token_buffer, chunk.symbols, type_declarations, expected_begin) : expected_begin;
+        }
+
+        if (token_buffer.error_offset >= 0)
+        {
+            report_lexer_error(compiler, token_buffer);
+            return {};
+        }
+
+        chunk.token_offset = token_count;
+        token_count += token_buffer.tokens.len;
+
+        chunk.symbol_remap = new(&chunk.allocator) SymbolID[chunk.symbols.len];
+        chunk.symbol_remap[no_symbol] = no_symbol;
+        for (SymbolID symbol = 1; symbol < chunk.symbols.len; symbol++)
+        {
+            Symbol& local_symbol = chunk.symbols.symbols[symbol];
+            chunk.symbol_remap[symbol] = compiler.symbols.intern(local_symbol.name.get(), local_symbol.name.len, local_symbol.hash);
+        }
+        allocated_size += token_buffer.tokens.allocated_size + chunk.symbols.allocated_size + chunk.symbols.len * static_cast<s64>(sizeof(SymbolID));
+
+        expected_begin = chunk.stop;
+    }
+    // @Info: otherwise the token estimate of a chunk was too small
+    assert(expected_begin >= file_content.len);
+
+    Allocator token_allocator = create_suballocator(&compiler.page_allocator, (token_count + 64) * token_size + 1024);
+    LexerResult tokens = TokenBuffer::allocate_tokens(&token_allocator, token_count + 1);
+    tokens.len = token_count;
+    tokens.allocated_size += allocated_size;
+    for (u32 i = 0; i < cut_chunk_count; i++)
+    {
+        chunks[i].output = tokens;
+    }
+
+    run_chunks(chunks, cut_chunk_count, copy_chunk_tokens);
+
+    return tokens;
+}
+
+static LexerResult lex_serial(Compiler& compiler, RNS::String file_content, TypeBuffer& type_declarations)
+{
+    s64 token_count = TokenBuffer::estimate_token_count(file_content.len);
+    Allocator token_allocator = create_suballocator(&compiler.page_allocator, token_count * token_size + 1024);
+    Allocator name_allocator = create_suballocator(&compiler.page_allocator, 64 + token_count + 1024);
+
+    TokenBuffer token_buffer = TokenBuffer::create(&token_allocator, &name_allocator, file_content, token_count, 64 + token_count);
+    s64 stop = lex_range(token_buffer, compiler.symbols, type_declarations, 0);
+    if (token_buffer.error_offset >= 0)
+    {
+        report_lexer_error(compiler, token_buffer);
+        return {};
+    }
+    // @Info: otherwise the token estimate was too small
+    assert(stop >= file_content.len);
+
+    return token_buffer.tokens;
+}
+
+static u32 get_parallel_chunk_count(s64 file_size)
+{
+    if (file_size < parallel_lexing_min_file_size)
+    {
+        return 1;
+    }
+
+    s64 chunk_count = file_size / parallel_lexing_min_chunk_size;
+    u32 thread_count = get_hardware_thread_count();
+    chunk_count = chunk_count < thread_count ? chunk_count : thread_count;
+    chunk_count = chunk_count < parallel_lexing_max_chunk_count ? chunk_count : parallel_lexing_max_chunk_count;
+
+    return static_cast<u32>(chunk_count);
+}
+
+LexerResult lex(Compiler& compiler, RNS::String file_content, TypeBuffer& type_declarations)
+{
+    RNS_PROFILE_FUNCTION();
+    compiler.set_subsystem(Compiler::Subsystem::Lexer);
+    // @Info: token positions are stored as 32-bit offsets
+    assert(file_content.len <= UINT32_MAX);
+
+    u32 chunk_count = get_parallel_chunk_count(file_content.len);
+    LexerResult result = chunk_count > 1 ? lex_parallel(compiler, file_content, type_declarations, chunk_count) : lex_serial(compiler, file_content, type_declarations);
+    // @Info: lines and columns are only needed for diagnostics, so the newline index is built the first time one is asked for
+    result.line_index = LineIndex::create(&compiler.common_allocator, file_content, compiler.common_arena);
+
+    return result;
+}
+
+/* Incremental re-lexing
+ * The lexer keeps no state between tokens, so a token only depends on the text from where it starts to a couple of characters past
+ * where it ends. After an edit, the tokens which end before that are still valid, and so is every old token past the edit as soon as
+ * the lexer starts a token at the same (shifted) place the old one started. Only the damaged region in between is lexed again, one
+ * token at a time until it lands on an old token start. The old tokens after that point are moved if the token count changed and
+ * their offsets are patched in place.
+ */
+// @Info: find_float_literal_end looks at most this many characters past the end of a number to decide where it ends ("1.5", "1e+5")
+const s64 relex_lookahead = 2;
+const s64 relex_initial_token_count = 256;
+// @Info: the string literals of the damaged region, which is usually a line or two, so their storage starts small and grows
+const s64 relex_initial_string_size = 256;
+
+static void move_tokens(LexerResult& dst, s64 dst_index, LexerResult& src, s64 src_index, s64 count)
+{
+    memmove(&dst.ids[dst_index], &src.ids[src_index], count * sizeof(TokenID));
+    memmove(&dst.values[dst_index], &src.values[src_index], count * sizeof(TokenValue));
+    memmove(&dst.starts[dst_index], &src.starts[src_index], count * sizeof(u32));
+    memmove(&dst.lengths[dst_index], &src.lengths[src_index], count * sizeof(u32));
+}
+
+static LexerResult copy_tokens(Allocator* allocator, LexerResult& tokens, s64 token_count)
+{
+    assert(token_count >= tokens.len);
+    LexerResult new_tokens = TokenBuffer::allocate_tokens(allocator, token_count);
+    move_tokens(new_tokens, 0, tokens, 0, tokens.len);
+    new_tokens.len = tokens.len;
+    new_tokens.line_index = tokens.line_index;
+
+    return new_tokens;
+}
+
+static void reallocate_tokens(Compiler& compiler, LexerResult& tokens, s64 token_count)
+{
+    Allocator token_allocator = create_suballocator(&compiler.page_allocator, token_count * token_size + 1024);
+    LexerResult new_tokens = copy_tokens(&token_allocator, tokens, token_count);
+    new_tokens.allocated_size += tokens.allocated_size;
+    tokens = new_tokens;
+}
+
+bool relex(Compiler& compiler, LexerResult& tokens, RNS::String new_file, SourceEdit edit, TypeBuffer& type_declarations)
+{
+    RNS_PROFILE_FUNCTION();
+    compiler.set_subsystem(Compiler::Subsystem::Lexer);
+    assert(new_file.len <= UINT32_MAX);
+    s64 new_edit_end = static_cast<s64>(edit.offset) + edit.inserted_length;
+    assert(new_edit_end <= new_file.len);
+    s64 delta = static_cast<s64>(edit.inserted_length) - edit.removed_length;
+
+    // @Info: the first token the edit may have changed. Token ends are sorted, so it can be found with a binary search
+    s64 low = 0;
+    s64 high = tokens.len;
+    while (low < high)
+    {
+        s64 middle = low + (high - low) / 2;
+        if (static_cast<s64>(tokens.starts[middle]) + tokens.lengths[middle] + relex_lookahead <= edit.offset)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    s64 first_damaged = low;
+    // @Info: only blanks are left between the last valid token and the first damaged one. Lexing can't restart right after the last
+    // valid token, because a char literal ends one character before the closing quote the lexer skips
+    s64 i = edit.offset;
+    if (first_damaged < tokens.len && tokens.starts[first_damaged] < i)
+    {
+        i = tokens.starts[first_damaged];
+    }
+
+    // @Info: the damaged tokens only live until they are copied over the old ones, so they get a block of their own which is freed
+    // afterwards. Their string literals stay with the tokens
+    Allocator damaged_allocator = default_create_allocator(relex_initial_token_count * token_size + 1024);
+    TokenBuffer damaged = TokenBuffer::create(&damaged_allocator, &compiler.page_allocator, new_file, relex_initial_token_count, relex_initial_string_size);
+
+    s64 resync_index = tokens.len;
+    s64 old_candidate = first_damaged;
+    for (;;)
+    {
+        if (damaged.tokens.len + 1 >= damaged.cap)
+        {
+            Allocator new_damaged_allocator = default_create_allocator(2 * damaged.cap * token_size + 1024);
+            LexerResult new_damaged_tokens = copy_tokens(&new_damaged_allocator, damaged.tokens, 2 * damaged.cap);
+            new_damaged_tokens.allocated_size += damaged.tokens.allocated_size - damaged.cap * token_size;
+            default_free_allocator(&damaged_allocator);
+            damaged_allocator = new_damaged_allocator;
+            damaged.tokens = new_damaged_tokens;
+            damaged.cap = new_damaged_tokens.cap;
+        }
+
+        s64 token_index = damaged.tokens.len;
+        damaged.token_limit = token_index + 1;
+        i = lex_range(damaged, compiler.symbols, type_declarations, i);
+        if (damaged.error_offset >= 0)
+        {
+            report_lexer_error(compiler, damaged);
+            default_free_allocator(&damaged_allocator);
+            return false;
+        }
+
+        // @Info: the end of the file was reached without resynchronizing, so every old token after the edit was damaged
+        if (damaged.tokens.len == token_index)
+        {
+            break;
+        }
+
+        s64 new_start = damaged.tokens.starts[token_index];
+        if (new_start >= new_edit_end)
+        {
+            s64 old_start = new_start - delta;
+            while (old_candidate < tokens.len && tokens.starts[old_candidate] < old_start)
+            {
+                old_candidate++;
+            }
+
+            if (old_candidate < tokens.len && tokens.starts[old_candidate] == old_start)
+            {
+                // @Info: this token and all the following ones are already in the old tokens
+                damaged.tokens.len = token_index;
+                resync_index = old_candidate;
+                break;
+            }
+        }
+    }
+
+    s64 kept_count = tokens.len - resync_index;
+    s64 new_len = first_damaged + damaged.tokens.len + kept_count;
+    if (new_len > tokens.cap)
+    {
+        reallocate_tokens(compiler, tokens, new_len + new_len / 2 + relex_initial_token_count);
+    }
+
+    s64 kept_index = first_damaged + damaged.tokens.len;
+    move_tokens(tokens, kept_index, tokens, resync_index, kept_count);
+    move_tokens(tokens, first_damaged, damaged.tokens, 0, damaged.tokens.len);
+    u32 start_delta = static_cast<u32>(delta);
+    for (s64 token_index = kept_index; token_index < new_len; token_index++)
+    {
+        tokens.starts[token_index] += start_delta;
+    }
+    tokens.len = new_len;
+    // @Info: only the string literals are left of what was allocated for the damaged tokens
+    tokens.allocated_size += damaged.tokens.allocated_size - damaged.cap * token_size;
+    default_free_allocator(&damaged_allocator);
+    // @Info: the newline index is built again the next time a location is asked for
+    tokens.line_index = LineIndex::create(&compiler.common_allocator, new_file, compiler.common_arena);
+
+    return true;
+}
+
+// @Info: the string buffer the window starts with. It grows from there on the common arena as literals come
+const s64 token_stream_initial_string_size = RNS_KILOBYTE(4);
+
+TokenStream TokenStream::create(Compiler& compiler, RNS::String file_content, TypeBuffer& type_declarations)
+{
+    assert(file_content.len <= UINT32_MAX);
+
+    TokenStream token_stream = {
+        .compiler = &compiler,
+        .type_declarations = &type_declarations,
+        .line_index = LineIndex::create(&compiler.common_allocator, file_content, compiler.common_arena),
+    };
+
+    Allocator allocator = create_suballocator(&compiler.page_allocator, get_lexer_memory_size() - lexer_suballocator_alignment);
+    token_stream.token_buffer = TokenBuffer::create(&allocator, &compiler.common_allocator, file_content, token_stream_window_size + 1, token_stream_initial_string_size, compiler.common_arena);
+
+    return token_stream;
+}
+
+s64 get_lexer_memory_size()
+{
+    return token_stream_window_size * token_size + RNS_KILOBYTE(64) + lexer_suballocator_alignment;
+}
+
+bool TokenStream::fetch(s64 index, s64 keep_from)
+{
+    if (finished)
+    {
+        return false;
+    }
+    RNS_TRACE_SCOPE("Lex token window");
+
+    auto& tokens = token_buffer.tokens;
+    s64 drop_count = keep_from - first;
+    assert(drop_count >= 0 && drop_count <= tokens.len);
+    s64 keep_count = tokens.len - drop_count;
+    memmove(tokens.ids, &tokens.ids[drop_count], keep_count * sizeof(TokenID));
+    memmove(tokens.values, &tokens.values[drop_count], keep_count * sizeof(TokenValue));
+    memmove(tokens.starts, &tokens.starts[drop_count], keep_count * sizeof(u32));
+    memmove(tokens.lengths, &tokens.lengths[drop_count], keep_count * sizeof(u32));
+    tokens.len = keep_count;
+    first = keep_from;
+    // @Info: the lookahead has to fit in the window
+    assert(index - first < token_buffer.token_limit);
+
+    auto subsystem = compiler->subsystem;
+    compiler->set_subsystem(Compiler::Subsystem::Lexer);
+    lex_offset = lex_range(token_buffer, compiler->symbols, *type_declarations, lex_offset);
+    if (token_buffer.error_offset >= 0)
+    {
+        report_lexer_error(*compiler, token_buffer);
+        finished = true;
+    }
+    else if (lex_offset >= token_buffer.lex_end)
+    {
+        finished = true;
+    }
+    compiler->set_subsystem(subsystem);
+
+    return index < first + tokens.len;
 }
@@ -2,4 +2,154 @@
 #include <RNS/types.h>
 #include <RNS/data_structures.h>
 #include "compiler_types.h"
-LexerResult lex(Compiler& compiler, RNS::String file_content, TypeBuffer& type_declarations);
\ No newline at end of file
+
+// @Info: bytes per token across the arrays of LexerResult
+const s64 token_size = sizeof(TokenID) + sizeof(TokenValue) + 2 * sizeof(u32);
+
+struct TokenBuffer
+{
+    LexerResult tokens;
+    s64 cap;
+    s64 file_size;
+    // @Info: no token starts at or after lex_end. Tokens which start before it are allowed to run past it
+    s64 lex_end;
+    // @Info: lexing also stops once this many tokens are in the buffer, so it can be resumed later from where it stopped
+    s64 token_limit;
+    s64 error_offset;
+    const char* error_message;
+    const char* file;
+    RNS::StringBuffer sb;
+    Allocator* string_allocator;
+    // @Info: set when the string allocator is a growing one
+    Arena* string_arena;
+
+    TokenValue* new_token(TokenID type, u64 start, u32 end)
+    {
+        assert(tokens.len + 1 < cap);
+        s64 index = tokens.len++;
+        tokens.ids[index] = type;
+        tokens.starts[index] = static_cast<u32>(start);
+        tokens.lengths[index] = end - static_cast<u32>(start);
+        return &tokens.values[index];
+    }
+
+    static LexerResult allocate_tokens(Allocator* allocator, s64 token_count)
+    {
+        LexerResult tokens = {
+            .ids = new(allocator) TokenID[token_count],
+            .values = new(allocator) TokenValue[token_count],
+            .starts = new(allocator) u32[token_count],
+            .lengths = new(allocator) u32[token_count],
+            .cap = token_count,
+            .allocated_size = token_count * token_size,
+        };
+
+        return tokens;
+    }
+
+    // @Info: the literals stored so far stay where they are, a literal which doesn't fit goes to a new string buffer twice as big
+    char* append_string(const char* str, s64 len)
+    {
+        if (sb.len + len + 1 > sb.cap)
+        {
+            s64 new_cap = 2 * sb.cap > len + 1 ? 2 * sb.cap : len + 1;
+            if (string_arena)
+            {
+                string_arena->reserve(new_cap);
+            }
+            sb = RNS::StringBuffer::create(string_allocator, new_cap);
+            tokens.allocated_size += new_cap;
+        }
+        return sb.append(str, len);
+    }
+
+    static inline s64 estimate_token_count(s64 source_len)
+    {
+        return 64 + (source_len / 2);
+    }
+
+    static TokenBuffer create(Allocator* token_allocator, Allocator* string_allocator, RNS::String file_content, s64 tokens_to_allocate, s64 chars_to_allocate_in_string_buffer, Arena* string_arena = nullptr)
+    {
+        if (string_arena)
+        {
+            string_arena->reserve(chars_to_allocate_in_string_buffer);
+        }
+        TokenBuffer token_buffer = {
+            .tokens = allocate_tokens(token_allocator, tokens_to_allocate),
+            .cap = tokens_to_allocate,
+            .file_size = file_content.len,
+            .lex_end = file_content.len,
+            .token_limit = tokens_to_allocate - 1,
+            .error_offset = -1,
+            .file = file_content.ptr,
+            .sb = RNS::StringBuffer::create(string_allocator, chars_to_allocate_in_string_buffer),
+            .string_allocator = string_allocator,
+            .string_arena = string_arena,
+        };
+        token_buffer.tokens.allocated_size += chars_to_allocate_in_string_buffer;
+
+        return token_buffer;
+    }
+};
+
+/* Pull-based token stream
+ * Tokens are lexed on demand into a window of token_stream_window_size tokens. When the parser asks for a token past the window,
+ * the tokens it has already moved past are dropped, the ones still ahead of it are moved to the front, and the rest of the window
+ * is filled. Token memory is bounded by the window no matter how big the file is, and lexing and parsing stay interleaved in cache.
+ * The parser only looks a few tokens ahead, so the window just has to be bigger than that lookahead.
+ * Every file goes through the window, however big. The files of a compilation are already parsed in parallel, so lexing one in
+ * parallel chunks would only trade the bound for a token array as big as the file. String literals outlive the window, since the
+ * nodes point to them, and go to the common allocator of the compiler in a string buffer which grows as literals come.
+ */
+const s64 token_stream_window_size = 1024;
+
+struct TokenStream
+{
+    TokenBuffer token_buffer;
+    // @Info: index in the stream of the first token of the window
+    s64 first;
+    s64 lex_offset;
+    bool finished;
+    Compiler* compiler;
+    TypeBuffer* type_declarations;
+    LineIndex line_index;
+
+    static TokenStream create(Compiler& compiler, RNS::String file_content, TypeBuffer& type_declarations);
+    bool fetch(s64 index, s64 keep_from);
+
+    // @Info: true if the token at that index exists. Tokens before keep_from may be dropped to make room
+    inline bool has_token(s64 index, s64 keep_from)
+    {
+        return index < first + token_buffer.tokens.len || fetch(index, keep_from);
+    }
+
+    inline TokenID get_id(s64 index)
+    {
+        return token_buffer.tokens.ids[index - first];
+    }
+
+    inline void get_token(s64 index, Token* token)
+    {
+        token_buffer.tokens.get_token(index - first, token);
+    }
+};
+
+// @Info: the most a TokenStream takes from the page allocator of the compiler, which is the same for any file
+s64 get_lexer_memory_size();
+LexerResult lex(Compiler& compiler, RNS::String file_content, TypeBuffer& type_declarations);
+
+// @Info: removed_length bytes at offset were replaced by inserted_length bytes
+struct SourceEdit
+{
+    u32 offset;
+    u32 removed_length;
+    u32 inserted_length;
+};
+
+// @Info: updates the tokens of a previous lex in place after the edit, only lexing again the part the edit damaged. new_file is the
+// source with the edit applied, which belongs to the caller and has to outlive the tokens like the source of lex does.
+// Returns false on a lexer error, in which case the tokens are left as they were
+bool relex(Compiler& compiler, LexerResult& tokens, RNS::String new_file, SourceEdit edit, TypeBuffer& type_declarations);
+// @Info: converts the text of a float literal to the nearest f32 (bits = 32) or f64 (bits = 64), correctly rounded.
+// Returns the error message, or nullptr on success
+const char* decode_float_literal(const char* literal, s64 len, u16 bits, f64* value);
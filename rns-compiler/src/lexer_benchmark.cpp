@@ -0,0 +1,784 @@
+#include <RNS/types.h>
+#include <RNS/compiler.h>
+#include <RNS/os.h>
+#include <RNS/data_structures.h>
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "compiler_types.h"
+#include "lexer.h"
+
+using namespace RNS;
+
+/* Lexer throughput benchmark
+ * Generates synthetic .rns corpora of the requested sizes and times lex() over each of them. The corpora are made of many
+ * functions with long expressions, deeply nested blocks and a pool of identifiers which grows with the corpus, so the symbol
+ * table sees new names all along the file instead of the same handful over and over.
+ *
+ * Usage: lexer-benchmark [--write] [--check-relex] [--check-floats] [size ...]
+ * Sizes take a K, M or G suffix (64K, 16M, 1G). With --write every corpus is also saved as lexer_benchmark_<size>.rns, so the
+ * same input can be fed to the compiler or to a profiler. With --check-relex every corpus also goes through a series of edits,
+ * and the tokens relex updates after each one have to be the same as the ones lex gives for the whole edited file. With
+ * --check-floats a set of tricky float literals and many random ones are decoded as f32 and f64 first, and have to give the same
+ * bits as strtof and strtod.
+ *
+ * Every size is lexed several times, each time with a fresh compiler so interning starts from an empty symbol table, and the
+ * fastest run is reported. Bytes per token counts what the lexer allocated for the tokens, the string literals and the symbols,
+ * not the corpus itself.
+ */
+
+static u64 get_timestamp_ns()
+{
+#if defined(_WIN32)
+    static LARGE_INTEGER frequency;
+    if (!frequency.QuadPart)
+    {
+        QueryPerformanceFrequency(&frequency);
+    }
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return static_cast<u64>(counter.QuadPart / frequency.QuadPart) * 1000000000ull + static_cast<u64>(counter.QuadPart % frequency.QuadPart) * 1000000000ull / frequency.QuadPart;
+#else
+    timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return static_cast<u64>(time.tv_sec) * 1000000000ull + static_cast<u64>(time.tv_nsec);
+#endif
+}
+
+// @Info: xorshift64, the corpus and the edits only have to be the same from run to run
+static u32 xorshift_random(u64* state, u32 range)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return static_cast<u32>(*state % range);
+}
+
+struct CorpusWriter
+{
+    char* ptr;
+    s64 len;
+    s64 cap;
+    u64 random_state;
+    u32 identifier_count;
+
+    u32 random(u32 range)
+    {
+        return xorshift_random(&random_state, range);
+    }
+
+    void append(const char* str)
+    {
+        s64 str_len = strlen(str);
+        assert(len + str_len < cap);
+        memcpy(&ptr[len], str, str_len);
+        len += str_len;
+    }
+
+    void append_indentation(u32 depth)
+    {
+        for (u32 i = 0; i < depth; i++)
+        {
+            append("    ");
+        }
+    }
+
+    void append_identifier()
+    {
+        static const char* prefixes[] = { "value", "index", "count", "buffer", "node", "result", "offset", "lhs", "rhs", "temp", "accumulator", "element_size" };
+        char identifier[64];
+        snprintf(identifier, sizeof(identifier), "%s_%u", prefixes[random(rns_array_length(prefixes))], random(identifier_count));
+        append(identifier);
+    }
+
+    void append_integer()
+    {
+        char integer[96];
+        u64 value = (static_cast<u64>(random(UINT32_MAX)) << 32) | random(UINT32_MAX);
+        switch (random(8))
+        {
+            case 0: case 1: case 2:
+                snprintf(integer, sizeof(integer), "%u", random(100));
+                break;
+            case 3: case 4:
+                snprintf(integer, sizeof(integer), "%llu", static_cast<unsigned long long>(value));
+                break;
+            case 5:
+                snprintf(integer, sizeof(integer), "0x%016llX", static_cast<unsigned long long>(value));
+                break;
+            case 6:
+                snprintf(integer, sizeof(integer), "%u_%03u_%03u", random(1000), random(1000), random(1000));
+                break;
+            case 7:
+            {
+                char* it = integer;
+                *it++ = '0';
+                *it++ = 'b';
+                for (u32 bit = 0; bit < 32; bit++)
+                {
+                    *it++ = '0' + ((value >> bit) & 1);
+                }
+                *it = 0;
+            } break;
+            default:
+                RNS_UNREACHABLE;
+                break;
+        }
+        append(integer);
+    }
+
+    void append_float()
+    {
+        char float_literal[96];
+        f64 value = static_cast<f64>(random(UINT32_MAX)) / (1 + random(UINT32_MAX));
+        switch (random(4))
+        {
+            case 0: case 1:
+                snprintf(float_literal, sizeof(float_literal), "%u.%u", random(1000), random(1000));
+                break;
+            case 2:
+                snprintf(float_literal, sizeof(float_literal), "%.17g", value);
+                break;
+            case 3:
+                snprintf(float_literal, sizeof(float_literal), "%u.%ue-%u", random(10), random(1000000), random(300));
+                break;
+            default:
+                RNS_UNREACHABLE;
+                break;
+        }
+        // @Info: %.17g may print an integer, keep it a float literal
+        if (!strpbrk(float_literal, ".e"))
+        {
+            strcat(float_literal, ".0");
+        }
+        append(float_literal);
+    }
+
+    void append_type()
+    {
+        static const char* types[] = { "s32", "s64", "u8", "u32", "u64", "bool", "f32", "f64" };
+        append(types[random(rns_array_length(types))]);
+    }
+
+    void append_operand(u32 depth)
+    {
+        switch (random(8))
+        {
+            case 0: case 1: case 2: case 3:
+                append_identifier();
+                break;
+            case 4:
+                append_integer();
+                break;
+            case 5:
+                if (random(2))
+                {
+                    append_integer();
+                }
+                else
+                {
+                    append_float();
+                }
+                break;
+            case 6:
+                append_identifier();
+                append("[");
+                append_operand(depth + 1);
+                append("]");
+                break;
+            case 7:
+                // @Info: function call, the arguments can be whole expressions themselves
+                append("function_");
+                char function_id[16];
+                snprintf(function_id, sizeof(function_id), "%u", random(identifier_count));
+                append(function_id);
+                append("(");
+                for (u32 i = 0, argument_count = random(4); i < argument_count; i++)
+                {
+                    if (i)
+                    {
+                        append(", ");
+                    }
+                    if (depth < 3)
+                    {
+                        append_expression(depth + 1);
+                    }
+                    else
+                    {
+                        append_identifier();
+                    }
+                }
+                append(")");
+                break;
+            default:
+                RNS_UNREACHABLE;
+                break;
+        }
+    }
+
+    void append_expression(u32 depth)
+    {
+        static const char* operators[] = { " + ", " - ", " * ", " / ", " < ", " > ", " == ", " & " };
+        u32 term_count = 1 + random(depth ? 4 : 16);
+        for (u32 i = 0; i < term_count; i++)
+        {
+            if (i)
+            {
+                append(operators[random(rns_array_length(operators))]);
+            }
+            if (depth < 3 && random(6) == 0)
+            {
+                append("(");
+                append_expression(depth + 1);
+                append(")");
+            }
+            else
+            {
+                append_operand(depth);
+            }
+        }
+    }
+
+    void append_block(u32 depth, s64 function_end)
+    {
+        append_indentation(depth - 1);
+        append("{\n");
+        u32 statement_count = 1 + random(6);
+        for (u32 i = 0; i < statement_count && len < function_end; i++)
+        {
+            append_statement(depth, function_end);
+        }
+        append_indentation(depth - 1);
+        append("}\n");
+    }
+
+    void append_statement(u32 depth, s64 function_end)
+    {
+        append_indentation(depth);
+        u32 statement_kind = random(depth < 12 ? 10 : 6);
+        switch (statement_kind)
+        {
+            case 0: case 1: case 2:
+                append_identifier();
+                append(": ");
+                append_type();
+                append(" = ");
+                append_expression(0);
+                append(";\n");
+                break;
+            case 3: case 4:
+                append_identifier();
+                append(" = ");
+                append_expression(0);
+                append(";\n");
+                break;
+            case 5:
+                if (random(2))
+                {
+                    append("print(\"");
+                    append_identifier();
+                    append(" is out of range\", '");
+                    char char_lit[2] = { static_cast<char>('a' + random(26)), 0 };
+                    append(char_lit);
+                    append("');\n");
+                }
+                else
+                {
+                    append("return ");
+                    append_expression(0);
+                    append(";\n");
+                }
+                break;
+            case 6: case 7:
+                append("if (");
+                append_expression(1);
+                append(")\n");
+                append_block(depth + 1, function_end);
+                if (random(2))
+                {
+                    append_indentation(depth);
+                    append("else\n");
+                    append_block(depth + 1, function_end);
+                }
+                break;
+            case 8:
+                append("while (");
+                append_expression(1);
+                append(")\n");
+                append_block(depth + 1, function_end);
+                break;
+            case 9:
+                append("for (");
+                append_identifier();
+                append(": s64 = 0; ");
+                append_identifier();
+                append(" < ");
+                append_operand(1);
+                append("; ");
+                append_identifier();
+                append(" = ");
+                append_identifier();
+                append(" + 1)\n");
+                append_block(depth + 1, function_end);
+                break;
+            default:
+                RNS_UNREACHABLE;
+                break;
+        }
+    }
+
+    void append_function(u32 function_id)
+    {
+        char signature[64];
+        snprintf(signature, sizeof(signature), "function_%u :: (", function_id);
+        append(signature);
+        for (u32 i = 0, argument_count = random(6); i < argument_count; i++)
+        {
+            if (i)
+            {
+                append(", ");
+            }
+            append_identifier();
+            append(": ");
+            append_type();
+        }
+        append(") -> ");
+        append_type();
+        append("\n");
+
+        // @Info: the statements of a function stop once its budget is used up, the blocks which are still open are closed regardless
+        s64 function_end = len + 1024 + random(16 * 1024);
+        append_block(1, function_end);
+        append("\n");
+    }
+};
+
+// @Info: the seed only depends on the size, so a size gives the same corpus and the same edits wherever it is on the command line
+static u64 get_corpus_seed(s64 size)
+{
+    return (0x9E3779B97F4A7C15ull ^ static_cast<u64>(size)) * 0xFF51AFD7ED558CCDull;
+}
+
+static String generate_corpus(Allocator* allocator, s64 size, u64 seed)
+{
+    // @Info: room for the function that crosses the requested size and for the '\0' sentinel the lexer expects
+    const s64 slack = RNS_MEGABYTE(1);
+    CorpusWriter writer = {
+        .ptr = new(allocator) char[size + slack],
+        .len = 0,
+        .cap = size + slack,
+        .random_state = seed | 1,
+        // @Info: the identifier suffixes scale with the corpus, so bigger corpora stress the symbol table with more names
+        .identifier_count = static_cast<u32>(16 + size / 1024),
+    };
+
+    for (u32 function_id = 0; writer.len < size; function_id++)
+    {
+        writer.append_function(function_id);
+    }
+    writer.ptr[writer.len] = 0;
+
+    return { writer.ptr, writer.len };
+}
+
+static s64 parse_size(const char* arg)
+{
+    char* suffix = nullptr;
+    s64 size = strtoll(arg, &suffix, 10);
+    switch (*suffix)
+    {
+        case 'k': case 'K':
+            return RNS_KILOBYTE(size);
+        case 'm': case 'M':
+            return RNS_MEGABYTE(size);
+        case 'g': case 'G':
+            return RNS_GIGABYTE(size);
+        case 0:
+            return size;
+        default:
+            return 0;
+    }
+}
+
+static bool write_corpus(String corpus, const char* arg)
+{
+    char filename[128];
+    snprintf(filename, sizeof(filename), "lexer_benchmark_%s.rns", arg);
+    FILE* file = fopen(filename, "wb");
+    if (!file)
+    {
+        printf("Couldn't open file %s\n", filename);
+        return false;
+    }
+    bool result = fwrite(corpus.ptr, 1, corpus.len, file) == static_cast<usize>(corpus.len);
+    fclose(file);
+    if (!result)
+    {
+        printf("Couldn't write file %s\n", filename);
+    }
+
+    return result;
+}
+
+struct BenchmarkResult
+{
+    u64 best_time_ns;
+    s64 token_count;
+    s64 allocated_size;
+    u32 run_count;
+};
+
+static bool benchmark_lexer(String corpus, BenchmarkResult* result)
+{
+    // @Info: repeat small corpora so the timer resolution and the first touch of the allocator pages don't dominate the result
+    s64 run_count = RNS_MEGABYTE(256) / (corpus.len + 1);
+    run_count = run_count < 1 ? 1 : (run_count > 20 ? 20 : run_count);
+    *result = { .best_time_ns = UINT64_MAX, .run_count = static_cast<u32>(run_count) };
+
+    for (s64 run = 0; run < run_count; run++)
+    {
+        Compiler compiler = {
+            .page_allocator = default_create_allocator(14 * corpus.len + RNS_MEGABYTE(256)),
+            // @Info: the symbol table lives here and keeps the arrays it grows out of
+            .common_allocator = create_suballocator(&compiler.page_allocator, 2 * corpus.len + RNS_MEGABYTE(100)),
+            .errors_reported = false,
+        };
+        compiler.symbols = SymbolTable::create(&compiler.common_allocator, 1024);
+
+        Allocator type_allocator = create_suballocator(&compiler.page_allocator, RNS_MEGABYTE(5));
+        TypeBuffer type_declarations = Type::init_type_system(&type_allocator);
+
+        u64 start = get_timestamp_ns();
+        LexerResult tokens = lex(compiler, corpus, type_declarations);
+        u64 time_ns = get_timestamp_ns() - start;
+
+        if (compiler.errors_reported)
+        {
+            default_free_allocator(&compiler.page_allocator);
+            return false;
+        }
+
+        result->best_time_ns = time_ns < result->best_time_ns ? time_ns : result->best_time_ns;
+        result->token_count = tokens.len;
+        result->allocated_size = tokens.allocated_size + compiler.symbols.allocated_size;
+
+        default_free_allocator(&compiler.page_allocator);
+    }
+
+    return true;
+}
+
+// @Info: the values are compared by what each kind of token keeps in them, and string literals by their text, since every lex stores
+// its own copy
+static bool tokens_match(LexerResult& a, LexerResult& b, s64 index)
+{
+    if (a.ids[index] != b.ids[index] || a.starts[index] != b.starts[index] || a.lengths[index] != b.lengths[index])
+    {
+        return false;
+    }
+
+    auto& a_value = a.values[index];
+    auto& b_value = b.values[index];
+    switch (a.ids[index])
+    {
+        case TokenID::Keyword:
+            return a_value.keyword == b_value.keyword;
+        case TokenID::Type:
+            return a_value.type == b_value.type;
+        case TokenID::Intrinsic:
+            return a_value.intrinsic == b_value.intrinsic;
+        case TokenID::Symbol:
+            return a_value.symbol == b_value.symbol;
+        case TokenID::StringLit:
+            return strcmp(a_value.str_lit, b_value.str_lit) == 0;
+        case TokenID::FloatLit:
+            return memcmp(&a_value.float_lit, &b_value.float_lit, sizeof(f64)) == 0;
+        case TokenID::CharLit:
+            return a_value.char_lit == b_value.char_lit;
+        case TokenID::IntegerLit:
+            return a_value.int_lit == b_value.int_lit;
+        default:
+            return true;
+    }
+}
+
+const u32 relex_check_edit_count = 64;
+const s64 relex_check_max_insert_size = 16;
+
+// @Info: the edits remove whole tokens and insert a fragment padded with blanks, at the start of a token or in the middle of a name,
+// so the edited file always lexes and the damaged region crosses token boundaries
+static bool check_relex(String corpus, u64 seed)
+{
+    static const char* fragments[] = { "", "value_7", "42", "0x1F", "1.5e3", "\"text\"", "'c'", "+", "(", ")", ";", "\n", "if", "return" };
+    Compiler compiler = {
+        .page_allocator = default_create_allocator(16 * corpus.len + RNS_MEGABYTE(256)),
+        .common_allocator = create_suballocator(&compiler.page_allocator, 2 * corpus.len + RNS_MEGABYTE(100)),
+        .errors_reported = false,
+    };
+    compiler.symbols = SymbolTable::create(&compiler.common_allocator, 1024);
+    Allocator type_allocator = create_suballocator(&compiler.page_allocator, RNS_MEGABYTE(5));
+    TypeBuffer type_declarations = Type::init_type_system(&type_allocator);
+
+    // @Info: relex leaves the edited file to the caller, so the edits go back and forth between two buffers
+    s64 file_cap = corpus.len + relex_check_edit_count * relex_check_max_insert_size + 1;
+    Allocator file_allocator = default_create_allocator(2 * file_cap + 1024);
+    char* files[2] = { new(&file_allocator) char[file_cap], new(&file_allocator) char[file_cap] };
+    memcpy(files[0], corpus.ptr, corpus.len + 1);
+    String file = { files[0], corpus.len };
+
+    LexerResult tokens = lex(compiler, file, type_declarations);
+    u64 random_state = seed | 1;
+    bool result = !compiler.errors_reported;
+    for (u32 edit_index = 0; result && edit_index < relex_check_edit_count; edit_index++)
+    {
+        s64 first = xorshift_random(&random_state, static_cast<u32>(tokens.len));
+        s64 last = first + xorshift_random(&random_state, 3);
+        last = last < tokens.len ? last : tokens.len;
+        u32 offset = tokens.starts[first];
+        u32 removed_end = last < tokens.len ? tokens.starts[last] : static_cast<u32>(file.len);
+        if (first == last && tokens.ids[first] == TokenID::Symbol && tokens.lengths[first] > 1)
+        {
+            offset += 1 + xorshift_random(&random_state, tokens.lengths[first] - 1);
+            removed_end = offset;
+        }
+
+        char inserted[relex_check_max_insert_size];
+        s64 inserted_length = snprintf(inserted, sizeof(inserted), " %s ", fragments[xorshift_random(&random_state, rns_array_length(fragments))]);
+        SourceEdit edit = {
+            .offset = offset,
+            .removed_length = removed_end - offset,
+            .inserted_length = static_cast<u32>(inserted_length),
+        };
+
+        char* new_file_chars = files[(edit_index + 1) & 1];
+        String new_file = { new_file_chars, file.len - edit.removed_length + edit.inserted_length };
+        memcpy(new_file_chars, file.ptr, offset);
+        memcpy(&new_file_chars[offset], inserted, inserted_length);
+        memcpy(&new_file_chars[offset + inserted_length], &file.ptr[removed_end], file.len - removed_end + 1);
+        file = new_file;
+
+        if (!relex(compiler, tokens, file, edit, type_declarations))
+        {
+            printf("Relexing edit %u failed\n", edit_index);
+            result = false;
+            break;
+        }
+
+        // @Info: the tokens of the whole file are only needed for the comparison
+        Allocator page_allocator_mark = compiler.page_allocator;
+        LexerResult expected_tokens = lex(compiler, file, type_declarations);
+        result = !compiler.errors_reported && expected_tokens.len == tokens.len;
+        for (s64 i = 0; result && i < tokens.len; i++)
+        {
+            if (!tokens_match(tokens, expected_tokens, i))
+            {
+                printf("Edit %u at offset %u: token %" PRId64 " doesn't match lex\n", edit_index, offset, i);
+                result = false;
+            }
+        }
+        if (!result && expected_tokens.len != tokens.len)
+        {
+            printf("Edit %u at offset %u: relex has %" PRId64 " tokens, lex has %" PRId64 "\n", edit_index, offset, tokens.len, expected_tokens.len);
+        }
+        compiler.page_allocator = page_allocator_mark;
+    }
+
+    default_free_allocator(&file_allocator);
+    default_free_allocator(&compiler.page_allocator);
+    return result;
+}
+
+const u32 float_check_random_count = 1 << 18;
+const u64 float_check_seed = 0x2545F4914F6CDD1Dull;
+
+// @Info: ties, which go to the even mantissa, subnormals and the edges of the range, more significant digits than a u64 holds,
+// hexadecimal literals, and values which round differently to f32 than to f64
+static const char* float_check_literals[] = {
+    "0.0", "1.0", "0.1", "1_000.5e-3", "3.14159265358979323846264338327950288",
+    "9007199254740993", "9007199254740995", "9007199254740993.0000000000000000001", "1e23", "8.98846567431158e307",
+    "1.00000000000000011102230246251565404236316680908203125", "1.000000000000000111022302462515654042363166809082031250001",
+    "0.1000000000000000055511151231257827021181583404541015625", "123456789012345678901234567890", "7.2057594037927933e16",
+    "2.2250738585072011e-308", "2.2250738585072012e-308", "4.9406564584124654e-324", "2.4703282292062327e-324",
+    "2.4703282292062328e-324", "1.7976931348623157e308", "1.7976931348623158e308", "1.7976931348623159e308", "1e-400", "1e400",
+    "0x1.8p1", "0x1p-1074", "0x1.fffffffffffffp1023", "0x1.0000000000001p0", "0x1.00000000000008p0", "0x1.00000000000018p0",
+    "0x1p-149", "0x1.000001p0", "0x1.000003p0", "0x1.fffffep127",
+    "16777217", "16777219", "1.00000005960464477539062500", "1.000000059604644775390625001", "3.4028235e38", "3.4028236e38",
+    "3.40282356779733661637539395458142568447e38", "1.17549435e-38", "1.4e-45", "7.006492321624085e-46", "7.006492321624086e-46",
+};
+
+// @Info: a literal the C library takes to infinity has to be turned down as out of range, any other one has to give its bits
+static bool check_float_literal(const char* literal, s64 len)
+{
+    char c_literal[128];
+    s64 c_len = 0;
+    assert(len < static_cast<s64>(sizeof(c_literal)));
+    for (s64 i = 0; i < len; i++)
+    {
+        if (literal[i] != '_')
+        {
+            c_literal[c_len++] = literal[i];
+        }
+    }
+    c_literal[c_len] = 0;
+
+    f64 expected_values[] = { strtof(c_literal, nullptr), strtod(c_literal, nullptr) };
+    u16 bit_counts[] = { 32, 64 };
+    for (u32 i = 0; i < rns_array_length(bit_counts); i++)
+    {
+        f64 value;
+        const char* error_message = decode_float_literal(literal, len, bit_counts[i], &value);
+        if (isinf(expected_values[i]))
+        {
+            if (!error_message)
+            {
+                printf("%.*s as f%u: got %a, expected out of range\n", static_cast<s32>(len), literal, bit_counts[i], value);
+                return false;
+            }
+        }
+        else if (error_message)
+        {
+            printf("%.*s as f%u: %s, expected %a\n", static_cast<s32>(len), literal, bit_counts[i], error_message, expected_values[i]);
+            return false;
+        }
+        else if (memcmp(&value, &expected_values[i], sizeof(f64)) != 0)
+        {
+            printf("%.*s as f%u: got %a, expected %a\n", static_cast<s32>(len), literal, bit_counts[i], value, expected_values[i]);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// @Info: the random literals have up to 25 digits with the point anywhere in them, and an exponent which keeps half of them in the
+// range of f32 and sends the others anywhere in the range of f64 and past it
+static bool check_float_literals(u64 seed)
+{
+    for (const char* literal : float_check_literals)
+    {
+        if (!check_float_literal(literal, static_cast<s64>(strlen(literal))))
+        {
+            return false;
+        }
+    }
+
+    u64 random_state = seed | 1;
+    for (u32 literal_index = 0; literal_index < float_check_random_count; literal_index++)
+    {
+        char literal[64];
+        s64 len = 0;
+        u32 digit_count = 1 + xorshift_random(&random_state, 25);
+        u32 point = xorshift_random(&random_state, digit_count);
+        for (u32 digit = 0; digit < digit_count; digit++)
+        {
+            if (digit == point && digit)
+            {
+                literal[len++] = '.';
+            }
+            literal[len++] = static_cast<char>('0' + xorshift_random(&random_state, 10));
+        }
+        s32 exponent_range = xorshift_random(&random_state, 2) ? 100 : 700;
+        s32 exponent = static_cast<s32>(xorshift_random(&random_state, exponent_range)) - exponent_range / 2;
+        len += snprintf(&literal[len], sizeof(literal) - len, "e%d", exponent);
+
+        if (!check_float_literal(literal, len))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+s32 rns_main(s32 argc, char* argv[])
+{
+    const char* default_sizes[] = { "64K", "1M", "16M", "256M" };
+    const char** sizes = default_sizes;
+    s32 size_count = rns_array_length(default_sizes);
+    bool write = false;
+    bool relex_check = false;
+    bool float_check = false;
+
+    for (; argc > 1 && strncmp(argv[1], "--", 2) == 0; argc--, argv++)
+    {
+        if (strcmp(argv[1], "--write") == 0)
+        {
+            write = true;
+        }
+        else if (strcmp(argv[1], "--check-relex") == 0)
+        {
+            relex_check = true;
+        }
+        else if (strcmp(argv[1], "--check-floats") == 0)
+        {
+            float_check = true;
+        }
+        else
+        {
+            printf("Unknown option %s\n", argv[1]);
+            return -1;
+        }
+    }
+    if (argc > 1)
+    {
+        sizes = const_cast<const char**>(&argv[1]);
+        size_count = argc - 1;
+    }
+    if (float_check && !check_float_literals(float_check_seed))
+    {
+        printf("Decoding float literals doesn't match the C library\n");
+        return -1;
+    }
+
+    printf("%12s %14s %12s %10s %12s %16s %12s\n", "size", "bytes", "tokens", "runs", "MB/s", "tokens/s", "bytes/token");
+    for (s32 i = 0; i < size_count; i++)
+    {
+        s64 size = parse_size(sizes[i]);
+        // @Info: token positions are 32-bit offsets
+        if (size <= 0 || size > static_cast<s64>(UINT32_MAX - RNS_MEGABYTE(1)))
+        {
+            printf("Invalid corpus size %s\n", sizes[i]);
+            return -1;
+        }
+
+        Allocator corpus_allocator = default_create_allocator(size + RNS_MEGABYTE(2));
+        String corpus = generate_corpus(&corpus_allocator, size, get_corpus_seed(size));
+        if (write && !write_corpus(corpus, sizes[i]))
+        {
+            return -1;
+        }
+
+        BenchmarkResult result;
+        if (!benchmark_lexer(corpus, &result))
+        {
+            printf("Lexing the %s corpus failed\n", sizes[i]);
+            return -1;
+        }
+        if (relex_check && !check_relex(corpus, get_corpus_seed(size)))
+        {
+            printf("Relexing the %s corpus doesn't match lexing it\n", sizes[i]);
+            return -1;
+        }
+
+        f64 seconds = static_cast<f64>(result.best_time_ns) / 1e9;
+        printf("%12s %14lld %12lld %10u %12.2f %16.0f %12.2f\n", sizes[i], static_cast<long long>(corpus.len), static_cast<long long>(result.token_count), result.run_count,
+            static_cast<f64>(corpus.len) / RNS_MEGABYTE(1) / seconds, static_cast<f64>(result.token_count) / seconds,
+            static_cast<f64>(result.allocated_size) / static_cast<f64>(result.token_count));
+
+        default_free_allocator(&corpus_allocator);
+    }
+
+    return 0;
+}
@@ -1,7 +1,9 @@
 #include "llvm_bytecode.h"
+#include "trace.h"
 
 #include <RNS/profiler.h>
 #include <stdio.h>
+#include <stdarg.h>
 
 namespace RNS
 {
@@ -106,10 +108,13 @@ namespace RNS
         Type* type;
     };
 
+    // @Info: named, with its fields in the memory order of the front-end. Size and alignment come from the front-end layout
     struct StructType
     {
         Type base;
         Slice<Type*> field_types;
+        u64 size;
+        u32 alignment;
     };
 
     struct ArrayType
@@ -119,6 +124,14 @@ namespace RNS
         u64 count;
     };
 
+    // @Info: <count x type>, the type being an integer or a float
+    struct VectorType
+    {
+        Type base;
+        Type* type;
+        u32 count;
+    };
+
     struct FunctionType
     {
         Type base;
@@ -460,6 +473,12 @@ namespace RNS
         bool is_signed;
     };
 
+    struct ConstantFP
+    {
+        Value value;
+        f64 fp_value; // @Info: f32 constants are stored widened, which is exact
+    };
+
     struct OperatorBitCast
     {
         Value value;
@@ -471,16 +490,24 @@ namespace RNS
         Type void_type, label_type;
         IntegerType i1, i8, i16, i32, i64;
         FloatType f32, f64;
-        // @TODO: add vector types and custom types
 
         Buffer<FunctionType> function_types;
         Buffer<ArrayType> array_types;
+        Buffer<VectorType> vector_types;
+        Buffer<StructType> struct_types;
         Buffer<PointerType> pointer_types;
         Buffer<ConstantArray> constant_arrays;
         Buffer<ConstantInt> constant_ints;
+        Buffer<ConstantFP> constant_floats;
+        // @Info: undef and zeroinitializer, which are only told apart by their value id and their type
+        Buffer<Value> type_constants;
         Buffer<Intrinsic> intrinsics;
+        // @Info: the type table of the module and the backend type each of its types lowers to, indexed by TypeRef. Lowering a type
+        // is then an index once it has been done, the first time it looks for an equal type among the ones already made
+        User::TypeBuffer* user_types;
+        Type** user_type_cache;
 
-        static Context create(Allocator* allocator)
+        static Context create(Allocator* allocator, User::TypeBuffer* user_types)
         {
             auto get_base_type = [](TypeID type, const char* name)
             {
@@ -515,7 +542,7 @@ namespace RNS
             auto get_float_type = [&](u16 bits, const char* name)
             {
                 FloatType float_type = {
-                    .base = get_base_type(TypeID::Integer, name),
+                    .base = get_base_type(TypeID::Float, name),
                     .bits = bits,
                 };
 
@@ -527,10 +554,17 @@ namespace RNS
 
             context.function_types = context.function_types.create(allocator, 1024);
             context.array_types = context.array_types.create(allocator, 1024);
+            context.vector_types = context.vector_types.create(allocator, 64);
+            context.struct_types = context.struct_types.create(allocator, 1024);
             context.pointer_types = context.pointer_types.create(allocator, 1024);
             context.constant_arrays = context.constant_arrays.create(allocator, 1024);
             context.constant_ints = context.constant_ints.create(allocator, 1024);
+            context.constant_floats = context.constant_floats.create(allocator, 1024);
+            context.type_constants = context.type_constants.create(allocator, 64);
             context.intrinsics = context.intrinsics.create(allocator, 1024);
+            context.user_types = user_types;
+            context.user_type_cache = new(allocator) Type * [user_types->entries.len];
+            memset(context.user_type_cache, 0, sizeof(Type*) * user_types->entries.len);
 
             return context;
         }
@@ -606,6 +640,47 @@ namespace RNS
             return reinterpret_cast<Type*>(pointer_type);
         }
 
+        Type* get_array_type(Type* type, u64 count)
+        {
+            assert(type);
+
+            for (auto& array_type : array_types)
+            {
+                if (array_type.count == count && array_type.type == type)
+                {
+                    return reinterpret_cast<Type*>(&array_type);
+                }
+            }
+
+            ArrayType* array_type = array_types.allocate();
+            array_type->base.id = TypeID::Array;
+            array_type->count = count;
+            array_type->type = type;
+
+            return reinterpret_cast<Type*>(array_type);
+        }
+
+        Type* get_vector_type(Type* type, u32 count)
+        {
+            assert(type);
+            assert(type->id == TypeID::Integer || type->id == TypeID::Float);
+
+            for (auto& vector_type : vector_types)
+            {
+                if (vector_type.count == count && vector_type.type == type)
+                {
+                    return reinterpret_cast<Type*>(&vector_type);
+                }
+            }
+
+            VectorType* vector_type = vector_types.allocate();
+            vector_type->base.id = TypeID::Vector;
+            vector_type->count = count;
+            vector_type->type = type;
+
+            return reinterpret_cast<Type*>(vector_type);
+        }
+
         ConstantArray* get_constant_array(Slice<Value*> values, Type* type)
         {
             ConstantArray* constarray = constant_arrays.allocate();
@@ -636,8 +711,54 @@ namespace RNS
 
             return new_int;
         }
+
+        ConstantFP* get_constant_float(Type* type, ::f64 value)
+        {
+            assert(type);
+            assert(type->id == TypeID::Float);
+
+            auto* new_float = constant_floats.allocate();
+            assert(new_float);
+            new_float->value.type = type;
+            new_float->value.base_id = ValueID::ConstantFP;
+            new_float->fp_value = value;
+
+            return new_float;
+        }
+
+        Value* get_type_constant(Type* type, ValueID id)
+        {
+            assert(type);
+            assert(id == ValueID::Undefined || id == ValueID::ConstantAggregateZero);
+
+            for (auto& constant : type_constants)
+            {
+                if (constant.type == type && constant.base_id == id)
+                {
+                    return &constant;
+                }
+            }
+
+            auto* constant = type_constants.allocate();
+            constant->type = type;
+            constant->base_id = id;
+
+            return constant;
+        }
+
+        Value* get_undef(Type* type)
+        {
+            return get_type_constant(type, ValueID::Undefined);
+        }
+
+        Value* get_zero(Type* type)
+        {
+            return get_type_constant(type, ValueID::ConstantAggregateZero);
+        }
     };
 
+    Type* get_type(Allocator* allocator, Context& context, User::TypeRef type);
+
     Type* get_type(Allocator* allocator, Context& context, User::Type* type)
     {
         assert(type);
@@ -651,23 +772,19 @@ namespace RNS
 
                 for (auto& fn_type : context.function_types)
                 {
-                    if (ret_type != fn_type.ret_type)
+                    if (ret_type != fn_type.ret_type || arg_count != fn_type.arg_types.len)
                     {
                         continue;
                     }
-                    for (auto i = 0; i < type->function_t.arg_types.len; i++)
+                    bool same_arg_types = true;
+                    for (auto i = 0; i < arg_count && same_arg_types; i++)
                     {
-                        auto* user_arg_type = type->function_t.arg_types[i];
-                        auto* arg_type = get_type(allocator, context, user_arg_type);
-                        auto* fn_arg_type = fn_type.arg_types[i];
-                        if (arg_type == fn_arg_type)
-                        {
-                            continue;
-                        }
-                        break;
+                        same_arg_types = get_type(allocator, context, type->function_t.arg_types[i]) == fn_type.arg_types[i];
+                    }
+                    if (same_arg_types)
+                    {
+                        return reinterpret_cast<Type*>(&fn_type);
                     }
-
-                    return reinterpret_cast<Type*>(&fn_type);
                 }
 
                 FunctionType* function_type = context.function_types.allocate();
@@ -676,6 +793,10 @@ namespace RNS
                 {
                     function_type->arg_types.ptr = new(allocator) Type * [arg_count];
                     function_type->arg_types.len = arg_count;
+                    for (auto i = 0; i < arg_count; i++)
+                    {
+                        function_type->arg_types[i] = get_type(allocator, context, type->function_t.arg_types[i]);
+                    }
                 }
                 function_type->ret_type = ret_type;
 
@@ -686,24 +807,26 @@ namespace RNS
                 auto bits = type->integer_t.bits;
                 return context.get_integer_type(bits);
             } break;
+            case User::TypeID::FloatType:
+            case User::TypeID::DoubleType:
+            {
+                auto bits = type->float_t.bits;
+                return context.get_float_type(bits);
+            } break;
             case User::TypeID::ArrayType:
             {
-                auto count = type->array_t.count;
                 auto* elem_type = get_type(allocator, context, type->array_t.type);
-                for (auto& array_type : context.array_types)
-                {
-                    if (array_type.count == count && array_type.type == elem_type)
-                    {
-                        return reinterpret_cast<Type*>(&array_type);
-                    }
-                }
-
-                ArrayType* array_type = context.array_types.allocate();
-                array_type->base.id = TypeID::Array;
-                array_type->count = count;
-                array_type->type = elem_type;
-
-                return reinterpret_cast<Type*>(array_type);
+                return context.get_array_type(elem_type, type->array_t.count);
+            } break;
+            case User::TypeID::FixedVectorType:
+            {
+                auto* lane_type = get_type(allocator, context, type->vector_t.type);
+                return context.get_vector_type(lane_type, type->vector_t.count);
+            } break;
+            case User::TypeID::PointerType:
+            {
+                auto* appointee_type = get_type(allocator, context, type->pointer_t.appointee);
+                return context.get_pointer_type(appointee_type);
             } break;
             default:
                 RNS_NOT_IMPLEMENTED;
@@ -712,6 +835,68 @@ namespace RNS
         return nullptr;
     }
 
+    // @Info: structs are nominal, so every struct of the type table gets a type of its own. The padding which makes a cache-line
+    // aligned struct a whole number of lines long is an extra byte array at the end, so that arrays of them keep every element on
+    // its own lines
+    Type* get_struct_type(Allocator* allocator, Context& context, User::TypeRef type)
+    {
+        auto& user_struct = (*context.user_types)[type].struct_t;
+        auto layout = context.user_types->get_layout(type);
+        s64 fields_size = 0;
+        u32 fields_alignment = 1;
+        for (auto i = 0; i < user_struct.field_count; i++)
+        {
+            auto field_layout = context.user_types->get_layout(user_struct.field_types[i]);
+            fields_size = user_struct.field_offsets[i] + field_layout.size > fields_size ? user_struct.field_offsets[i] + field_layout.size : fields_size;
+            fields_alignment = field_layout.alignment > fields_alignment ? field_layout.alignment : fields_alignment;
+        }
+        fields_size = (fields_size + fields_alignment - 1) & ~static_cast<s64>(fields_alignment - 1);
+        s64 padding_size = layout.size - fields_size;
+
+        StructType* struct_type = context.struct_types.allocate();
+        *struct_type = {
+            .base = {
+                .name = context.user_types->get_name(type),
+                .id = TypeID::Struct,
+            },
+            .size = static_cast<u64>(layout.size),
+            .alignment = layout.alignment,
+        };
+        // @Info: cached before the fields are lowered, since a field can point to the struct
+        context.user_type_cache[type] = reinterpret_cast<Type*>(struct_type);
+
+        s64 element_count = user_struct.field_count + (padding_size > 0);
+        if (element_count)
+        {
+            struct_type->field_types.ptr = new(allocator) Type * [element_count];
+            struct_type->field_types.len = element_count;
+            for (auto i = 0; i < user_struct.field_count; i++)
+            {
+                struct_type->field_types[i] = get_type(allocator, context, user_struct.field_types[i]);
+                assert(struct_type->field_types[i]);
+            }
+            if (padding_size > 0)
+            {
+                struct_type->field_types[user_struct.field_count] = context.get_array_type(context.get_integer_type(8), padding_size);
+            }
+        }
+
+        return reinterpret_cast<Type*>(struct_type);
+    }
+
+    Type* get_type(Allocator* allocator, Context& context, User::TypeRef type)
+    {
+        assert(type != User::no_type && type < context.user_types->entries.len);
+        auto*& cached_type = context.user_type_cache[type];
+        if (!cached_type)
+        {
+            auto& user_type = (*context.user_types)[type];
+            cached_type = user_type.id == User::TypeID::StructType ? get_struct_type(allocator, context, type) : get_type(allocator, context, &user_type);
+        }
+
+        return cached_type;
+    }
+
     /*
     Unary instruction,
     unary operator
@@ -817,6 +1002,50 @@ namespace RNS
 
     static_assert(sizeof(Value) <= 2 * sizeof(u64));
 
+    IRText IRText::create(Allocator* allocator, s64 cap, Arena* arena)
+    {
+        assert(cap > 0);
+        IRText ir = {
+            .ptr = new(allocator) char[cap],
+            .len = 0,
+            .cap = cap,
+            .allocator = allocator,
+            .arena = arena,
+        };
+        ir.ptr[0] = 0;
+
+        return ir;
+    }
+
+    void IRText::print(const char* format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        va_list retry_args;
+        va_copy(retry_args, args);
+        s64 printed = vsnprintf(&ptr[len], cap - len, format, args);
+        va_end(args);
+        assert(printed >= 0);
+
+        if (len + printed >= cap)
+        {
+            // @Info: the text is only ever appended to, so growing the same way Buffer does is enough
+            s64 new_cap = cap * 2 > len + printed + 1 ? cap * 2 : len + printed + 1;
+            if (arena)
+            {
+                arena->reserve(new_cap);
+            }
+            char* new_ptr = new(allocator) char[new_cap];
+            memcpy(new_ptr, ptr, len);
+            ptr = new_ptr;
+            cap = new_cap;
+            vsnprintf(&ptr[len], cap - len, format, retry_args);
+        }
+        va_end(retry_args);
+
+        len += printed;
+    }
+
     struct SlotTracker
     {
         u64 next_id;
@@ -932,6 +1161,16 @@ namespace RNS
                     return "slt";
                 case CmpType::ICMP_SGT:
                     return "sgt";
+                case CmpType::ICMP_ULT:
+                    return "ult";
+                case CmpType::ICMP_UGT:
+                    return "ugt";
+                case CmpType::FCMP_OEQ:
+                    return "oeq";
+                case CmpType::FCMP_OLT:
+                    return "olt";
+                case CmpType::FCMP_OGT:
+                    return "ogt";
                 default:
                     RNS_NOT_IMPLEMENTED;
                     break;
@@ -940,6 +1179,34 @@ namespace RNS
         }
     };
 
+    usize get_size(Type* type);
+
+    // @Info: the same alignment the front-end lays the struct fields out with, see get_type_layout
+    u32 get_alignment(Type* type)
+    {
+        switch (type->id)
+        {
+            case TypeID::Integer:
+            {
+                u32 bits = reinterpret_cast<IntegerType*>(type)->bits;
+                return bits > 8 ? bits / 8 : 1;
+            }
+            case TypeID::Float:
+                return reinterpret_cast<FloatType*>(type)->bits / 8;
+            case TypeID::Pointer:
+                return alignof(void*);
+            case TypeID::Array:
+                return get_alignment(reinterpret_cast<ArrayType*>(type)->type);
+            case TypeID::Struct:
+                return reinterpret_cast<StructType*>(type)->alignment;
+            case TypeID::Vector:
+                return static_cast<u32>(get_size(type));
+            default:
+                RNS_NOT_IMPLEMENTED;
+                return 1;
+        }
+    }
+
     const char* type_to_string(Type* type, char* buffer)
     {
         assert(type);
@@ -957,6 +1224,11 @@ namespace RNS
                 auto bits = integer_type->bits;
                 sprintf(buffer, "i%u", bits);
             } break;
+            case TypeID::Float:
+            {
+                auto* float_type = reinterpret_cast<FloatType*>(type);
+                sprintf(buffer, float_type->bits == 32 ? "float" : "double");
+            } break;
             case TypeID::Void:
             {
                 sprintf(buffer, "void");
@@ -969,6 +1241,16 @@ namespace RNS
                 auto arr_elem_type = array_type->type;
                 sprintf(buffer, "[%llu x %s]", length, type_to_string(arr_elem_type, arr_type_buffer));
             } break;
+            case TypeID::Vector:
+            {
+                char lane_type_buffer[64];
+                auto* vector_type = reinterpret_cast<VectorType*>(type);
+                sprintf(buffer, "<%u x %s>", vector_type->count, type_to_string(vector_type->type, lane_type_buffer));
+            } break;
+            case TypeID::Struct:
+            {
+                sprintf(buffer, "%%%.*s", static_cast<s32>(type->name.len), type->name.get());
+            } break;
             default:
                 RNS_NOT_IMPLEMENTED;
                 break;
@@ -976,27 +1258,46 @@ namespace RNS
         return (const char*)buffer;
     }
 
+    void print_struct_definition(StructType* struct_type, IRText& ir)
+    {
+        char type_buffer[64];
+        ir.print("%s = type {", type_to_string(reinterpret_cast<Type*>(struct_type), type_buffer));
+        for (auto i = 0; i < struct_type->field_types.len; i++)
+        {
+            ir.print("%s %s", i ? "," : "", type_to_string(struct_type->field_types[i], type_buffer));
+        }
+        ir.print(" }\n");
+    }
+
     struct Module
     {
         Buffer<Function> functions;
+        // @Info: the functions by name, indexed by symbol, so that calls find their function in constant time
+        Function** function_table;
+        s64 function_table_len;
 
-        static Module create(Allocator* allocator)
+        // @Info: the functions are allocated up front, since the table points into the buffer
+        static Module create(Allocator* allocator, s64 function_count, s64 symbol_count)
         {
             Module module = {
-                .functions = module.functions.create(allocator, 64),
+                .functions = module.functions.create(allocator, function_count),
+                .function_table = new(allocator) Function * [symbol_count],
+                .function_table_len = symbol_count,
             };
+            memset(module.function_table, 0, sizeof(Function*) * symbol_count);
 
             return module;
         }
 
         // @TODO: do typechecking
-        Function* find_function(StringView name, Type* type = nullptr);
+        Function* find_function(SymbolID symbol, Type* type = nullptr);
     };
 
     struct Function
     {
         // @Info: for a function, a value type is the returning type
         Value value;
+        SymbolID symbol;
         StringView name;
         Type* type;
         Buffer<BasicBlock*> basic_blocks;
@@ -1004,7 +1305,7 @@ namespace RNS
         Module* parent;
         // @TODO: symbol table
 
-        static Function* create(Module* module, Type* type, /* @TODO: linkage*/ String name)
+        static Function* create(Module* module, Type* type, /* @TODO: linkage*/ SymbolID symbol, StringView name)
         {
             assert(type);
             auto* function_type = reinterpret_cast<FunctionType*>(type);
@@ -1012,12 +1313,15 @@ namespace RNS
             assert(ret_type);
 
             auto* function = module->functions.allocate();
+            assert(symbol < module->function_table_len);
+            module->function_table[symbol] = function;
             *function = {
                 .value = {
                     .type = ret_type,
                     .base_id = ValueID::GlobalFunction,
                  },
-                .name = StringView::create(name.ptr, name.len),
+                .symbol = symbol,
+                .name = name,
                 .type = type,
                 .parent = module,
                 // @TODO: basic blocks, args...
@@ -1032,7 +1336,7 @@ namespace RNS
             return nullptr;
         }
 
-        void print(Allocator* allocator);
+        void print(Allocator* allocator, IRText& ir);
     };
 
     struct Instruction
@@ -1057,7 +1361,7 @@ namespace RNS
             Compare compare;
         };
 
-        void print(SlotTracker& slot_tracker)
+        void print(SlotTracker& slot_tracker, IRText& ir)
         {
             char operand0[64] = {};
             char operand1[64] = {};
@@ -1065,7 +1369,7 @@ namespace RNS
             char type_buffer[64];
             char type_buffer2[64];
 
-            printf("\t");
+            ir.print("\t");
             switch (base.id)
             {
                 case InstructionID::Alloca:
@@ -1073,52 +1377,86 @@ namespace RNS
                     auto* pointer_type = this->base.value.type;
                     assert(pointer_type);
                     auto* pointer_type_cast = reinterpret_cast<PointerType*>(pointer_type);
-                    printf("%%%llu = alloca %s, align 4", id1, type_to_string(pointer_type_cast->type, type_buffer));
+                    ir.print("%%%llu = alloca %s, align %u", id1, type_to_string(pointer_type_cast->type, type_buffer), get_alignment(pointer_type_cast->type));
                 } break;
                 case InstructionID::Store:
                 {
-                    printf("store i32 %s, i32* %s, align 4", operands[0]->print(operand0, slot_tracker), operands[1]->print(operand1, slot_tracker));
+                    if (operands[0]->base_id == ValueID::ConstantFP)
+                    {
+                        auto* float_type = reinterpret_cast<FloatType*>(operands[0]->type);
+                        auto* type_str = type_to_string(operands[0]->type, type_buffer);
+                        ir.print("store %s %s, %s* %s, align %u", type_str, operands[0]->print(operand0, slot_tracker), type_str, operands[1]->print(operand1, slot_tracker), float_type->bits / 8);
+                    }
+                    else
+                    {
+                        auto* type_str = type_to_string(operands[0]->type, type_buffer);
+                        ir.print("store %s %s, %s* %s, align %u", type_str, operands[0]->print(operand0, slot_tracker), type_str, operands[1]->print(operand1, slot_tracker), get_alignment(operands[0]->type));
+                    }
                 } break;
                 case InstructionID::Br:
                 {
                     if (operand_count == 1)
                     {
-                        printf("br label %s", operands[0]->print(operand0, slot_tracker));
+                        ir.print("br label %s", operands[0]->print(operand0, slot_tracker));
                     }
                     else
                     {
-                        printf("br i1 %s, label %s, label %s", operands[2]->print(operand2, slot_tracker), operands[0]->print(operand0, slot_tracker), operands[1]->print(operand1, slot_tracker));
+                        ir.print("br i1 %s, label %s, label %s", operands[2]->print(operand2, slot_tracker), operands[0]->print(operand0, slot_tracker), operands[1]->print(operand1, slot_tracker));
                     }
                 } break;
                 case InstructionID::Load:
                 {
-                    printf("%%%llu = load i32, i32* %s, align 4", id3, operands[0]->print(operand0, slot_tracker));
+                    auto* type_str = type_to_string(base.value.type, type_buffer);
+                    ir.print("%%%llu = load %s, %s* %s, align %u", id3, type_str, type_str, operands[0]->print(operand0, slot_tracker), get_alignment(base.value.type));
+                } break;
+                case InstructionID::ICmp: case InstructionID::FCmp:
+                {
+                    ir.print("%%%llu = %s %s %s %s, %s", id3, base.id == InstructionID::FCmp ? "fcmp" : "icmp", compare.to_string(), type_to_string(operands[0]->type, type_buffer), operands[0]->print(operand0, slot_tracker), operands[1]->print(operand1, slot_tracker));
                 } break;
-                case InstructionID::ICmp:
+                case InstructionID::Add: case InstructionID::Sub: case InstructionID::Mul:
+                case InstructionID::Fadd: case InstructionID::Fsub: case InstructionID::Fmul:
                 {
-                    printf("%%%llu = icmp %s i32 %s, %s", id3, compare.to_string(), operands[0]->print(operand0, slot_tracker), operands[1]->print(operand1, slot_tracker));
+                    const char* opcode = nullptr;
+                    switch (base.id)
+                    {
+                        case InstructionID::Add: opcode = "add"; break;
+                        case InstructionID::Sub: opcode = "sub"; break;
+                        case InstructionID::Mul: opcode = "mul"; break;
+                        case InstructionID::Fadd: opcode = "fadd"; break;
+                        case InstructionID::Fsub: opcode = "fsub"; break;
+                        case InstructionID::Fmul: opcode = "fmul"; break;
+                        default: RNS_UNREACHABLE; break;
+                    }
+                    ir.print("%%%llu = %s %s %s, %s", id3, opcode, type_to_string(base.value.type, type_buffer), operands[0]->print(operand0, slot_tracker), operands[1]->print(operand1, slot_tracker));
                 } break;
-                case InstructionID::Add:
+                case InstructionID::Trunc: case InstructionID::ZExt: case InstructionID::SExt:
                 {
-                    printf("%%%llu = add i32 %s, %s, align 4", id3, operands[0]->print(operand0, slot_tracker), operands[1]->print(operand1, slot_tracker));
+                    const char* opcode = base.id == InstructionID::Trunc ? "trunc" : base.id == InstructionID::ZExt ? "zext" : "sext";
+                    ir.print("%%%llu = %s %s %s to %s", id3, opcode, type_to_string(operands[0]->type, type_buffer), operands[0]->print(operand0, slot_tracker), type_to_string(base.value.type, type_buffer2));
                 } break;
-                case InstructionID::Sub:
+                case InstructionID::ExtractElement:
                 {
-                    printf("%%%llu = sub i32 %s, %s, align 4", id3, operands[0]->print(operand0, slot_tracker), operands[1]->print(operand1, slot_tracker));
+                    ir.print("%%%llu = extractelement %s %s, %s %s", id3, type_to_string(operands[0]->type, type_buffer), operands[0]->print(operand0, slot_tracker), type_to_string(operands[1]->type, type_buffer2), operands[1]->print(operand1, slot_tracker));
                 } break;
-                case InstructionID::Mul:
+                case InstructionID::InsertElement:
                 {
-                    printf("%%%llu = mul i32 %s, %s, align 4", id3, operands[0]->print(operand0, slot_tracker), operands[1]->print(operand1, slot_tracker));
+                    char type_buffer3[64];
+                    ir.print("%%%llu = insertelement %s %s, %s %s, %s %s", id3, type_to_string(operands[0]->type, type_buffer), operands[0]->print(operand0, slot_tracker), type_to_string(operands[1]->type, type_buffer2), operands[1]->print(operand1, slot_tracker), type_to_string(operands[2]->type, type_buffer3), operands[2]->print(operand2, slot_tracker));
+                } break;
+                case InstructionID::ShuffleVector:
+                {
+                    char type_buffer3[64];
+                    ir.print("%%%llu = shufflevector %s %s, %s %s, %s %s", id3, type_to_string(operands[0]->type, type_buffer), operands[0]->print(operand0, slot_tracker), type_to_string(operands[1]->type, type_buffer2), operands[1]->print(operand1, slot_tracker), type_to_string(operands[2]->type, type_buffer3), operands[2]->print(operand2, slot_tracker));
                 } break;
                 case InstructionID::Ret:
                 {
                     if (operands[0])
                     {
-                        printf("ret i32 %s", operands[0]->print(operand0, slot_tracker));
+                        ir.print("ret %s %s", type_to_string(operands[0]->type, type_buffer), operands[0]->print(operand0, slot_tracker));
                     }
                     else
                     {
-                        printf("ret void");
+                        ir.print("ret void");
                     }
                 } break;
                 case InstructionID::Call:
@@ -1149,14 +1487,15 @@ namespace RNS
                     auto ret_type_not_void = ret_type->id != TypeID::Void;
                     if (ret_type_not_void)
                     {
-                        printf("%%%llu = ", id1);
+                        ir.print("%%%llu = ", id1);
                     }
-                    printf("call i32 @%s(", name.get());
+                    // @TODO: intrinsics are still printed as returning i32
+                    ir.print("call %s @%s(", callee->base_id == ValueID::GlobalFunction ? type_to_string(ret_type, type_buffer) : "i32", name.get());
 
                     auto arg_count = operand_count - 1;
                     if (arg_count)
                     {
-                        auto print_arg = [](Value* operand)
+                        auto print_arg = [&ir, &slot_tracker](Value* operand)
                         {
                             char type_buffer[64];
                             char type_buffer2[64];
@@ -1171,19 +1510,21 @@ namespace RNS
                                     {
                                         case InstructionID::Alloca:
                                         {
-                                            printf("%s %%%llu", type_to_string(operand->type, type_buffer), reinterpret_cast<Instruction*>(operand)->id1);
+                                            ir.print("%s %%%llu", type_to_string(operand->type, type_buffer), reinterpret_cast<Instruction*>(operand)->id1);
                                         } break;
                                         case InstructionID::Load:
                                         {
-                                            printf("%s %%%llu", type_to_string(operand->type, type_buffer), reinterpret_cast<Instruction*>(operand)->id3);
+                                            ir.print("%s %%%llu", type_to_string(operand->type, type_buffer), reinterpret_cast<Instruction*>(operand)->id3);
                                         } break;
                                         case InstructionID::BitCast:
                                         {
-                                            printf("%s %%%llu", type_to_string(operand->type, type_buffer), reinterpret_cast<Instruction*>(operand)->id3);
+                                            ir.print("%s %%%llu", type_to_string(operand->type, type_buffer), reinterpret_cast<Instruction*>(operand)->id3);
                                         } break;
                                         default:
-                                            RNS_NOT_IMPLEMENTED;
-                                            break;
+                                        {
+                                            char operand_buffer[64];
+                                            ir.print("%s %s", type_to_string(operand->type, type_buffer), operand->print(operand_buffer, slot_tracker));
+                                        } break;
                                     }
                                 } break;
                                 case ValueID::OperatorBitCast:
@@ -1200,7 +1541,7 @@ namespace RNS
                                             auto* src_type = constarr->array_type;
                                             // @TODO: this gives a nullptr, fix
                                             // auto* dst_type = constarr->value.type;
-                                            printf("bitcast (%s* constarr to %s", type_to_string(src_type, type_buffer), type_to_string(dst_type, type_buffer2));
+                                            ir.print("bitcast (%s* constarr to %s", type_to_string(src_type, type_buffer), type_to_string(dst_type, type_buffer2));
                                         } break;
                                         default:
                                             RNS_NOT_IMPLEMENTED;
@@ -1213,11 +1554,13 @@ namespace RNS
                                     auto* type = constant_int->value.type;
                                     auto value = constant_int->int_value;
                                     auto is_signed = constant_int->is_signed;
-                                    printf("%s %s%llu", type_to_string(type, type_buffer), is_signed ? " -" : " ", value);
+                                    ir.print("%s %s%llu", type_to_string(type, type_buffer), is_signed ? " -" : " ", value);
                                 } break;
                                 default:
-                                    RNS_NOT_IMPLEMENTED;
-                                    break;
+                                {
+                                    char operand_buffer[64];
+                                    ir.print("%s %s", type_to_string(operand->type, type_buffer), operand->print(operand_buffer, slot_tracker));
+                                } break;
                             }
                         };
 
@@ -1225,29 +1568,36 @@ namespace RNS
                         {
                             auto* operand = operands[i];
                             print_arg(operand);
-                            printf(", ");
+                            ir.print(", ");
                         }
                         auto* operand = operands[arg_count];
                         print_arg(operand);
                     }
 
-                    printf(")");
+                    ir.print(")");
                 } break;
                 case InstructionID::BitCast:
                 {
                     auto* cast_value = operands[0];
                     assert(cast_value->base_id == ValueID::Instruction);
                     auto* cast_value_instr = reinterpret_cast<Instruction*>(cast_value);
-                    assert(cast_value_instr->base.id == InstructionID::Alloca);
-                    auto* cast_value_type = cast_value_instr->alloca_i.allocated_type;
-                    printf("%%%llu = bitcast %s* %s to %s", id3, type_to_string(cast_value_type, type_buffer), operands[0]->print(operand0, slot_tracker), type_to_string(this->base.value.type, type_buffer2));
+                    // @Info: allocas are cast as the pointer they are, the rest of the values as they are
+                    if (cast_value_instr->base.id == InstructionID::Alloca)
+                    {
+                        auto* cast_value_type = cast_value_instr->alloca_i.allocated_type;
+                        ir.print("%%%llu = bitcast %s* %s to %s", id3, type_to_string(cast_value_type, type_buffer), operands[0]->print(operand0, slot_tracker), type_to_string(this->base.value.type, type_buffer2));
+                    }
+                    else
+                    {
+                        ir.print("%%%llu = bitcast %s %s to %s", id3, type_to_string(cast_value->type, type_buffer), operands[0]->print(operand0, slot_tracker), type_to_string(this->base.value.type, type_buffer2));
+                    }
                 } break;
                 case InstructionID::GetElementPtr:
                 {
                     // @TODO: refactor this into the GEP instruction
                     bool inbounds = true;
-                    printf("%%%llu = getelementptr %s %s, %s* %s", id1, inbounds ? "inbounds " : " ", type_to_string(this->base.value.type, type_buffer), type_to_string(this->operands[0]->type, type_buffer2), operands[0]->print(operand0, slot_tracker));
-                    auto print_gep_indices = [](Value* index)
+                    ir.print("%%%llu = getelementptr %s %s, %s* %s", id1, inbounds ? "inbounds " : " ", type_to_string(this->base.value.type, type_buffer), type_to_string(this->operands[0]->type, type_buffer2), operands[0]->print(operand0, slot_tracker));
+                    auto print_gep_indices = [&ir](Value* index)
                     {
                         char buffer[64];
                         switch (index->base_id)
@@ -1258,7 +1608,7 @@ namespace RNS
                                 auto* type = constant_int->value.type;
                                 auto value = constant_int->int_value;
                                 auto is_signed = constant_int->is_signed;
-                                printf("%s %s%llu", type_to_string(type, buffer), is_signed ? " -" : " ", value);
+                                ir.print("%s %s%llu", type_to_string(type, buffer), is_signed ? " -" : " ", value);
                             } break;
                             default:
                                 RNS_NOT_IMPLEMENTED;
@@ -1277,7 +1627,7 @@ namespace RNS
                     break;
             }
 
-            printf("\n");
+            ir.print("\n");
         }
 
         void get_info(SlotTracker& slot_tracker)
@@ -1292,11 +1642,17 @@ namespace RNS
                 {
                     id3 = slot_tracker.new_id(this);
                 } break;
-                case InstructionID::ICmp:
+                case InstructionID::ICmp: case InstructionID::FCmp:
                 {
                     id3 = slot_tracker.new_id(this);
                 } break;
                 case InstructionID::Mul: case InstructionID::Add: case InstructionID::Sub:
+                case InstructionID::Fmul: case InstructionID::Fadd: case InstructionID::Fsub:
+                {
+                    id3 = slot_tracker.new_id(this);
+                } break;
+                case InstructionID::Trunc: case InstructionID::ZExt: case InstructionID::SExt:
+                case InstructionID::ExtractElement: case InstructionID::InsertElement: case InstructionID::ShuffleVector:
                 {
                     id3 = slot_tracker.new_id(this);
                 } break;
@@ -1342,15 +1698,48 @@ namespace RNS
                     {
                         sprintf(buffer, "%%%llu", id1);
                     } break;
-                    case InstructionID::GetElementPtr:
+                    case InstructionID::GetElementPtr: case InstructionID::Call:
                     {
                         sprintf(buffer, "%%%llu", id1);
                     } break;
+                    case InstructionID::Load: case InstructionID::ICmp: case InstructionID::FCmp: case InstructionID::BitCast:
+                    case InstructionID::Add: case InstructionID::Sub: case InstructionID::Mul:
+                    case InstructionID::Fadd: case InstructionID::Fsub: case InstructionID::Fmul:
+                    case InstructionID::Trunc: case InstructionID::ZExt: case InstructionID::SExt:
+                    case InstructionID::ExtractElement: case InstructionID::InsertElement: case InstructionID::ShuffleVector:
+                    {
+                        sprintf(buffer, "%%%llu", id3);
+                    } break;
                     default:
                         RNS_NOT_IMPLEMENTED;
                         break;
                 }
             } break;
+            case ValueID::Argument:
+            {
+                sprintf(buffer, "%%%lld", reinterpret_cast<Argument*>(this)->arg_index);
+            } break;
+            case ValueID::ConstantInt:
+            {
+                auto* constant_int = reinterpret_cast<ConstantInt*>(this);
+                sprintf(buffer, "%s%llu", constant_int->is_signed ? "-" : "", constant_int->int_value);
+            } break;
+            case ValueID::Undefined:
+            {
+                sprintf(buffer, "undef");
+            } break;
+            case ValueID::ConstantAggregateZero:
+            {
+                sprintf(buffer, "zeroinitializer");
+            } break;
+            case ValueID::ConstantFP:
+            {
+                // @Info: LLVM takes float constants as the hexadecimal bits of the double, which is exact for both float and double
+                auto* constant_fp = reinterpret_cast<ConstantFP*>(this);
+                u64 bits;
+                memcpy(&bits, &constant_fp->fp_value, sizeof(bits));
+                sprintf(buffer, "0x%016llX", bits);
+            } break;
             default:
                 RNS_NOT_IMPLEMENTED;
                 break;
@@ -1361,18 +1750,11 @@ namespace RNS
 
 
 
-    inline Function* Module::find_function(StringView name, Type* type)
+    inline Function* Module::find_function(SymbolID symbol, Type* type)
     {
         assert(functions.len);
-        for (auto& function : functions)
-        {
-            if (name.equal(function.name))
-            {
-                return &function;
-            }
-        }
-
-        return nullptr;
+        assert(symbol < function_table_len);
+        return function_table[symbol];
     }
 
     struct BasicBlock
@@ -1404,17 +1786,17 @@ namespace RNS
             }
         }
 
-        void print(SlotTracker& slot_tracker)
+        void print(SlotTracker& slot_tracker, IRText& ir)
         {
             // @Info: Don't print function's main scope
             if (parent->basic_blocks[0] != this)
             {
-                printf("%llu:\n", id);
+                ir.print("%llu:\n", id);
             }
         }
     };
 
-    void Function::print(Allocator* allocator)
+    void Function::print(Allocator* allocator, IRText& ir)
     {
         SlotTracker slot_tracker = SlotTracker::create(allocator, 2048);
         // @TODO: change hardcoding
@@ -1452,7 +1834,7 @@ namespace RNS
         auto* function_type = reinterpret_cast<FunctionType*>(type);
         auto* ret_type = function_type->ret_type;
         assert(ret_type);
-        printf("\ndefine dso_local %s @%s(", type_to_string(ret_type, ret_type_buffer), name.get());
+        ir.print("\ndefine dso_local %s @%s(", type_to_string(ret_type, ret_type_buffer), name.get());
 
         // Argument printing
         if (arguments.len)
@@ -1464,24 +1846,24 @@ namespace RNS
             {
                 auto* type = arguments[i].value.type;
                 assert(type);
-                printf("%s %%%lld, ", type_to_string(type, type_buffer), arguments[i].arg_index);
+                ir.print("%s %%%lld, ", type_to_string(type, type_buffer), arguments[i].arg_index);
             }
             auto* type = arguments[last_index].value.type;
             assert(type);
-            printf("%s %%%lld", type_to_string(type, type_buffer), arguments[last_index].arg_index);
+            ir.print("%s %%%lld", type_to_string(type, type_buffer), arguments[last_index].arg_index);
         }
-        printf(")\n{\n");
+        ir.print(")\n{\n");
 
         // @Info: actual printing
         for (auto* block : basic_blocks)
         {
-            block->print(slot_tracker);
+            block->print(slot_tracker, ir);
             for (auto* instruction : block->instructions)
             {
-                instruction->print(slot_tracker);
+                instruction->print(slot_tracker, ir);
             }
         }
-        printf("}\n");
+        ir.print("}\n");
     }
 
     struct Builder
@@ -1504,6 +1886,14 @@ namespace RNS
         bool emitted_return;
         bool explicit_return;
         /**/
+        Arena* arena;
+
+        // @Info: makes room for a statement, and for the buffers it can make grow
+        void reserve_statement()
+        {
+            s64 buffers_size = instruction_buffer->cap * sizeof(Instruction) + basic_block_buffer->cap * sizeof(BasicBlock) + current->instructions.cap * sizeof(Instruction*) + function->basic_blocks.cap * sizeof(BasicBlock*);
+            arena->reserve(2 * buffers_size);
+        }
 
         // @TODO: guarantee pointer stability
         Instruction* create_alloca(Type* type, Value* array_size = nullptr, const char* name = nullptr)
@@ -1628,13 +2018,20 @@ namespace RNS
             return nullptr;
         }
 
+        // @Info: vectors are compared lane by lane, which gives a vector of i1
         Instruction* create_icmp(CmpType compare_type, Value* left, Value* right, const char* name = nullptr)
         {
+            assert(left->type == right->type);
+            auto* result_type = context.get_boolean_type();
+            if (left->type->id == TypeID::Vector)
+            {
+                result_type = context.get_vector_type(result_type, reinterpret_cast<VectorType*>(left->type)->count);
+            }
+
             Instruction i = {
                 .base = {
-                    // @TODO: we need to switch to a vector comparison for SIMD types
                     .value = {
-                        .type = context.get_boolean_type(),
+                        .type = result_type,
                         .base_id = ValueID::Instruction,
                     },
                     .id = InstructionID::ICmp,
@@ -1647,6 +2044,32 @@ namespace RNS
             return insert_at_end(i);
         }
 
+        // @Info: the predicates are the ordered ones, so a NaN compares false
+        Instruction* create_fcmp(CmpType compare_type, Value* left, Value* right, const char* name = nullptr)
+        {
+            assert(left->type == right->type);
+            auto* result_type = context.get_boolean_type();
+            if (left->type->id == TypeID::Vector)
+            {
+                result_type = context.get_vector_type(result_type, reinterpret_cast<VectorType*>(left->type)->count);
+            }
+
+            Instruction i = {
+                .base = {
+                    .value = {
+                        .type = result_type,
+                        .base_id = ValueID::Instruction,
+                    },
+                    .id = InstructionID::FCmp,
+                },
+                .operands = { left, right },
+                .operand_count = 2,
+                .compare = { .type = compare_type }
+            };
+
+            return insert_at_end(i);
+        }
+
         Instruction* create_add(Value* left, Value* right, const char* name = nullptr)
         {
             assert(left->type == right->type);
@@ -1701,6 +2124,164 @@ namespace RNS
             return insert_at_end(i);
         }
 
+        Instruction* create_fadd(Value* left, Value* right, const char* name = nullptr)
+        {
+            assert(left->type == right->type);
+            Instruction i = {
+                .base = {
+                    .value = {
+                        .type = left->type,
+                        .base_id = ValueID::Instruction,
+                    },
+                    .id = InstructionID::Fadd,
+                },
+                .operands = { left, right },
+                .operand_count = 2,
+            };
+
+            return insert_at_end(i);
+        }
+
+        Instruction* create_fsub(Value* left, Value* right, const char* name = nullptr)
+        {
+            assert(left->type == right->type);
+            Instruction i = {
+                .base = {
+                    .value = {
+                        .type = left->type,
+                        .base_id = ValueID::Instruction,
+                    },
+                    .id = InstructionID::Fsub,
+                },
+                .operands = { left, right },
+                .operand_count = 2,
+            };
+
+            return insert_at_end(i);
+        }
+
+        Instruction* create_fmul(Value* left, Value* right, const char* name = nullptr)
+        {
+            assert(left->type == right->type);
+            Instruction i = {
+                .base = {
+                    .value = {
+                        .type = left->type,
+                        .base_id = ValueID::Instruction,
+                    },
+                    .id = InstructionID::Fmul,
+                },
+                .operands = { left, right },
+                .operand_count = 2,
+            };
+
+            return insert_at_end(i);
+        }
+
+        Instruction* create_cast(InstructionID id, Value* value, Type* type)
+        {
+            Instruction i = {
+                .base = {
+                    .value = {
+                        .type = type,
+                        .base_id = ValueID::Instruction,
+                    },
+                    .id = id,
+                },
+                .operands = { value },
+                .operand_count = 1,
+            };
+
+            return insert_at_end(i);
+        }
+
+        Instruction* create_sext(Value* value, Type* type)
+        {
+            return create_cast(InstructionID::SExt, value, type);
+        }
+
+        Instruction* create_zext(Value* value, Type* type)
+        {
+            return create_cast(InstructionID::ZExt, value, type);
+        }
+
+        Instruction* create_trunc(Value* value, Type* type)
+        {
+            return create_cast(InstructionID::Trunc, value, type);
+        }
+
+        Instruction* create_extract_element(Value* vector, Value* index)
+        {
+            assert(vector->type->id == TypeID::Vector);
+            Instruction i = {
+                .base = {
+                    .value = {
+                        .type = reinterpret_cast<VectorType*>(vector->type)->type,
+                        .base_id = ValueID::Instruction,
+                    },
+                    .id = InstructionID::ExtractElement,
+                },
+                .operands = { vector, index },
+                .operand_count = 2,
+            };
+
+            return insert_at_end(i);
+        }
+
+        Instruction* create_insert_element(Value* vector, Value* element, Value* index)
+        {
+            assert(vector->type->id == TypeID::Vector);
+            assert(reinterpret_cast<VectorType*>(vector->type)->type == element->type);
+            Instruction i = {
+                .base = {
+                    .value = {
+                        .type = vector->type,
+                        .base_id = ValueID::Instruction,
+                    },
+                    .id = InstructionID::InsertElement,
+                },
+                .operands = { vector, element, index },
+                .operand_count = 3,
+            };
+
+            return insert_at_end(i);
+        }
+
+        // @Info: the mask is a constant vector of i32 lane indices, its lane count being the one of the result
+        Instruction* create_shuffle_vector(Value* left, Value* right, Value* mask)
+        {
+            assert(left->type == right->type && left->type->id == TypeID::Vector);
+            assert(mask->type->id == TypeID::Vector);
+            auto* lane_type = reinterpret_cast<VectorType*>(left->type)->type;
+            auto lane_count = reinterpret_cast<VectorType*>(mask->type)->count;
+            Instruction i = {
+                .base = {
+                    .value = {
+                        .type = context.get_vector_type(lane_type, lane_count),
+                        .base_id = ValueID::Instruction,
+                    },
+                    .id = InstructionID::ShuffleVector,
+                },
+                .operands = { left, right, mask },
+                .operand_count = 3,
+            };
+
+            return insert_at_end(i);
+        }
+
+        // @Info: the usual broadcast, the scalar goes in the first lane and an all-zero mask copies it to the rest
+        Instruction* create_splat(Value* scalar, Type* vector_type)
+        {
+            assert(vector_type->id == TypeID::Vector);
+            auto lane_count = reinterpret_cast<VectorType*>(vector_type)->count;
+            auto* i32_type = context.get_integer_type(32);
+            auto* zero_index = reinterpret_cast<Value*>(context.get_constant_int(i32_type, 0, false));
+            auto* undef_vector = context.get_undef(vector_type);
+            auto* first_lane = create_insert_element(undef_vector, scalar, zero_index);
+            auto* zero_mask = context.get_zero(context.get_vector_type(i32_type, lane_count));
+            return create_shuffle_vector(reinterpret_cast<Value*>(first_lane), undef_vector, zero_mask);
+        }
+
         Instruction* create_ret(Value* value)
         {
             auto* fn_type_base = function->type;
@@ -1946,6 +2527,20 @@ namespace RNS
                 assert(integer_type->bits % 8 == 0);
                 return integer_type->bits / 8;
             }
+            case TypeID::Float:
+            {
+                auto* float_type = reinterpret_cast<FloatType*>(type);
+                return float_type->bits / 8;
+            }
+            case TypeID::Struct:
+            {
+                return reinterpret_cast<StructType*>(type)->size;
+            }
+            case TypeID::Vector:
+            {
+                auto* vector_type = reinterpret_cast<VectorType*>(type);
+                return vector_type->count * get_size(vector_type->type);
+            }
             default:
                 RNS_NOT_IMPLEMENTED;
                 break;
@@ -1954,6 +2549,144 @@ namespace RNS
         return 0;
     }
 
+    // @Info: like for subscripts, the GEP is typed with what it points to, the field
+    Value* get_field_pointer(Builder& builder, Node* node)
+    {
+        assert(node->type == NodeType::MemberAccess);
+        auto* struct_expression = node->member_access.expr_ref;
+        Value* struct_pointer = nullptr;
+        Type* struct_type = nullptr;
+        switch (struct_expression->type)
+        {
+            case NodeType::VarExpr:
+            {
+                auto* var_decl = struct_expression->var_expr.mentioned;
+                assert(var_decl);
+                auto* var_alloca = reinterpret_cast<Instruction*>(var_decl->var_decl.backend_ref);
+                assert(var_alloca);
+                struct_pointer = reinterpret_cast<Value*>(var_alloca);
+                struct_type = var_alloca->alloca_i.allocated_type;
+            } break;
+            case NodeType::MemberAccess:
+            {
+                struct_pointer = get_field_pointer(builder, struct_expression);
+                struct_type = struct_pointer->type;
+            } break;
+            default:
+                RNS_NOT_IMPLEMENTED;
+                break;
+        }
+
+        assert(struct_type && struct_type->id == TypeID::Struct);
+        auto* rns_struct_type = reinterpret_cast<StructType*>(struct_type);
+        auto field_index = node->member_access.field_index;
+        assert(field_index < rns_struct_type->field_types.len);
+        auto* zero_value = builder.context.get_constant_int(builder.context.get_integer_type(32), 0, false);
+        auto* field_index_value = builder.context.get_constant_int(builder.context.get_integer_type(32), field_index, false);
+        Value* indices[] = { reinterpret_cast<Value*>(zero_value), reinterpret_cast<Value*>(field_index_value) };
+        Slice<Value*> indices_slice = { indices, rns_array_length(indices) };
+        auto* gep = builder.create_inbounds_GEP(rns_struct_type->field_types[field_index], struct_pointer, indices_slice);
+        return reinterpret_cast<Value*>(gep);
+    }
+
+    // @Info: a scalar where a vector is expected is broadcast to every lane
+    Value* splat_scalar(Builder& builder, Value* value, Type* type)
+    {
+        if (type->id != TypeID::Vector || value->type == type)
+        {
+            return value;
+        }
+
+        assert(value->type == reinterpret_cast<VectorType*>(type)->type);
+        return reinterpret_cast<Value*>(builder.create_splat(value, type));
+    }
+
+    // @Info: the type an expression has in the module table, which keeps the signedness the backend types don't
+    User::TypeRef get_user_type(Context& context, Node* node)
+    {
+        auto& user_types = *context.user_types;
+        switch (node->type)
+        {
+            case NodeType::VarDecl:
+                return node->var_decl.type;
+            case NodeType::VarExpr:
+                return node->var_expr.mentioned->var_decl.type;
+            case NodeType::MemberAccess:
+            {
+                User::TypeRef struct_type = get_user_type(context, node->member_access.expr_ref);
+                return struct_type ? user_types[struct_type].struct_t.field_types[node->member_access.field_index] : User::no_type;
+            }
+            case NodeType::Subscript:
+            {
+                User::TypeRef container_type = get_user_type(context, node->subscript.expr_ref);
+                if (!container_type)
+                {
+                    return User::no_type;
+                }
+                auto& container = user_types[container_type];
+                return container.id == User::TypeID::FixedVectorType ? container.vector_t.type : container.array_t.type;
+            }
+            case NodeType::UnaryOp:
+            {
+                User::TypeRef pointer_type = node->unary_op.type == UnaryOp::PointerDereference ? get_user_type(context, node->unary_op.node) : User::no_type;
+                return pointer_type ? user_types[pointer_type].pointer_t.appointee : User::no_type;
+            }
+            case NodeType::InvokeExpr:
+                return node->invoke_expr.expr->function.type->type_expr.function_t.ret_type;
+            case NodeType::BinOp:
+            {
+                if (is_cmp_binop(node->bin_op.op))
+                {
+                    return User::no_type;
+                }
+                User::TypeRef left_type = get_user_type(context, node->bin_op.left);
+                return left_type ? left_type : get_user_type(context, node->bin_op.right);
+            }
+            default:
+                return User::no_type;
+        }
+    }
+
+    // @Info: integers, and vectors of them, are signed unless the module type of the expression says otherwise, like literals
+    bool is_signed_expression(Context& context, Node* node)
+    {
+        User::TypeRef type = get_user_type(context, node);
+        if (!type)
+        {
+            return true;
+        }
+        auto& user_types = *context.user_types;
+        if (user_types[type].id == User::TypeID::FixedVectorType)
+        {
+            type = user_types[type].vector_t.type;
+        }
+        return user_types[type].id != User::TypeID::IntegerType || user_types[type].integer_t.is_signed;
+    }
+
+    // @Info: an integer stored where an integer of another width goes is extended or truncated first, with the sign of its own type
+    Value* convert_integer(Builder& builder, Value* value, Type* type, Node* source)
+    {
+        if (value->type == type || value->type->id != TypeID::Integer || type->id != TypeID::Integer)
+        {
+            return value;
+        }
+
+        if (value->base_id == ValueID::ConstantInt)
+        {
+            auto* constant_int = reinterpret_cast<ConstantInt*>(value);
+            return reinterpret_cast<Value*>(builder.context.get_constant_int(type, constant_int->int_value, constant_int->is_signed));
+        }
+
+        auto from_bits = reinterpret_cast<IntegerType*>(value->type)->bits;
+        auto to_bits = reinterpret_cast<IntegerType*>(type)->bits;
+        bool is_signed = is_signed_expression(builder.context, source);
+        if (from_bits > to_bits)
+        {
+            return reinterpret_cast<Value*>(builder.create_trunc(value, type));
+        }
+        return reinterpret_cast<Value*>(is_signed ? builder.create_sext(value, type) : builder.create_zext(value, type));
+    }
+
     Value* do_node(Allocator* allocator, Builder& builder, Node* node, Type* expected_type = nullptr)
     {
         switch (node->type)
@@ -1964,6 +2697,7 @@ namespace RNS
                 {
                     if (!builder.emitted_return)
                     {
+                        builder.reserve_statement();
                         do_node(allocator, builder, st_node);
                     }
                 }
@@ -2083,7 +2817,7 @@ namespace RNS
             } break;
             case NodeType::VarDecl:
             {
-                auto* type = node->var_decl.type;
+                auto type = node->var_decl.type;
                 assert(type);
                 auto* rns_type = RNS::get_type(allocator, builder.context, type);
                 assert(rns_type);
@@ -2115,18 +2849,48 @@ namespace RNS
                         {
                             auto* expression = do_node(allocator, builder, value_node, rns_type);
                             assert(expression);
+                            expression = splat_scalar(builder, convert_integer(builder, expression, rns_type, value_node), rns_type);
                             builder.create_store(expression, reinterpret_cast<Value*>(var_alloca), false);
                         } break;
                     }
                 }
-                else
+                // @Info: the fields of a struct are assigned one by one after its declaration
+                else if (rns_type->id != TypeID::Struct)
                 {
                     RNS_NOT_IMPLEMENTED;
                 }
             } break;
             case NodeType::IntLit:
             {
-                auto* result = builder.context.get_constant_int(builder.context.get_integer_type(32), node->int_lit.lit, node->int_lit.is_signed);
+                // @Info: a literal takes the integer type expected where it is, a field or a variable narrower or wider than i32 for
+                // instance. Where a vector is expected it is a lane, which is splat by whoever expects the vector
+                auto* int_type = builder.context.get_integer_type(node->int_lit.bit_count ? node->int_lit.bit_count : 32);
+                if (expected_type && expected_type->id == TypeID::Integer)
+                {
+                    int_type = expected_type;
+                }
+                else if (expected_type && expected_type->id == TypeID::Vector)
+                {
+                    int_type = reinterpret_cast<VectorType*>(expected_type)->type;
+                }
+                auto* result = builder.context.get_constant_int(int_type, node->int_lit.lit, node->int_lit.is_signed);
+                assert(result);
+                return reinterpret_cast<Value*>(result);
+            }
+            case NodeType::FloatLit:
+            {
+                auto* float_type = builder.context.get_float_type(node->float_lit.bit_count);
+                ::f64 value = node->float_lit.lit;
+                if (expected_type && expected_type->id == TypeID::Vector)
+                {
+                    float_type = reinterpret_cast<VectorType*>(expected_type)->type;
+                    // @Info: LLVM only takes float constants which a float holds exactly
+                    if (reinterpret_cast<FloatType*>(float_type)->bits == 32)
+                    {
+                        value = static_cast<::f32>(value);
+                    }
+                }
+                auto* result = builder.context.get_constant_float(float_type, value);
                 assert(result);
                 return reinterpret_cast<Value*>(result);
             }
@@ -2147,14 +2911,50 @@ namespace RNS
                             auto* var_decl = ast_left->var_expr.mentioned;
                             assert(var_decl);
                             auto* alloca_value = var_decl->var_decl.backend_ref;
-                            auto* var_type = var_decl->var_decl.type;
+                            auto var_type = var_decl->var_decl.type;
                             assert(var_type);
                             auto* rns_var_type = get_type(allocator, builder.context, var_type);
                             assert(rns_var_type);
                             auto* right_value = do_node(allocator, builder, ast_right, rns_var_type);
                             assert(right_value);
+                            right_value = splat_scalar(builder, convert_integer(builder, right_value, rns_var_type, ast_right), rns_var_type);
                             builder.create_store(right_value, reinterpret_cast<Value*>(alloca_value));
                         } break;
+                        case NodeType::Subscript:
+                        {
+                            auto* subscript_expr = ast_left->subscript.expr_ref;
+                            assert(subscript_expr->type == NodeType::VarExpr);
+                            auto* subscript_alloca = reinterpret_cast<Instruction*>(subscript_expr->var_expr.mentioned->var_decl.backend_ref);
+                            assert(subscript_alloca);
+                            auto* subscript_type = subscript_alloca->alloca_i.allocated_type;
+                            if (subscript_type->id == TypeID::Vector)
+                            {
+                                // @Info: lanes can't be addressed, so the vector is loaded, the lane replaced and the vector stored back
+                                auto* index_value = do_node(allocator, builder, ast_left->subscript.index_ref);
+                                assert(index_value);
+                                auto* right_value = do_node(allocator, builder, ast_right, reinterpret_cast<VectorType*>(subscript_type)->type);
+                                assert(right_value);
+                                auto* vector_load = builder.create_load(subscript_type, reinterpret_cast<Value*>(subscript_alloca));
+                                auto* new_vector = builder.create_insert_element(reinterpret_cast<Value*>(vector_load), right_value, index_value);
+                                builder.create_store(reinterpret_cast<Value*>(new_vector), reinterpret_cast<Value*>(subscript_alloca));
+                            }
+                            else
+                            {
+                                auto* element_pointer = do_node(allocator, builder, ast_left);
+                                assert(element_pointer);
+                                auto* right_value = do_node(allocator, builder, ast_right, element_pointer->type);
+                                assert(right_value);
+                                builder.create_store(convert_integer(builder, right_value, element_pointer->type, ast_right), element_pointer);
+                            }
+                        } break;
+                        case NodeType::MemberAccess:
+                        {
+                            auto* field_pointer = do_node(allocator, builder, ast_left);
+                            assert(field_pointer);
+                            auto* right_value = do_node(allocator, builder, ast_right, field_pointer->type);
+                            assert(right_value);
+                            builder.create_store(convert_integer(builder, right_value, field_pointer->type, ast_right), field_pointer);
+                        } break;
                         case NodeType::UnaryOp:
                         {
                             assert(ast_left->unary_op.type == UnaryOp::PointerDereference);
@@ -2171,43 +2971,95 @@ namespace RNS
                 }
                 else
                 {
-                    auto* left = do_node(allocator, builder, ast_left);
-                    auto* right = do_node(allocator, builder, ast_right);
+                    // @Info: an integer literal operand takes the width of the other operand, or of the integer the result goes to
+                    Type* left_expected_type = expected_type && expected_type->id == TypeID::Integer && !is_cmp_binop(binary_op_type) ? expected_type : nullptr;
+                    auto* left = do_node(allocator, builder, ast_left, left_expected_type);
                     assert(left);
+                    auto* right = do_node(allocator, builder, ast_right, left->type->id == TypeID::Vector || left->type->id == TypeID::Integer ? left->type : nullptr);
                     assert(right);
+                    if (left->type != right->type && left->base_id == ValueID::ConstantInt)
+                    {
+                        left = convert_integer(builder, left, right->type, ast_left);
+                    }
+                    // @Info: integers of different widths meet at the wider one
+                    else if (left->type != right->type && left->type->id == TypeID::Integer && right->type->id == TypeID::Integer)
+                    {
+                        if (reinterpret_cast<IntegerType*>(left->type)->bits < reinterpret_cast<IntegerType*>(right->type)->bits)
+                        {
+                            left = convert_integer(builder, left, right->type, ast_left);
+                        }
+                        else
+                        {
+                            right = convert_integer(builder, right, left->type, ast_right);
+                        }
+                    }
+
+                    // @Info: operations between a vector and a scalar splat the scalar
+                    if (left->type->id == TypeID::Vector)
+                    {
+                        right = splat_scalar(builder, right, left->type);
+                    }
+                    else if (right->type->id == TypeID::Vector)
+                    {
+                        if (ast_left->type == NodeType::IntLit || ast_left->type == NodeType::FloatLit)
+                        {
+                            left = do_node(allocator, builder, ast_left, right->type);
+                        }
+                        left = splat_scalar(builder, left, right->type);
+                    }
+
+                    auto* lane_type = left->type->id == TypeID::Vector ? reinterpret_cast<VectorType*>(left->type)->type : left->type;
+                    bool is_float = lane_type->id == TypeID::Float;
+                    // @Info: the backend integers have no sign, so the comparison takes it from the operand types. A literal goes with
+                    // the other operand
+                    bool is_signed = is_signed_expression(builder.context, ast_left) && is_signed_expression(builder.context, ast_right);
 
                     Instruction* binary_op_instruction;
                     switch (binary_op_type)
                     {
                         case BinOp::Cmp_LessThan:
                         {
-                            binary_op_instruction = builder.create_icmp(CmpType::ICMP_SLT, left, right);
+                            binary_op_instruction = is_float ? builder.create_fcmp(CmpType::FCMP_OLT, left, right) : builder.create_icmp(is_signed ? CmpType::ICMP_SLT : CmpType::ICMP_ULT, left, right);
                         } break;
                         case BinOp::Cmp_GreaterThan:
                         {
-                            binary_op_instruction = builder.create_icmp(CmpType::ICMP_SGT, left, right);
+                            binary_op_instruction = is_float ? builder.create_fcmp(CmpType::FCMP_OGT, left, right) : builder.create_icmp(is_signed ? CmpType::ICMP_SGT : CmpType::ICMP_UGT, left, right);
                         } break;
                         case BinOp::Cmp_Equal:
                         {
-                            binary_op_instruction = builder.create_icmp(CmpType::ICMP_EQ, left, right);
+                            binary_op_instruction = is_float ? builder.create_fcmp(CmpType::FCMP_OEQ, left, right) : builder.create_icmp(CmpType::ICMP_EQ, left, right);
                         } break;
                         case BinOp::Plus:
                         {
-                            binary_op_instruction = builder.create_add(left, right);
+                            binary_op_instruction = is_float ? builder.create_fadd(left, right) : builder.create_add(left, right);
                         } break;
                         case BinOp::Minus:
                         {
-                            binary_op_instruction = builder.create_sub(left, right);
+                            binary_op_instruction = is_float ? builder.create_fsub(left, right) : builder.create_sub(left, right);
                         } break;
                         case BinOp::Mul:
                         {
-                            binary_op_instruction = builder.create_mul(left, right);
+                            binary_op_instruction = is_float ? builder.create_fmul(left, right) : builder.create_mul(left, right);
                         } break;
                         default:
                             RNS_NOT_IMPLEMENTED;
                             break;
                     }
 
+                    // @Info: like SIMD instruction sets do, a vector comparison gives a mask of the operand type, with every bit of
+                    // the lanes which compare true set. Float lanes get the bits of the integer mask of their width
+                    bool is_compare = binary_op_instruction->base.id == InstructionID::ICmp || binary_op_instruction->base.id == InstructionID::FCmp;
+                    if (is_compare && left->type->id == TypeID::Vector)
+                    {
+                        auto* vector_type = reinterpret_cast<VectorType*>(left->type);
+                        auto* mask_type = is_float ? builder.context.get_vector_type(builder.context.get_integer_type(reinterpret_cast<FloatType*>(lane_type)->bits), vector_type->count) : left->type;
+                        binary_op_instruction = builder.create_sext(reinterpret_cast<Value*>(binary_op_instruction), mask_type);
+                        if (is_float)
+                        {
+                            binary_op_instruction = builder.create_bitcast(reinterpret_cast<Value*>(binary_op_instruction), left->type);
+                        }
+                    }
+
                     return reinterpret_cast<Value*>(binary_op_instruction);
                 }
             } break;
@@ -2219,7 +3071,7 @@ namespace RNS
                 assert(alloca_ptr);
                 Instruction* var_alloca = reinterpret_cast<Instruction*>(alloca_ptr);
 
-                auto* type = var_decl->var_decl.type;
+                auto type = var_decl->var_decl.type;
                 assert(type);
                 auto* rns_type = get_type(allocator, builder.context, type);
                 assert(rns_type);
@@ -2236,7 +3088,9 @@ namespace RNS
                     builder.explicit_return = true;
 
                     assert(ast_return_expression);
-                    auto* ret_value = do_node(allocator, builder, ast_return_expression);
+                    auto* ret_type = reinterpret_cast<FunctionType*>(builder.function->type)->ret_type;
+                    auto* ret_value = do_node(allocator, builder, ast_return_expression, ret_type);
+                    ret_value = convert_integer(builder, ret_value, ret_type, ast_return_expression);
 
                     if (builder.conditional_alloca)
                     {
@@ -2269,9 +3123,8 @@ namespace RNS
                 auto* invoke_expr = node->invoke_expr.expr;
                 assert(invoke_expr);
                 assert(invoke_expr->type == NodeType::Function);
-                auto function_name = invoke_expr->function.name;
                 // @TODO: do typechecking
-                auto* function = builder.module->find_function(StringView::create(function_name.ptr, function_name.len));
+                auto* function = builder.module->find_function(invoke_expr->function.name);
                 assert(function);
 
                 auto arg_count = node->invoke_expr.arguments.len;
@@ -2286,7 +3139,8 @@ namespace RNS
                     assert(arg_count <= 15);
                     auto& node_arg_buffer = node->invoke_expr.arguments;
                     auto arg_i = 0;
-                    auto* fn_type_base = function->value.type;
+                    // @Info: the value type of a function is what it returns, its whole type is apart
+                    auto* fn_type_base = function->type;
                     assert(fn_type_base);
                     auto* function_type = reinterpret_cast<FunctionType*>(fn_type_base);
                     for (auto* arg_node : node_arg_buffer)
@@ -2317,7 +3171,7 @@ namespace RNS
                         auto* ref_var_decl = unary_op_expr->var_expr.mentioned;
                         assert(ref_var_decl);
                         assert(ref_var_decl->type == NodeType::VarDecl);
-                        auto* ref_var_decl_type = ref_var_decl->var_decl.type;
+                        auto ref_var_decl_type = ref_var_decl->var_decl.type;
                         assert(ref_var_decl_type);
                         auto* var_alloca = reinterpret_cast<Value*>(ref_var_decl->var_decl.backend_ref);
                         assert(var_alloca);
@@ -2331,9 +3185,9 @@ namespace RNS
                             auto* pointer_to_dereference_decl = unary_op_expr->var_expr.mentioned;
                             assert(pointer_to_dereference_decl);
                             assert(pointer_to_dereference_decl->type == NodeType::VarDecl);
-                            auto* pointer_type = pointer_to_dereference_decl->var_decl.type;
+                            auto pointer_type = pointer_to_dereference_decl->var_decl.type;
                             assert(pointer_type);
-                            assert(pointer_type->id == User::TypeID::PointerType);
+                            assert((*builder.context.user_types)[pointer_type].id == User::TypeID::PointerType);
                             auto* rns_ptr_type = get_type(allocator, builder.context, pointer_type);
                             assert(rns_ptr_type);
                             auto* pointer_alloca = reinterpret_cast<Value*>(pointer_to_dereference_decl->var_decl.backend_ref);
@@ -2347,9 +3201,9 @@ namespace RNS
                             auto* pointer_to_dereference_decl = unary_op_expr->var_expr.mentioned;
                             assert(pointer_to_dereference_decl);
                             assert(pointer_to_dereference_decl->type == NodeType::VarDecl);
-                            auto* pointer_type = pointer_to_dereference_decl->var_decl.type;
+                            auto pointer_type = pointer_to_dereference_decl->var_decl.type;
                             assert(pointer_type);
-                            assert(pointer_type->id == User::TypeID::PointerType);
+                            assert((*builder.context.user_types)[pointer_type].id == User::TypeID::PointerType);
                             auto* rns_pointer_type = get_type(allocator, builder.context, pointer_type);
                             assert(rns_pointer_type);
                             auto* pointer_alloca = reinterpret_cast<Value*>(pointer_to_dereference_decl->var_decl.backend_ref);
@@ -2371,7 +3225,24 @@ namespace RNS
             {
                 auto count = node->array_lit.elements.len;
                 assert(count > 0);
-                auto* ast_type = node->array_lit.type;
+                // @Info: a vector literal is built lane by lane, since its lanes don't have to be constants
+                if (expected_type && expected_type->id == TypeID::Vector)
+                {
+                    auto* vector_type = reinterpret_cast<VectorType*>(expected_type);
+                    assert(vector_type->count == count);
+                    auto* vector = builder.context.get_undef(expected_type);
+                    for (auto i = 0; i < count; i++)
+                    {
+                        auto* lane = do_node(allocator, builder, node->array_lit.elements[i], expected_type);
+                        assert(lane);
+                        auto* lane_index = builder.context.get_constant_int(builder.context.get_integer_type(32), i, false);
+                        vector = reinterpret_cast<Value*>(builder.create_insert_element(vector, lane, reinterpret_cast<Value*>(lane_index)));
+                    }
+
+                    return vector;
+                }
+
+                auto ast_type = node->array_lit.type;
                 auto* array_type = get_type(allocator, builder.context, ast_type);
                 assert(array_type);
 
@@ -2419,6 +3290,11 @@ namespace RNS
                 auto* alloca_instruction = reinterpret_cast<Instruction*>(alloca_value);
                 auto* alloca_type = alloca_instruction->alloca_i.allocated_type;
                 assert(alloca_type);
+                if (alloca_type->id == TypeID::Vector)
+                {
+                    auto* vector_load = builder.create_load(alloca_type, alloca_value);
+                    return reinterpret_cast<Value*>(builder.create_extract_element(reinterpret_cast<Value*>(vector_load), index_value));
+                }
                 assert(alloca_type->id == TypeID::Array);
                 auto* arr_type = reinterpret_cast<ArrayType*>(alloca_type);
                 auto* arr_elem_type = arr_type->type;
@@ -2429,6 +3305,16 @@ namespace RNS
                 auto* gep = builder.create_inbounds_GEP(arr_elem_type, alloca_value, indices_slice);
                 return reinterpret_cast<Value*>(gep);
             } break;
+            case NodeType::MemberAccess:
+            {
+                auto* field_pointer = get_field_pointer(builder, node);
+                if (node->value_type == ValueType::LValue)
+                {
+                    return field_pointer;
+                }
+
+                return reinterpret_cast<Value*>(builder.create_load(field_pointer->type, field_pointer));
+            } break;
             default:
                 RNS_NOT_IMPLEMENTED;
                 break;
@@ -2437,36 +3323,52 @@ namespace RNS
         return nullptr;
     }
 
-    void encode(Compiler& compiler, NodeBuffer& node_buffer, FunctionTypeBuffer& function_type_declarations, FunctionDeclarationBuffer& function_declarations)
+    void encode(Compiler& compiler, Arena& llvm_arena, NodeBuffer& node_buffer, User::TypeBuffer& type_declarations, FunctionTypeBuffer& function_type_declarations, FunctionDeclarationBuffer& function_declarations, IRText& ir)
     {
         RNS_PROFILE_FUNCTION();
-        compiler.subsystem = Compiler::Subsystem::IR;
-        auto llvm_allocator = create_suballocator(&compiler.page_allocator, RNS_MEGABYTE(50));
-        Module module = module.create(&llvm_allocator);
-        BasicBlockBuffer basic_block_buffer = basic_block_buffer.create(&llvm_allocator, 1024);
-        InstructionBuffer instruction_buffer = instruction_buffer.create(&llvm_allocator, 1024 * 16);
-        module.functions = module.functions.create(&llvm_allocator, function_declarations.len);
-
-        Context context = Context::create(&llvm_allocator);
+        compiler.set_subsystem(Compiler::Subsystem::IR);
+        Allocator& llvm_allocator = *llvm_arena.allocator;
+        const s64 basic_block_capacity = 1024;
+        const s64 instruction_capacity = 1024 * 16;
+        llvm_arena.reserve(function_declarations.len * sizeof(Function) + compiler.symbols.len * sizeof(Function*) + type_declarations.entries.len * sizeof(Type*) + basic_block_capacity * sizeof(BasicBlock) + instruction_capacity * sizeof(Instruction));
+        Module module = Module::create(&llvm_allocator, function_declarations.len, compiler.symbols.len);
+        BasicBlockBuffer basic_block_buffer = basic_block_buffer.create(&llvm_allocator, basic_block_capacity);
+        InstructionBuffer instruction_buffer = instruction_buffer.create(&llvm_allocator, instruction_capacity);
+
+        Context context = Context::create(&llvm_allocator, &type_declarations);
+
+        // @Info: the struct types are defined at the top of the module, in the order they were declared
+        for (User::TypeRef type = 1; type < type_declarations.entries.len; type++)
+        {
+            if (type_declarations[type].id == User::TypeID::StructType)
+            {
+                llvm_arena.reserve(0);
+                print_struct_definition(reinterpret_cast<StructType*>(get_type(&llvm_allocator, context, type)), ir);
+            }
+        }
 
         for (auto& ast_current_function : function_declarations)
         {
             auto* function_type = &ast_current_function->function.type->type_expr;
             assert(function_type->id == User::TypeID::FunctionType);
+            llvm_arena.reserve(0);
             auto* rns_function_type = get_type(&llvm_allocator, context, function_type);
             assert(rns_function_type);
-            Function::create(&module, rns_function_type, ast_current_function->function.name);
+            auto function_symbol = ast_current_function->function.name;
+            Function::create(&module, rns_function_type, function_symbol, compiler.symbols.get_name(function_symbol));
         }
 
         for (auto i = 0; i < function_declarations.len; i++)
         {
             auto& ast_current_function = function_declarations[i];
             auto* function = &module.functions[i];
+            llvm_arena.reserve(2 * (instruction_buffer.cap * sizeof(Instruction) + basic_block_buffer.cap * sizeof(BasicBlock)));
             Builder builder = { .context = context, };
             builder.basic_block_buffer = &basic_block_buffer;
             builder.instruction_buffer = &instruction_buffer;
             builder.function = function;
             builder.module = &module;
+            builder.arena = &llvm_arena;
 
             auto* ast_main_scope = ast_current_function->function.scope_blocks[0];
             auto& ast_main_scope_statements = ast_main_scope->block.statements;
@@ -2536,14 +3438,15 @@ namespace RNS
                 for (auto* arg_node : ast_current_function->function.arguments)
                 {
                     assert(arg_node->type == NodeType::VarDecl);
-                    auto* arg_type = arg_node->var_decl.type;
+                    auto arg_type = arg_node->var_decl.type;
                     assert(arg_type);
                     auto* rns_arg_type = get_type(&llvm_allocator, context, arg_type);
                     assert(rns_arg_type);
                     assert(arg_node->var_decl.is_fn_arg);
                     auto arg_name = arg_node->var_decl.name;
 
-                    auto* arg = &function->arguments[arg_index++];
+                    // @Info: the arguments take the first slots, before the entry block, so they are numbered from 0
+                    auto* arg = &function->arguments[arg_index];
                     *arg = {
                         .value = {
                             .type = rns_arg_type,
@@ -2551,6 +3454,7 @@ namespace RNS
                         },
                         .arg_index = arg_index,
                     };
+                    arg_index++;
 
                     auto* arg_alloca = builder.create_alloca(rns_arg_type);
                     arg_node->var_decl.backend_ref = arg_alloca;
@@ -2597,7 +3501,7 @@ namespace RNS
                 builder.create_ret_void();
             }
 
-            function->print(&llvm_allocator);
+            function->print(&llvm_allocator, ir);
         }
     }
 }
@@ -6,5 +6,26 @@
 namespace RNS
 {
     using namespace AST;
-    void encode(Compiler& compiler, NodeBuffer& node_buffer, FunctionTypeBuffer& function_type_declarations, FunctionDeclarationBuffer& function_declarations);
-}
\ No newline at end of file
+
+    // @Info: textual IR emitted by the backend. The driver prints it once the module is encoded and the compilation cache stores it
+    struct IRText
+    {
+        char* ptr;
+        s64 len;
+        s64 cap;
+        Allocator* allocator;
+        // @Info: null when the allocator can't grow
+        Arena* arena;
+
+        static IRText create(Allocator* allocator, s64 cap, Arena* arena = nullptr);
+        void print(const char* format, ...);
+
+        inline RNS::String get()
+        {
+            return { ptr, len };
+        }
+    };
+
+    // @Info: the module is built in the allocator of llvm_arena, which can be dropped once the IR is printed
+    void encode(Compiler& compiler, Arena& llvm_arena, NodeBuffer& node_buffer, User::TypeBuffer& type_declarations, FunctionTypeBuffer& function_type_declarations, FunctionDeclarationBuffer& function_declarations, IRText& ir);
+}
@@ -0,0 +1,200 @@
+#include "local_socket.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <WinSock2.h>
+#include <afunix.h>
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+using NativeSocket = SOCKET;
+#define close_native_socket closesocket
+// @Info: Windows has no SIGPIPE
+#define SEND_FLAGS 0
+
+static bool initialize_sockets()
+{
+    static bool initialized = false;
+    if (!initialized)
+    {
+        WSADATA wsa_data;
+        initialized = WSAStartup(MAKEWORD(2, 2), &wsa_data) == 0;
+    }
+
+    return initialized;
+}
+#else
+using NativeSocket = int;
+#define close_native_socket ::close
+// @Info: a client which goes away in the middle of a reply must not kill the server
+#if defined(MSG_NOSIGNAL)
+#define SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SEND_FLAGS 0
+#endif
+
+static bool initialize_sockets()
+{
+    return true;
+}
+#endif
+
+static_assert(sizeof(NativeSocket) <= sizeof(s64));
+
+static inline NativeSocket get_native_socket(LocalSocket socket)
+{
+    return static_cast<NativeSocket>(socket.handle);
+}
+
+static inline LocalSocket from_native_socket(NativeSocket native_socket)
+{
+    // @Info: INVALID_SOCKET on Windows is all ones, just like -1
+    return { .handle = static_cast<s64>(native_socket) };
+}
+
+static bool get_socket_address(const char* path, sockaddr_un* address)
+{
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    size_t path_length = strlen(path);
+    if (path_length >= sizeof(address->sun_path))
+    {
+        printf("Socket path is too long: %s\n", path);
+        return false;
+    }
+    memcpy(address->sun_path, path, path_length);
+
+    return true;
+}
+
+LocalSocket LocalSocket::listen(const char* path)
+{
+    sockaddr_un address;
+    if (!initialize_sockets() || !get_socket_address(path, &address))
+    {
+        return { .handle = -1 };
+    }
+
+    LocalSocket result = from_native_socket(socket(AF_UNIX, SOCK_STREAM, 0));
+    if (!result.is_valid())
+    {
+        return result;
+    }
+
+    // @Info: a socket file left behind by a server which didn't shut down cleanly would make bind fail
+    remove(path);
+    if (bind(get_native_socket(result), reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(get_native_socket(result), 16) != 0)
+    {
+        result.close();
+    }
+
+    return result;
+}
+
+LocalSocket LocalSocket::connect(const char* path)
+{
+    sockaddr_un address;
+    if (!initialize_sockets() || !get_socket_address(path, &address))
+    {
+        return { .handle = -1 };
+    }
+
+    LocalSocket result = from_native_socket(socket(AF_UNIX, SOCK_STREAM, 0));
+    if (!result.is_valid())
+    {
+        return result;
+    }
+
+    if (::connect(get_native_socket(result), reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        result.close();
+    }
+
+    return result;
+}
+
+LocalSocket LocalSocket::accept()
+{
+    return from_native_socket(::accept(get_native_socket(*this), nullptr, nullptr));
+}
+
+bool LocalSocket::send_all(const void* data, s64 size)
+{
+    auto* bytes = static_cast<const char*>(data);
+    while (size > 0)
+    {
+        s32 chunk_size = size < INT32_MAX ? static_cast<s32>(size) : INT32_MAX;
+        auto sent = send(get_native_socket(*this), bytes, chunk_size, SEND_FLAGS);
+        if (sent <= 0)
+        {
+            return false;
+        }
+        bytes += sent;
+        size -= sent;
+    }
+
+    return true;
+}
+
+s64 LocalSocket::receive(void* data, s64 size)
+{
+    s32 chunk_size = size < INT32_MAX ? static_cast<s32>(size) : INT32_MAX;
+    auto received = recv(get_native_socket(*this), static_cast<char*>(data), chunk_size, 0);
+    return received < 0 ? -1 : static_cast<s64>(received);
+}
+
+bool LocalSocket::receive_all(void* data, s64 size)
+{
+    auto* bytes = static_cast<char*>(data);
+    while (size > 0)
+    {
+        s64 received = receive(bytes, size);
+        if (received <= 0)
+        {
+            return false;
+        }
+        bytes += received;
+        size -= received;
+    }
+
+    return true;
+}
+
+void LocalSocket::close()
+{
+    if (is_valid())
+    {
+        close_native_socket(get_native_socket(*this));
+        handle = -1;
+    }
+}
+
+const char* get_default_socket_path()
+{
+    static char path[256];
+    if (!path[0])
+    {
+#if defined(_WIN32)
+        const char* temporary_directory = getenv("TEMP");
+#else
+        const char* temporary_directory = getenv("TMPDIR");
+#endif
+        if (!temporary_directory || !temporary_directory[0])
+        {
+            temporary_directory = "/tmp";
+        }
+        snprintf(path, sizeof(path), "%s/rns-compiler.sock", temporary_directory);
+    }
+
+    return path;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <RNS/types.h>
+
+// @Info: minimal wrapper over Unix domain stream sockets, which Windows 10 supports too through afunix.h
+struct LocalSocket
+{
+    s64 handle;
+
+    static LocalSocket listen(const char* path);
+    static LocalSocket connect(const char* path);
+    LocalSocket accept();
+
+    inline bool is_valid()
+    {
+        return handle != -1;
+    }
+
+    bool send_all(const void* data, s64 size);
+    // @Info: returns the bytes received, 0 once the other end closed the connection, or -1 on error
+    s64 receive(void* data, s64 size);
+    bool receive_all(void* data, s64 size);
+    void close();
+};
+
+// @Info: the socket the compile server listens on when no path is given, in the temporary directory
+const char* get_default_socket_path();
@@ -8,9 +8,9 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define USE_IMGUI 0
-#define USE_LLVM 0
 #define TEST_FILES 0
 #include "test_files.h"
 #if TEST_FILES
@@ -19,74 +19,223 @@
 #endif
 
 #include "compiler_types.h"
-#include "lexer.h"
-#include "parser.h"
-#include "llvm_bytecode.h"
+#include "compile_cache.h"
+#include "compile_server.h"
+#include "driver.h"
+#include "local_socket.h"
+#include "source_file.h"
+#include "trace.h"
 
 using namespace RNS;
 
-enum class CompilerIR
+bool compile_in_new_compiler(RNS::String* sources, const char** source_names, u32 source_count, const CompileOptions& options)
 {
-    WASM,
-    LLVM_CUSTOM,
-#if USE_LLVM
-    LLVM,
-#endif
-};
+    s64 source_size = 0;
+    for (u32 i = 0; i < source_count; i++)
+    {
+        source_size += sources[i].len;
+    }
 
-bool compiler_workflow(RNS::String file)
-{
+    s64 common_memory_size = get_arena_size(options.memory_profile, MemoryArena::Common, source_size);
     Compiler compiler = {
-        .page_allocator = default_create_allocator(RNS_GIGABYTE(1)),
-        .common_allocator = create_suballocator(&compiler.page_allocator, RNS_MEGABYTE(100)),
+        .page_allocator = default_create_allocator(common_memory_size + get_compile_memory_size(sources, source_count, options.memory_profile)),
+        .common_allocator = create_suballocator(&compiler.page_allocator, common_memory_size),
         .errors_reported = false,
     };
+    Arena common_arena = Arena::create(&compiler.common_allocator, common_memory_size);
+    compiler.common_arena = &common_arena;
+    compiler.symbols = SymbolTable::create(&compiler.common_allocator, 1024, compiler.common_arena);
+
+    bool result = compile_sources(compiler, sources, source_names, source_count, options);
+    if (options.memory_profile)
+    {
+        options.memory_profile->record(MemoryArena::Common, source_size, common_memory_size, common_arena.get_used_size());
+    }
+    common_arena.free_blocks();
+    default_free_allocator(&compiler.page_allocator);
+    return result;
+}
 
-    Allocator type_allocator = create_suballocator(&compiler.page_allocator, RNS_MEGABYTE(5));
-    TypeBuffer type_declarations = Type::init_type_system(&type_allocator);
+bool compiler_workflow(RNS::String file)
+{
+    const char* name = "<test>";
+    return compile_in_new_compiler(&file, &name, 1, {});
+}
 
-    LexerResult lexer_result = lex(compiler, file, type_declarations);
-    if (compiler.errors_reported)
+static void finish_memory_profile(MemoryProfile& memory_profile, const char* path, bool print_report)
+{
+    if (print_report)
     {
-        printf("Lexer failed!\n");
-        return false;
+        memory_profile.print_report();
     }
+    if (path)
+    {
+        memory_profile.save(path);
+    }
+}
+
+s32 rns_main(s32 argc, char* argv[])
+{
+#if SL_INSTR
+    PerformanceAPI_BeginEvent("Main function", nullptr, PERFORMANCEAPI_DEFAULT_COLOR);
+#endif
 
-    auto parser_result = parse(compiler, lexer_result, type_declarations);
-    if (compiler.errors_reported)
+    /* Command line
+     * rns-compiler [options] file1.rns file2.rns ...
+     * The files make a single module: a function defined in any of them can be called from the others.
+     * --server [socket path]   keeps a warm compiler resident and serves the requests sent by rns-client instead
+     * --cache directory        reuses the output of sources compiled before, stored in the directory
+     * --cache-size megabytes   size past which the least recently used outputs are removed from the cache
+     * --cache-stats            prints the cache hits and misses once done
+     * --time-report            prints the wall time, CPU time and memory of every phase and every file once done
+     * --time-report-json path  writes the same report as JSON
+     * --trace path             writes a timeline of the compilation which chrome://tracing and Perfetto load
+     * --memory-profile path    sizes the arenas from the memory the compilations before used, and adds what this one uses
+     * --memory-report          prints what every arena reserved and used once done
+     */
+    bool server = false;
+    const char* socket_path = get_default_socket_path();
+    const char* cache_directory = nullptr;
+    s64 cache_size = compile_cache_default_size;
+    bool print_cache_stats = false;
+    CompileOptions options = {};
+    const char* trace_path = nullptr;
+    const char* memory_profile_path = nullptr;
+    bool print_memory_report = false;
+    s32 first_file = 1;
+    for (; first_file < argc && strncmp(argv[first_file], "--", 2) == 0; first_file++)
     {
-        printf("Parsing failed.\n");
-        return false;
+        const char* option = argv[first_file];
+        bool has_value = first_file + 1 < argc;
+        if (strcmp(option, "--server") == 0)
+        {
+            server = true;
+            if (has_value && strncmp(argv[first_file + 1], "--", 2) != 0)
+            {
+                socket_path = argv[++first_file];
+            }
+        }
+        else if (strcmp(option, "--cache") == 0 && has_value)
+        {
+            cache_directory = argv[++first_file];
+        }
+        else if (strcmp(option, "--cache-size") == 0 && has_value)
+        {
+            cache_size = RNS_MEGABYTE(strtoll(argv[++first_file], nullptr, 10));
+        }
+        else if (strcmp(option, "--cache-stats") == 0)
+        {
+            print_cache_stats = true;
+        }
+        else if (strcmp(option, "--time-report") == 0)
+        {
+            options.print_time_report = true;
+        }
+        else if (strcmp(option, "--time-report-json") == 0 && has_value)
+        {
+            options.time_report_json_path = argv[++first_file];
+        }
+        else if (strcmp(option, "--trace") == 0 && has_value)
+        {
+            trace_path = argv[++first_file];
+        }
+        else if (strcmp(option, "--memory-profile") == 0 && has_value)
+        {
+            memory_profile_path = argv[++first_file];
+        }
+        else if (strcmp(option, "--memory-report") == 0)
+        {
+            print_memory_report = true;
+        }
+        else
+        {
+            printf("Unknown option %s\n", option);
+            return -1;
+        }
     }
 
-    CompilerIR compiler_ir = CompilerIR::LLVM_CUSTOM;
-    switch (compiler_ir)
+    CompileCache cache = {};
+    if (cache_directory)
     {
-        case CompilerIR::LLVM_CUSTOM:
+        cache = CompileCache::create(cache_directory, cache_size);
+        if (!cache.is_valid())
         {
-            RNS::encode(compiler, parser_result.node_buffer, parser_result.function_type_declarations, parser_result.function_declarations);
-        } break;
-        default:
-            RNS_UNREACHABLE;
-            break;
+            return -1;
+        }
     }
+    options.cache = cache.is_valid() ? &cache : nullptr;
+
+    // @Info: without a profile file the compilation is still measured for the report, and sized with the built-in sizes
+    MemoryProfile memory_profile = memory_profile_path ? MemoryProfile::load(memory_profile_path) : MemoryProfile{};
+    options.memory_profile = memory_profile_path || print_memory_report ? &memory_profile : nullptr;
 
-    if (compiler.errors_reported)
+    if (server)
     {
-        printf("IR generation failed\n");
-        return false;
+        // @Info: every request starts new workers, and each of them would keep a trace buffer for the lifetime of the server
+        if (trace_path)
+        {
+            printf("A compile server can't be traced, trace the compilation with rns-compiler directly\n");
+            return -1;
+        }
+        s32 result = run_compile_server(socket_path, options);
+        finish_memory_profile(memory_profile, memory_profile_path, print_memory_report);
+        return result;
     }
 
-    default_free_allocator(&compiler.page_allocator);
-    return true;
-}
+    // @Info: compiles every file into one module from its read-only mapping, without copying the source. The files are lexed and
+    // parsed in parallel
+    if (first_file < argc)
+    {
+        if (trace_path)
+        {
+            trace_begin();
+        }
 
+        u32 file_count = static_cast<u32>(argc - first_file);
+        Allocator file_allocator = default_create_allocator(file_count * (sizeof(SourceFile) + sizeof(RNS::String)) + 1024);
+        SourceFile* source_files = new(&file_allocator) SourceFile[file_count];
+        RNS::String* sources = new(&file_allocator) RNS::String[file_count];
+        bool result = true;
+        for (u32 i = 0; i < file_count; i++)
+        {
+            source_files[i] = SourceFile::map(argv[first_file + i]);
+            sources[i] = source_files[i].content;
+            if (!source_files[i].content.ptr)
+            {
+                file_count = i;
+                result = false;
+                break;
+            }
+        }
 
-s32 rns_main(s32 argc, char* argv[])
-{
+        if (result)
+        {
+            result = compile_in_new_compiler(sources, const_cast<const char**>(&argv[first_file]), file_count, options);
+            if (!result)
+            {
+                printf("Compilation failed\n");
+            }
+        }
+
+        for (u32 i = 0; i < file_count; i++)
+        {
+            source_files[i].unmap();
+        }
+        default_free_allocator(&file_allocator);
+        if (trace_path)
+        {
+            trace_end(trace_path);
+        }
+        if (print_cache_stats && options.cache)
+        {
+            options.cache->print_stats();
+        }
+        finish_memory_profile(memory_profile, memory_profile_path, print_memory_report);
 #if SL_INSTR
-    PerformanceAPI_BeginEvent("Main function", nullptr, PERFORMANCEAPI_DEFAULT_COLOR);
+        PerformanceAPI_EndEvent();
 #endif
+        return result ? 0 : -1;
+    }
 
 #if TEST_FILES
     for (auto i = 0; i < rns_array_length(test_files); i++)
@@ -0,0 +1,212 @@
+#include "memory_profile.h"
+#include "file_system.h"
+#include "lexer.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+using namespace RNS;
+
+const char memory_profile_header[] = "rns-memory-profile 1";
+const s64 memory_profile_max_path_length = 4096;
+
+struct ArenaDefaultSize
+{
+    s64 fixed_size;
+    s64 bytes_per_source_byte;
+};
+
+static const char* arena_names[] = {
+    "Common",
+    "Front-end common",
+    "Type system",
+    "Lexer",
+    "Parser",
+    "Backend",
+};
+static const char* arena_file_names[] = {
+    "common",
+    "front_end_common",
+    "type_system",
+    "lexer",
+    "parser",
+    "backend",
+};
+// @Info: what typical sources use, not the worst case. The arenas grow past these, see Arena
+static const ArenaDefaultSize arena_default_sizes[] = {
+    // @Info: the global symbol table gets the function names of every file
+    { RNS_MEGABYTE(100), 4 },
+    // @Info: the symbol table, the newline index and the string literals
+    { RNS_MEGABYTE(16), 8 },
+    // @Info: the parser adds array and function types as it finds them
+    { RNS_MEGABYTE(5), 1 },
+    // @Info: unused, see get_lexer_memory_size
+    { 0, 0 },
+    // @Info: the node buffers a statement creates take more than its source
+    { RNS_MEGABYTE(32), 16 },
+    { RNS_MEGABYTE(50), 16 },
+};
+static_assert(rns_array_length(arena_names) == memory_arena_count);
+static_assert(rns_array_length(arena_file_names) == memory_arena_count);
+static_assert(rns_array_length(arena_default_sizes) == memory_arena_count);
+
+s64 get_arena_size(const MemoryProfile* profile, MemoryArena arena, s64 source_size)
+{
+    // @Info: the lexer only takes its token window, which is the same for any file, so there is nothing to learn
+    if (arena == MemoryArena::Lexer)
+    {
+        return get_lexer_memory_size();
+    }
+
+    auto default_size = arena_default_sizes[static_cast<u32>(arena)];
+    if (!profile)
+    {
+        return default_size.fixed_size + default_size.bytes_per_source_byte * source_size;
+    }
+
+    auto arena_profile = profile->arenas[static_cast<u32>(arena)];
+    if (!arena_profile.fixed_size && arena_profile.bytes_per_source_byte == 0)
+    {
+        return default_size.fixed_size + default_size.bytes_per_source_byte * source_size;
+    }
+
+    // @Info: with only one side measured so far, the built-in size stands in for the other
+    s64 fixed_size = arena_profile.fixed_size ? arena_profile.fixed_size : default_size.fixed_size;
+    s64 growing_size = arena_profile.bytes_per_source_byte != 0 ? static_cast<s64>(arena_profile.bytes_per_source_byte * source_size) : default_size.bytes_per_source_byte * source_size;
+    s64 size = fixed_size > growing_size ? fixed_size : growing_size;
+
+    return size + size / 2 + RNS_MEGABYTE(1);
+}
+
+void MemoryProfile::record(MemoryArena arena, s64 source_size, s64 reserved_size, s64 used_size)
+{
+    auto& arena_usage = usage[static_cast<u32>(arena)];
+    arena_usage.reserved_size += reserved_size;
+    arena_usage.used_size += used_size;
+    arena_usage.peak_used_size = used_size > arena_usage.peak_used_size ? used_size : arena_usage.peak_used_size;
+    arena_usage.count++;
+
+    auto& arena_profile = arenas[static_cast<u32>(arena)];
+    if (source_size < memory_profile_small_source_size)
+    {
+        arena_profile.fixed_size = used_size > arena_profile.fixed_size ? used_size : arena_profile.fixed_size;
+    }
+    else
+    {
+        f64 bytes_per_source_byte = static_cast<f64>(used_size) / static_cast<f64>(source_size);
+        arena_profile.bytes_per_source_byte = bytes_per_source_byte > arena_profile.bytes_per_source_byte ? bytes_per_source_byte : arena_profile.bytes_per_source_byte;
+    }
+}
+
+static bool read_profile(FILE* file, ArenaProfile* arenas)
+{
+    char line[256];
+    bool valid = fgets(line, sizeof(line), file) && strncmp(line, memory_profile_header, sizeof(memory_profile_header) - 1) == 0;
+    while (valid && fgets(line, sizeof(line), file))
+    {
+        char name[64];
+        long long fixed_size;
+        f64 bytes_per_source_byte;
+        if (sscanf(line, "%63s %lld %lf", name, &fixed_size, &bytes_per_source_byte) != 3 || fixed_size < 0 || !(bytes_per_source_byte >= 0))
+        {
+            valid = false;
+            break;
+        }
+
+        // @Info: arenas this compiler doesn't know about are skipped, so an older compiler can still read the profile of a newer one
+        for (u32 arena = 0; arena < memory_arena_count; arena++)
+        {
+            if (strcmp(name, arena_file_names[arena]) == 0)
+            {
+                arenas[arena] = {
+                    .fixed_size = fixed_size,
+                    .bytes_per_source_byte = bytes_per_source_byte,
+                };
+            }
+        }
+    }
+
+    return valid;
+}
+
+MemoryProfile MemoryProfile::load(const char* path)
+{
+    MemoryProfile profile = {};
+    FILE* file = fopen(path, "rb");
+    if (!file)
+    {
+        return profile;
+    }
+
+    bool valid = read_profile(file, profile.arenas);
+    fclose(file);
+    if (!valid)
+    {
+        printf("%s is not a valid memory profile, the built-in sizes are used instead\n", path);
+        profile = {};
+    }
+
+    return profile;
+}
+
+bool MemoryProfile::save(const char* path)
+{
+    ArenaProfile saved_arenas[memory_arena_count] = {};
+    FILE* saved_file = fopen(path, "rb");
+    if (saved_file && read_profile(saved_file, saved_arenas))
+    {
+        for (u32 arena = 0; arena < memory_arena_count; arena++)
+        {
+            auto& arena_profile = arenas[arena];
+            arena_profile.fixed_size = saved_arenas[arena].fixed_size > arena_profile.fixed_size ? saved_arenas[arena].fixed_size : arena_profile.fixed_size;
+            arena_profile.bytes_per_source_byte = saved_arenas[arena].bytes_per_source_byte > arena_profile.bytes_per_source_byte ? saved_arenas[arena].bytes_per_source_byte : arena_profile.bytes_per_source_byte;
+        }
+    }
+    if (saved_file)
+    {
+        fclose(saved_file);
+    }
+
+    // @Info: written aside and renamed over the profile like the cache entries, so a compiler reading it never sees half of it
+    char temporary_path[memory_profile_max_path_length];
+    if (snprintf(temporary_path, sizeof(temporary_path), "%s.%u.tmp", path, FileSystem::get_process_id()) >= static_cast<s32>(sizeof(temporary_path)))
+    {
+        printf("The memory profile path %s is too long\n", path);
+        return false;
+    }
+
+    FILE* file = fopen(temporary_path, "wb");
+    bool written = file != nullptr;
+    if (file)
+    {
+        fprintf(file, "%s\n", memory_profile_header);
+        for (u32 arena = 0; arena < memory_arena_count; arena++)
+        {
+            fprintf(file, "%s %" PRId64 " %.6f\n", arena_file_names[arena], arenas[arena].fixed_size, arenas[arena].bytes_per_source_byte);
+        }
+        written = fclose(file) == 0;
+    }
+
+    if (!written || !FileSystem::replace_file(temporary_path, path))
+    {
+        remove(temporary_path);
+        printf("Couldn't write the memory profile to %s\n", path);
+        return false;
+    }
+
+    return true;
+}
+
+void MemoryProfile::print_report()
+{
+    printf("\nMemory report %-18s %8s %14s %14s %14s\n", "", "Arenas", "Reserved (KB)", "Used (KB)", "Peak (KB)");
+    for (u32 arena = 0; arena < memory_arena_count; arena++)
+    {
+        auto& arena_usage = usage[arena];
+        if (arena_usage.count)
+        {
+            printf("  %-30s %8u %14" PRId64 " %14" PRId64 " %14" PRId64 "\n", arena_names[arena], arena_usage.count, arena_usage.reserved_size / 1024, arena_usage.used_size / 1024, arena_usage.peak_used_size / 1024);
+        }
+    }
+}
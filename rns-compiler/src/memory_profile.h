@@ -0,0 +1,63 @@
+#pragma once
+#include <RNS/types.h>
+#include <RNS/data_structures.h>
+#include "compiler_types.h"
+
+/* Memory profile
+ * Every phase of a compilation works in a suballocator carved out of the page allocator before the phase starts, so its size has to
+ * be picked knowing nothing about the sources but their size. Each of these arenas is sized as a fixed part plus a part which grows
+ * with the source. The built-in sizes are made for typical sources, and an arena which runs out takes new blocks from the OS (see
+ * Arena), so a size which falls short costs a few allocations, not the compilation.
+ * Once a phase is done, what it really used of its arena is measured by probing the top of the arena, which works since the allocators
+ * are bump allocators. A MemoryProfile keeps the peak of those measurements: the bytes used by small sources, which are mostly the fixed
+ * part, and the bytes used per source byte by bigger ones. Saved to a file, it lets the next compilations reserve what the sources
+ * seen so far needed, with headroom, instead of the built-in sizes. Arenas the profile hasn't measured yet keep the built-in sizes.
+ */
+enum class MemoryArena : u8
+{
+    // @Info: the common allocator of the compiler, shared by every file
+    Common,
+    // @Info: the common allocator of a front-end worker: the symbol tables, the newline indices and the string literals of its files
+    FrontEndCommon,
+    TypeSystem,
+    Lexer,
+    Parser,
+    Backend,
+    Count,
+};
+
+const u32 memory_arena_count = static_cast<u32>(MemoryArena::Count);
+// @Info: sources below this size measure the fixed part of an arena, the ones above it measure the bytes per source byte
+const s64 memory_profile_small_source_size = RNS_KILOBYTE(64);
+
+struct ArenaProfile
+{
+    s64 fixed_size;
+    f64 bytes_per_source_byte;
+};
+
+struct ArenaUsage
+{
+    s64 reserved_size;
+    s64 used_size;
+    s64 peak_used_size;
+    u32 count;
+};
+
+struct MemoryProfile
+{
+    ArenaProfile arenas[memory_arena_count];
+    // @Info: what this process reserved and used, for the report
+    ArenaUsage usage[memory_arena_count];
+
+    // @Info: a missing file gives an empty profile, which keeps the built-in sizes
+    static MemoryProfile load(const char* path);
+    // @Info: merged with the profile already in the file, so compilers sharing it keep each other's peaks
+    bool save(const char* path);
+
+    void record(MemoryArena arena, s64 source_size, s64 reserved_size, s64 used_size);
+    void print_report();
+};
+
+// @Info: bytes to reserve for the arena for sources of that size. A null profile gives the built-in size
+s64 get_arena_size(const MemoryProfile* profile, MemoryArena arena, s64 source_size);
@@ -1,4 +1,5 @@
 #include "parser.h"
+#include "trace.h"
 
 #include <RNS/profiler.h>
 #include <stdio.h>
@@ -8,12 +9,180 @@ using namespace AST;
 
 namespace AST
 {
+    // @Info: tokens handed out by the parser are materialized from the token arrays into a small ring, so a Token* stays valid
+    // until token_window_size more tokens have been looked at
+    const s64 token_window_size = 64;
+    static_assert((token_window_size & (token_window_size - 1)) == 0);
+    const s64 struct_max_field_count = 256;
+
+    /* Scoped symbol table
+     * The variables in scope, found by name in constant time. Symbols are already interned into dense ids, so instead of hashing
+     * the names again the table is an array indexed by the symbol, holding the innermost declaration of each name.
+     * Declaring a variable saves the binding it replaces on a stack, and leaving a scope pops the bindings the scope made,
+     * putting back the ones they shadowed. Entering and leaving a scope is then proportional to what the scope declared.
+     */
+    struct VariableBinding
+    {
+        Node* var_decl;
+        u32 scope_depth;
+    };
+
+    struct ShadowedBinding
+    {
+        SymbolID name;
+        VariableBinding binding;
+    };
+
+    // @Info: an array indexed by symbol, zeroed. The lexer keeps interning symbols while the parser runs, so the array grows with them
+    // like the symbol table does, leaving the old array behind in the arena
+    template<typename T>
+    struct SymbolArray
+    {
+        T* ptr;
+        s64 cap;
+        Allocator* allocator;
+        Arena* arena;
+
+        static SymbolArray create(Allocator* allocator, s64 symbol_count, Arena* arena)
+        {
+            SymbolArray array = {
+                .ptr = new(allocator) T[symbol_count],
+                .cap = symbol_count,
+                .allocator = allocator,
+                .arena = arena,
+            };
+            memset(array.ptr, 0, sizeof(T) * symbol_count);
+
+            return array;
+        }
+
+        // @Info: zero for a symbol the array doesn't reach yet
+        T find(SymbolID name)
+        {
+            return name < cap ? ptr[name] : T{};
+        }
+
+        T& get(SymbolID name)
+        {
+            if (name >= cap)
+            {
+                s64 new_cap = cap * 2 > name + 1 ? cap * 2 : name + 1;
+                if (arena)
+                {
+                    arena->reserve(sizeof(T) * new_cap);
+                }
+                T* new_ptr = new(allocator) T[new_cap];
+                memcpy(new_ptr, ptr, sizeof(T) * cap);
+                memset(new_ptr + cap, 0, sizeof(T) * (new_cap - cap));
+                ptr = new_ptr;
+                cap = new_cap;
+            }
+
+            return ptr[name];
+        }
+    };
+
+    // @Info: the functions of the file by name, indexed by symbol like the variables
+    struct FunctionTable
+    {
+        SymbolArray<Node*> functions;
+
+        static FunctionTable create(Allocator* allocator, s64 symbol_count, Arena* arena)
+        {
+            FunctionTable table = {
+                .functions = SymbolArray<Node*>::create(allocator, symbol_count, arena),
+            };
+
+            return table;
+        }
+
+        Node* find(SymbolID name)
+        {
+            return functions.find(name);
+        }
+
+        // @Info: fails if a function with that name is already defined
+        bool define(SymbolID name, Node* function)
+        {
+            Node*& defined_function = functions.get(name);
+            if (defined_function)
+            {
+                return false;
+            }
+
+            defined_function = function;
+            return true;
+        }
+    };
+
+    struct ScopedSymbolTable
+    {
+        SymbolArray<VariableBinding> bindings;
+        Buffer<ShadowedBinding> shadowed;
+        // @Info: the length of the shadowed stack when each of the open scopes was entered
+        Buffer<s64> scope_starts;
+
+        static ScopedSymbolTable create(Allocator* allocator, s64 symbol_count, Arena* arena)
+        {
+            ScopedSymbolTable table = {
+                .bindings = SymbolArray<VariableBinding>::create(allocator, symbol_count, arena),
+                .shadowed = Buffer<ShadowedBinding>::create(allocator, 1024),
+                .scope_starts = Buffer<s64>::create(allocator, 64),
+            };
+
+            return table;
+        }
+
+        Node* find(SymbolID name)
+        {
+            return bindings.find(name).var_decl;
+        }
+
+        // @Info: fails if the name is already declared in the innermost scope. Declarations in outer scopes are shadowed
+        bool declare(SymbolID name, Node* var_decl)
+        {
+            assert(scope_starts.len);
+            auto& binding = bindings.get(name);
+            u32 scope_depth = static_cast<u32>(scope_starts.len);
+            if (binding.var_decl && binding.scope_depth == scope_depth)
+            {
+                return false;
+            }
+
+            shadowed.append({ .name = name, .binding = binding });
+            binding = {
+                .var_decl = var_decl,
+                .scope_depth = scope_depth,
+            };
+
+            return true;
+        }
+
+        void push_scope()
+        {
+            scope_starts.append(shadowed.len);
+        }
+
+        void pop_scope()
+        {
+            assert(scope_starts.len);
+            s64 scope_start = scope_starts[--scope_starts.len];
+            while (shadowed.len > scope_start)
+            {
+                auto& shadowed_binding = shadowed[--shadowed.len];
+                bindings.get(shadowed_binding.name) = shadowed_binding.binding;
+            }
+        }
+    };
+
     struct Parser
     {
-        Token* ptr;
+        TokenStream& tokens;
         s64 parser_it;
-        s64 len;
-        Allocator allocator;
+        Token token_window[token_window_size];
+        Allocator& allocator;
+        // @Info: null when the allocator can't grow
+        Arena* arena;
         NodeBuffer nb;
         Compiler& compiler;
 
@@ -26,12 +195,40 @@ namespace AST
 
         Node* current_scope;
         Node* current_function;
+        ScopedSymbolTable variables;
+        FunctionTable functions;
+        // @Info: calls to functions which weren't defined yet when the call was parsed
+        NodeRefBuffer unresolved_invoke_expressions;
+        // @Info: the float literals only need typing when the file has some
+        s64 float_literal_count;
+
+        // @Info: makes room for size bytes, and for the parser buffers a statement can make grow
+        void reserve(s64 size)
+        {
+            if (arena)
+            {
+                s64 buffers_size = unresolved_invoke_expressions.cap * sizeof(*unresolved_invoke_expressions.ptr) + variables.shadowed.cap * sizeof(ShadowedBinding) + variables.scope_starts.cap * sizeof(s64);
+                arena->reserve(size + 2 * buffers_size);
+            }
+        }
+
+        inline bool has_token(s64 index)
+        {
+            return tokens.has_token(index, parser_it);
+        }
+
+        inline Token* get_token(s64 index)
+        {
+            Token* token = &token_window[index & (token_window_size - 1)];
+            tokens.get_token(index, token);
+            return token;
+        }
 
         inline Token* get_next_token(s64 i)
         {
-            if (parser_it + i < len)
+            if (has_token(parser_it + i))
             {
-                return &ptr[parser_it + i];
+                return get_token(parser_it + i);
             }
             return nullptr;
         }
@@ -44,14 +241,9 @@ namespace AST
         template<typename T>
         inline Token* expect(T id)
         {
-            Token* t = get_next_token();
-            if (t)
+            if (has_token(parser_it) && tokens.get_id(parser_it) == static_cast<TokenID>(id))
             {
-                if (t->id == static_cast<TokenID>(id))
-                {
-                    return t;
-                }
-                return nullptr;
+                return get_token(parser_it);
             }
             return nullptr;
         }
@@ -81,9 +273,7 @@ namespace AST
         template<typename T>
         inline bool expect_and_consume_twice(T id1, T id2)
         {
-            Token* t1 = get_next_token(0);
-            Token* t2 = get_next_token(1);
-            bool result = (t1 && t1->id == static_cast<TokenID>(id1) && t2 && t2->id == static_cast<TokenID>(id2));
+            bool result = has_token(parser_it + 1) && tokens.get_id(parser_it) == static_cast<TokenID>(id1) && tokens.get_id(parser_it + 1) == static_cast<TokenID>(id2);
             if (result)
             {
                 consume(); consume();
@@ -94,7 +284,9 @@ namespace AST
 
         inline Token* consume()
         {
-            auto* result = &ptr[parser_it++];
+            bool available = has_token(parser_it);
+            assert(available);
+            auto* result = get_token(parser_it++);
             printf("Consuming: ");
             result->print_token_id();
             return result;
@@ -199,7 +391,7 @@ namespace AST
             return BinOp::None;
         }
 
-        Type* parser_get_type_scanning(Node* parent)
+        TypeRef parser_get_type_scanning(Node* parent)
         {
             auto* t = consume();
             auto id = t->get_id();
@@ -207,16 +399,26 @@ namespace AST
             {
                 case TokenID::Type:
                     return t->type;
+                case TokenID::Symbol:
+                {
+                    // @Info: a struct name lexed before its declaration was parsed is still a symbol
+                    auto name = compiler.symbols.get_name(t->symbol);
+                    TypeRef type = type_declarations.find_by_name(name);
+                    if (!type)
+                    {
+                        compiler.print_error({}, "Unknown type %.*s", static_cast<s32>(name.len), name.get());
+                    }
+                    return type;
+                }
                 case TokenID::Ampersand:
                 {
-                    auto* type = parser_get_type_scanning(parent);
-                    assert(type);
-                    return Type::get_pointer_type(type, type_declarations);
+                    TypeRef type = parser_get_type_scanning(parent);
+                    return type ? Type::get_pointer_type(type, type_declarations) : no_type;
                 }
                 case TokenID::LeftBracket:
                 {
                     auto i = 0;
-                    Type* array_elements_type = nullptr;
+                    TypeRef array_elements_type = no_type;
                     Token* in_brackets_token = nullptr;
                     s64 array_length = 0;
                     if ((in_brackets_token = expect_and_consume(TokenID::IntegerLit)))
@@ -229,61 +431,56 @@ namespace AST
                     assert(array_elements_type);
                     assert(right_bracket);
 
-                    auto* array_type = Type::get_array_type(array_elements_type, array_length, type_declarations);
-                    return array_type;
+                    return Type::get_array_type(array_elements_type, array_length, type_declarations);
                 }
                 default:
                     RNS_NOT_IMPLEMENTED;
                     break;
             }
 
-            return nullptr;
+            return no_type;
         }
 
         Node* find_existing_variable(Token* token)
         {
-            RNS::String name = { token->symbol, token->offset };
-            for (auto* var : current_function->function.arguments)
-            {
-                assert(var->type == NodeType::VarDecl);
-                if (var->var_decl.name.equal(name))
-                {
-                    return var;
-                }
-            }
-            for (auto* var : current_function->function.variables)
+            return variables.find(token->symbol);
+        }
+
+        bool declare_variable(Node* var_decl)
+        {
+            assert(var_decl->type == NodeType::VarDecl);
+            if (!variables.declare(var_decl->var_decl.name, var_decl))
             {
-                assert(var->type == NodeType::VarDecl);
-                if (var->var_decl.name.equal(name))
-                {
-                    return var;
-                }
+                auto name = compiler.symbols.get_name(var_decl->var_decl.name);
+                compiler.print_error({}, "Variable %.*s is already declared in this scope", static_cast<s32>(name.len), name.get());
+                return false;
             }
 
-            return nullptr;
+            return true;
         }
 
         Node* find_existing_invoke_expression(Token* token)
         {
-            String name = { token->symbol, token->offset };
+            return functions.find(token->symbol);
+        }
 
-            for (auto* function_node : this->function_declarations)
+        // @Info: calls to functions the file doesn't define are kept in the buffer, the driver resolves them against every file once
+        // they are merged
+        void resolve_invoke_expressions()
+        {
+            s64 external_count = 0;
+            for (auto* invoke_expr_node : unresolved_invoke_expressions)
             {
-                if (function_node->function.name.equal(name))
+                invoke_expr_node->invoke_expr.expr = functions.find(invoke_expr_node->invoke_expr.name);
+                if (!invoke_expr_node->invoke_expr.expr)
                 {
-                    return function_node;
+                    unresolved_invoke_expressions[external_count++] = invoke_expr_node;
                 }
             }
-
-            if (name.equal(current_function->function.name))
-            {
-                return current_function;
-            }
-
-            return nullptr;
+            unresolved_invoke_expressions.len = external_count;
         }
 
-        Type* get_type(Node* node, Type* expected_type = nullptr)
+        TypeRef get_type(Node* node, TypeRef expected_type = no_type)
         {
             switch (node->type)
             {
@@ -291,18 +488,28 @@ namespace AST
                 {
                     if (expected_type)
                     {
-                        switch (expected_type->id)
+                        switch (type_declarations[expected_type].id)
                         {
                             // @TODO: check if it fits
                             case TypeID::IntegerType:
                                 return expected_type;
                             case TypeID::ArrayType:
                             {
-                                auto* arrtype = expected_type->array_t.type;
+                                TypeRef arrtype = type_declarations[expected_type].array_t.type;
                                 assert(arrtype);
-                                assert(arrtype->id == TypeID::IntegerType);
+                                assert(type_declarations[arrtype].id == TypeID::IntegerType);
                                 return arrtype;
                             }
+                            case TypeID::FixedVectorType:
+                            {
+                                TypeRef lane_type = type_declarations[expected_type].vector_t.type;
+                                if (type_declarations[lane_type].id == TypeID::IntegerType)
+                                {
+                                    return lane_type;
+                                }
+                                compiler.print_error({}, "Integer literal where a float vector is expected");
+                                return no_type;
+                            }
                             default:
                                 RNS_NOT_IMPLEMENTED;
                                 break;
@@ -313,17 +520,99 @@ namespace AST
                         RNS_NOT_IMPLEMENTED;
                     }
                 } break;
+                case NodeType::FloatLit:
+                {
+                    if (expected_type)
+                    {
+                        switch (type_declarations[expected_type].id)
+                        {
+                            case TypeID::FloatType:
+                            case TypeID::DoubleType:
+                                return expected_type;
+                            case TypeID::ArrayType:
+                            {
+                                TypeRef arrtype = type_declarations[expected_type].array_t.type;
+                                assert(arrtype);
+                                assert(type_declarations[arrtype].id == TypeID::FloatType || type_declarations[arrtype].id == TypeID::DoubleType);
+                                return arrtype;
+                            }
+                            case TypeID::FixedVectorType:
+                            {
+                                TypeRef lane_type = type_declarations[expected_type].vector_t.type;
+                                if (type_declarations[lane_type].id == TypeID::FloatType || type_declarations[lane_type].id == TypeID::DoubleType)
+                                {
+                                    return lane_type;
+                                }
+                                compiler.print_error({}, "Float literal where an integer vector is expected");
+                                return no_type;
+                            }
+                            default:
+                                RNS_NOT_IMPLEMENTED;
+                                break;
+                        }
+                    }
+                    else
+                    {
+                        return Type::get_float_type(node->float_lit.bit_count, type_declarations);
+                    }
+                } break;
                 case NodeType::VarDecl:
                 {
-                    auto* var_type = node->var_decl.type;
+                    TypeRef var_type = node->var_decl.type;
                     assert(var_type);
                     return var_type;
                 } break;
+                case NodeType::VarExpr:
+                {
+                    assert(node->var_expr.mentioned);
+                    return get_type(node->var_expr.mentioned);
+                } break;
+                case NodeType::MemberAccess:
+                {
+                    TypeRef struct_type = get_type(node->member_access.expr_ref);
+                    assert(type_declarations[struct_type].id == TypeID::StructType);
+                    return type_declarations[struct_type].struct_t.field_types[node->member_access.field_index];
+                } break;
                 default:
                     RNS_NOT_IMPLEMENTED;
                     break;
             }
 
+            return no_type;
+        }
+
+        Node* parse_member_access(Node* struct_expression, Node* parent)
+        {
+            Token* field_token = expect_and_consume(TokenID::Symbol);
+            if (!field_token)
+            {
+                compiler.print_error({}, "Expected a field name");
+                return nullptr;
+            }
+
+            TypeRef struct_type = get_type(struct_expression);
+            if (type_declarations[struct_type].id != TypeID::StructType)
+            {
+                compiler.print_error({}, "Only structs have fields");
+                return nullptr;
+            }
+
+            auto& struct_t = type_declarations[struct_type].struct_t;
+            for (s64 i = 0; i < struct_t.field_count; i++)
+            {
+                if (struct_t.field_names[i] == field_token->symbol)
+                {
+                    Node* member_access_node = nb.append(NodeType::MemberAccess, parent);
+                    struct_expression->parent = member_access_node;
+                    member_access_node->member_access.expr_ref = struct_expression;
+                    member_access_node->member_access.field_index = static_cast<u32>(i);
+                    return member_access_node;
+                }
+            }
+
+            auto struct_name = type_declarations.get_name(struct_type);
+            auto field_name = compiler.symbols.get_name(field_token->symbol);
+            compiler.print_error({}, "Struct %.*s has no field %.*s", static_cast<s32>(struct_name.len), struct_name.get(), static_cast<s32>(field_name.len), field_name.get());
             return nullptr;
         }
 
@@ -341,6 +630,23 @@ namespace AST
                     node->int_lit.lit = t->int_lit;
                     return node;
                 }
+                case TokenID::FloatLit:
+                {
+                    this->consume();
+                    // @Info: the literal is decoded again from the source if it turns out to be f32, see type_float_literals
+                    if (t->offset > UINT16_MAX)
+                    {
+                        compiler.print_error({}, "Float literal is too long");
+                        return nullptr;
+                    }
+                    Node* node = nb.append(NodeType::FloatLit, parent);
+                    node->float_lit.lit = t->float_lit;
+                    node->float_lit.bit_count = 64;
+                    node->float_lit.source_start = static_cast<u32>(t->start);
+                    node->float_lit.source_len = static_cast<u16>(t->offset);
+                    float_literal_count++;
+                    return node;
+                }
                 case TokenID::Symbol:
                 {
                     consume();
@@ -348,15 +654,18 @@ namespace AST
                     if (next_t)
                     {
                         auto* var_decl_node = nb.append(NodeType::VarDecl, parent);
-                        var_decl_node->var_decl.name.ptr = t->symbol;
-                        var_decl_node->var_decl.name.len = t->offset;
+                        var_decl_node->var_decl.name = t->symbol;
                         return var_decl_node;
                     }
                     else if ((u32)get_next_token()->id == '(')
                     {
                         auto* invoke_expr_node = nb.append(NodeType::InvokeExpr, parent);
+                        invoke_expr_node->invoke_expr.name = t->symbol;
                         invoke_expr_node->invoke_expr.expr = find_existing_invoke_expression(t);
-                        assert(invoke_expr_node->invoke_expr.expr);
+                        if (!invoke_expr_node->invoke_expr.expr)
+                        {
+                            unresolved_invoke_expressions.append(invoke_expr_node);
+                        }
                         auto* left_paren = expect_and_consume('(');
                         if (!left_paren)
                         {
@@ -387,8 +696,19 @@ namespace AST
                     {
                         auto* var_expr_node = nb.append(NodeType::VarExpr, parent);
                         var_expr_node->var_expr.mentioned = find_existing_variable(t);
-                        assert(var_expr_node->var_expr.mentioned);
-                        return var_expr_node;
+                        if (!var_expr_node->var_expr.mentioned)
+                        {
+                            auto name = compiler.symbols.get_name(t->symbol);
+                            compiler.print_error({}, "Undeclared variable %.*s", static_cast<s32>(name.len), name.get());
+                            return nullptr;
+                        }
+
+                        Node* expression = var_expr_node;
+                        while (expression && expect_and_consume('.'))
+                        {
+                            expression = parse_member_access(expression, parent);
+                        }
+                        return expression;
                     }
                 } break;
                 case TokenID::Minus:
@@ -466,8 +786,14 @@ namespace AST
                         }
 
                         auto* first_element = array_lit_node->array_lit.elements[0];
-                        auto* expected_type = get_type(parent);
-                        auto* elem_type = get_type(first_element, expected_type);
+                        TypeRef expected_type = get_type(parent);
+                        // @Info: a vector is initialized lane by lane from an array literal
+                        if (type_declarations[expected_type].id == TypeID::FixedVectorType && type_declarations[expected_type].vector_t.count != array_lit_node->array_lit.elements.len)
+                        {
+                            compiler.print_error({}, "Expected %u lanes in the vector literal, found %lld", type_declarations[expected_type].vector_t.count, array_lit_node->array_lit.elements.len);
+                            return nullptr;
+                        }
+                        TypeRef elem_type = get_type(first_element, expected_type);
                         auto arrlen = array_lit_node->array_lit.elements.len;
                         array_lit_node->array_lit.type = Type::get_array_type(elem_type, arrlen, type_declarations);
                     }
@@ -504,6 +830,7 @@ namespace AST
             if_block->block.type = Block::Type::IfBlock;
             if_block->parent = node;
             current_scope = if_block;
+            variables.push_scope();
 
             if (braces)
             {
@@ -522,6 +849,7 @@ namespace AST
                 if_block->block.statements.append(st_node);
             }
 
+            variables.pop_scope();
             current_scope = current_scope->parent;
 
             if (expect_and_consume_if_keyword(KeywordID::Else))
@@ -531,6 +859,7 @@ namespace AST
                 current_function->function.scope_blocks.append(else_block);
                 else_block->block.type = Block::Type::ElseBlock;
                 current_scope = else_block;
+                variables.push_scope();
 
                 braces = expect_and_consume('{');
                 if (braces)
@@ -550,6 +879,7 @@ namespace AST
                     assert(st_node);
                     else_block->block.statements.append(st_node);
                 }
+                variables.pop_scope();
                 current_scope = current_scope->parent;
             }
 
@@ -562,6 +892,8 @@ namespace AST
             assert(for_t);
             Node* for_loop = nb.append(NodeType::Loop, parent);
             auto* parent_scope = current_scope;
+            // @Info: the iterator is only visible in the loop
+            variables.push_scope();
 
             auto create_loop_block = [&](Block::Type loop_block_type)
             {
@@ -580,7 +912,7 @@ namespace AST
             assert(it_symbol);
             Node* it_decl = nb.append(NodeType::VarDecl, for_loop);
             it_decl->var_decl.is_fn_arg = false;
-            it_decl->var_decl.name = RNS::String{ it_symbol->symbol, it_symbol->offset };
+            it_decl->var_decl.name = it_symbol->symbol;
             it_decl->var_decl.scope = current_scope;
             it_decl->var_decl.type = Type::get_integer_type(32, true, type_declarations);
             // @TODO: we should match it to the right operand
@@ -590,6 +922,10 @@ namespace AST
             it_decl->var_decl.value->int_lit.lit = 0;
             this->current_function->function.variables.append(it_decl);
             this->current_scope->block.statements.append(it_decl);
+            if (!declare_variable(it_decl))
+            {
+                return nullptr;
+            }
 
             {
                 current_scope = for_loop->loop.prefix;
@@ -655,6 +991,7 @@ namespace AST
                 current_scope->block.statements.append(postfix_assign);
             }
 
+            variables.pop_scope();
             current_scope = parent_scope;
             return for_loop;
         }
@@ -745,6 +1082,38 @@ namespace AST
             return node;
         }
 
+        // @Info: a literal assigned to a field takes the type of the field, like the value of a variable declaration takes the type of
+        // the variable. Fields are often narrower than the literal default, and reordering packs them next to each other
+        bool type_field_literal(Node* member_access, Node* value)
+        {
+            bool is_integer_literal = value->type == NodeType::IntLit;
+            if (!is_integer_literal && value->type != NodeType::FloatLit)
+            {
+                return true;
+            }
+
+            TypeRef field_type = get_type(member_access);
+            auto field_type_id = type_declarations[field_type].id;
+            bool is_float_field = field_type_id == TypeID::FloatType || field_type_id == TypeID::DoubleType;
+            if (field_type_id != TypeID::FixedVectorType && (is_integer_literal ? field_type_id != TypeID::IntegerType : !is_float_field))
+            {
+                compiler.print_error({}, "%s literal assigned to a field of another kind", is_integer_literal ? "Integer" : "Float");
+                return false;
+            }
+
+            TypeRef literal_type = get_type(value, field_type);
+            if (!literal_type)
+            {
+                return false;
+            }
+            // @Info: is_signed tells the literal is negative, it is left as the lexer found it
+            if (is_integer_literal && type_declarations[literal_type].id == TypeID::IntegerType)
+            {
+                value->int_lit.bit_count = type_declarations[literal_type].integer_t.bits;
+            }
+            return true;
+        }
+
         Node* parse_right_expression(Node** left_expr, Node* parent)
         {
             BinOp bin_op;
@@ -776,6 +1145,10 @@ namespace AST
                     {
                         return nullptr;
                     }
+                    if (bin_op == BinOp::Assign && binary_op_left_expression->type == NodeType::MemberAccess && !type_field_literal(binary_op_left_expression, binary_op_right_expression))
+                    {
+                        return nullptr;
+                    }
 
                     // @TODO: bad practice to use tagged union fields without knowing if they are what you want, but useful here
                     auto left_bin_op = binary_op_left_expression->bin_op.op;
@@ -825,9 +1198,17 @@ namespace AST
 
                 var_decl_node->var_decl.type = parser_get_type_scanning(parent);
 
+                // @Info: declared after its value is parsed, so the value sees what the name meant before
                 if (expect_and_consume('='))
                 {
-                    var_decl_node->var_decl.value = parse_expression(var_decl_node);
+                    auto* value = parse_expression(var_decl_node);
+                    var_decl_node->var_decl.value = value;
+                    // @Info: a literal initializing a vector is splat to all the lanes, so it has to be of their kind
+                    TypeRef var_type = var_decl_node->var_decl.type;
+                    if (value && type_declarations[var_type].id == TypeID::FixedVectorType && (value->type == NodeType::IntLit || value->type == NodeType::FloatLit) && !get_type(value, var_type))
+                    {
+                        return nullptr;
+                    }
                 }
 
                 // @TODO: should append to the current scope
@@ -836,6 +1217,10 @@ namespace AST
                     current_function->function.variables = current_function->function.variables.create(&allocator, 16);
                 }
                 current_function->function.variables.append(var_decl_node);
+                if (!declare_variable(var_decl_node))
+                {
+                    return nullptr;
+                }
 
                 return var_decl_node;
             }
@@ -858,6 +1243,9 @@ namespace AST
                 return;
             }
 
+            // @Info: the scope is left open on errors, the parser stops at the first one
+            variables.push_scope();
+
             Token* next_token;
             if (has_braces)
             {
@@ -869,6 +1257,7 @@ namespace AST
 
                 while (statement_left_to_parse)
                 {
+                    reserve(2 * scope_block->block.statements.cap * sizeof(Node*));
                     auto* statement = parse_statement(scope_block);
                     // @TODO: error logging and out
                     if (!statement)
@@ -894,6 +1283,127 @@ namespace AST
                 scope_block->block.statements = scope_block->block.statements.create(&allocator, 1);
                 scope_block->block.statements.append(statement);
             }
+
+            variables.pop_scope();
+        }
+
+        bool is_struct_declaration()
+        {
+            if (!has_token(parser_it + 3))
+            {
+                return false;
+            }
+
+            // @Info: the name is a type when the struct is declared again after the lexer saw the first declaration
+            auto name_id = tokens.get_id(parser_it);
+            return (name_id == TokenID::Symbol || name_id == TokenID::Type) && tokens.get_id(parser_it + 1) == TokenID::Colon && tokens.get_id(parser_it + 2) == TokenID::Colon &&
+                tokens.get_id(parser_it + 3) == TokenID::Keyword && get_token(parser_it + 3)->keyword == KeywordID::Struct;
+        }
+
+        TypeRef parse_struct(bool* parsed_ok)
+        {
+            Token* name_token = consume();
+            RNS::StringView name = name_token->get_id() == TokenID::Symbol ? compiler.symbols.get_name(name_token->symbol) : type_declarations.get_name(name_token->type);
+            consume(); consume(); consume();
+            if (name_token->get_id() == TokenID::Type || type_declarations.find_by_name(name))
+            {
+                compiler.print_error({}, "Type %.*s is already defined", static_cast<s32>(name.len), name.get());
+                return no_type;
+            }
+
+            StructType struct_type = {};
+            while (expect_and_consume('#'))
+            {
+                Token* attribute = expect_and_consume(TokenID::Symbol);
+                auto attribute_name = attribute ? compiler.symbols.get_name(attribute->symbol) : RNS::StringView{};
+                if (attribute_name.equal(RNS::StringView::create("ordered", 7)))
+                {
+                    struct_type.declaration_order = true;
+                }
+                else if (attribute_name.equal(RNS::StringView::create("cache_line", 10)))
+                {
+                    struct_type.cache_line_aligned = true;
+                }
+                else
+                {
+                    compiler.print_error({}, "Unknown struct attribute %.*s, expected #ordered or #cache_line", static_cast<s32>(attribute_name.len), attribute_name.get());
+                    return no_type;
+                }
+            }
+
+            if (!expect_and_consume('{'))
+            {
+                compiler.print_error({}, "Expected braces");
+                return no_type;
+            }
+
+            // @Info: the struct is in the table before its fields are parsed, so that they can point to it
+            TypeRef struct_type_ref = Type::declare_struct_type(name, type_declarations);
+
+            SymbolID field_names[struct_max_field_count];
+            TypeRef field_types[struct_max_field_count];
+            s64 field_count = 0;
+            while (!expect_and_consume('}'))
+            {
+                Token* field_token = expect_and_consume(TokenID::Symbol);
+                if (!field_token || !expect_and_consume(':'))
+                {
+                    compiler.print_error({}, "Expected a field declaration in struct %.*s", static_cast<s32>(name.len), name.get());
+                    return no_type;
+                }
+                SymbolID field_name = field_token->symbol;
+                if (field_count == struct_max_field_count)
+                {
+                    compiler.print_error({}, "Struct %.*s has more than %lld fields", static_cast<s32>(name.len), name.get(), struct_max_field_count);
+                    return no_type;
+                }
+                for (s64 i = 0; i < field_count; i++)
+                {
+                    if (field_names[i] == field_name)
+                    {
+                        auto field_string = compiler.symbols.get_name(field_name);
+                        compiler.print_error({}, "Field %.*s is declared twice in struct %.*s", static_cast<s32>(field_string.len), field_string.get(), static_cast<s32>(name.len), name.get());
+                        return no_type;
+                    }
+                }
+
+                TypeRef field_type = parser_get_type_scanning(nullptr);
+                if (!field_type || !expect_and_consume(';'))
+                {
+                    compiler.print_error({}, "Error parsing field %lld of struct %.*s", field_count + 1, static_cast<s32>(name.len), name.get());
+                    return no_type;
+                }
+                TypeRef field_value_type = field_type;
+                while (type_declarations[field_value_type].id == TypeID::ArrayType)
+                {
+                    field_value_type = type_declarations[field_value_type].array_t.type;
+                }
+                if (field_value_type == struct_type_ref)
+                {
+                    compiler.print_error({}, "Struct %.*s contains itself, only a pointer to it can be a field", static_cast<s32>(name.len), name.get());
+                    return no_type;
+                }
+                field_names[field_count] = field_name;
+                field_types[field_count] = field_type;
+                field_count++;
+            }
+
+            // @Info: the fields are copied next to the type, which outlives the parser
+            struct_type.field_count = field_count;
+            if (type_declarations.arena)
+            {
+                type_declarations.arena->reserve(field_count * (sizeof(SymbolID) + sizeof(TypeRef)));
+            }
+            struct_type.field_names = new(type_declarations.allocator) SymbolID[field_count];
+            struct_type.field_types = new(type_declarations.allocator) TypeRef[field_count];
+            memcpy(struct_type.field_names, field_names, field_count * sizeof(SymbolID));
+            memcpy(struct_type.field_types, field_types, field_count * sizeof(TypeRef));
+
+            *parsed_ok = true;
+
+            Type::define_struct_type(struct_type_ref, struct_type, type_declarations);
+
+            return struct_type_ref;
         }
 
         Node* parse_function(bool* parsed_ok)
@@ -913,9 +1423,17 @@ namespace AST
             auto* function_node = nb.append(NodeType::Function, nullptr);
             function_node->function = {
                 .scope_blocks = Buffer<Node*>::create(&allocator, 16),
-                .name = { t->symbol, t->offset },
+                .name = t->symbol,
             };
             current_function = function_node;
+            if (!functions.define(t->symbol, function_node))
+            {
+                auto name = compiler.symbols.get_name(t->symbol);
+                compiler.print_error({}, "Function %.*s is already defined", static_cast<s32>(name.len), name.get());
+                return nullptr;
+            }
+            // @Info: the arguments are in a scope of their own around the body
+            variables.push_scope();
 
             // @TODO: change this to be properly handled by the function parser
             auto token_id = expect_and_consume('(');
@@ -993,6 +1511,7 @@ namespace AST
             current_scope->parent = function_node;
 
             parse_block(current_scope, false);
+            variables.pop_scope();
 
             if (compiler.errors_reported)
             {
@@ -1004,6 +1523,188 @@ namespace AST
             return function_node;
         }
     };
+
+    /* Float literal types
+     * The lexer decodes every float literal as f64 and the parser keeps it that way, since the type a literal is expected to have is
+     * often only known further on: the other operand comes after it, or the function it is passed to is defined later in the file or
+     * in another one. Once every call is resolved, which for a module of several files is only after the driver has merged them, the
+     * function bodies are walked with the type each expression is expected to have, which comes from the declared variable, the
+     * assigned one, the return type, the argument or the other operand. The literals which turn out to be f32 are decoded again from
+     * the source, since rounding the f64 value to f32 could round twice.
+     */
+    struct FloatLiteralTyping
+    {
+        Compiler& compiler;
+        RNS::String source;
+        TypeBuffer& type_declarations;
+        Node* current_function;
+
+        // @Info: the type a literal takes in a place where that type is expected: array literals and vectors spread it over their elements
+        TypeRef get_element_type(TypeRef type)
+        {
+            if (type_declarations[type].id == TypeID::ArrayType)
+            {
+                return type_declarations[type].array_t.type;
+            }
+            if (type_declarations[type].id == TypeID::FixedVectorType)
+            {
+                return type_declarations[type].vector_t.type;
+            }
+            return type;
+        }
+
+        // @Info: the type an expression is known to have, without looking at literals, which take their type from the rest of the expression
+        TypeRef get_expression_type(Node* node)
+        {
+            switch (node->type)
+            {
+                case NodeType::VarDecl:
+                    return node->var_decl.type;
+                case NodeType::VarExpr:
+                    return node->var_expr.mentioned->var_decl.type;
+                case NodeType::MemberAccess:
+                {
+                    TypeRef struct_type = get_expression_type(node->member_access.expr_ref);
+                    return struct_type ? type_declarations[struct_type].struct_t.field_types[node->member_access.field_index] : no_type;
+                }
+                case NodeType::Subscript:
+                {
+                    TypeRef container_type = get_expression_type(node->subscript.expr_ref);
+                    return container_type ? get_element_type(container_type) : no_type;
+                }
+                case NodeType::UnaryOp:
+                {
+                    TypeRef pointer_type = node->unary_op.type == UnaryOp::PointerDereference ? get_expression_type(node->unary_op.node) : no_type;
+                    return pointer_type && type_declarations[pointer_type].id == TypeID::PointerType ? type_declarations[pointer_type].pointer_t.appointee : no_type;
+                }
+                case NodeType::InvokeExpr:
+                    return node->invoke_expr.expr ? node->invoke_expr.expr->function.type->type_expr.function_t.ret_type : no_type;
+                case NodeType::BinOp:
+                {
+                    if (is_cmp_binop(node->bin_op.op))
+                    {
+                        return no_type;
+                    }
+                    TypeRef left_type = get_expression_type(node->bin_op.left);
+                    return left_type || node->bin_op.op == BinOp::Assign ? left_type : get_expression_type(node->bin_op.right);
+                }
+                default:
+                    return no_type;
+            }
+        }
+
+        bool type_float_literals(Node* node, TypeRef expected_type)
+        {
+            switch (node->type)
+            {
+                case NodeType::FloatLit:
+                {
+                    TypeRef float_type = expected_type ? get_element_type(expected_type) : no_type;
+                    if (float_type && type_declarations[float_type].id == TypeID::FloatType && node->float_lit.bit_count != 32)
+                    {
+                        f64 value;
+                        const char* error = decode_float_literal(&source.ptr[node->float_lit.source_start], node->float_lit.source_len, 32, &value);
+                        if (error)
+                        {
+                            compiler.print_error({}, "%s", error);
+                            return false;
+                        }
+                        node->float_lit.lit = value;
+                        node->float_lit.bit_count = 32;
+                    }
+                    return true;
+                }
+                case NodeType::ArrayLit:
+                {
+                    TypeRef element_type = expected_type ? get_element_type(expected_type) : no_type;
+                    for (auto* element : node->array_lit.elements)
+                    {
+                        if (!type_float_literals(element, element_type))
+                        {
+                            return false;
+                        }
+                    }
+                    return true;
+                }
+                case NodeType::BinOp:
+                {
+                    auto& bin_op = node->bin_op;
+                    if (bin_op.op == BinOp::Assign)
+                    {
+                        return type_float_literals(bin_op.left, no_type) && type_float_literals(bin_op.right, get_expression_type(bin_op.left));
+                    }
+                    // @Info: both operands have the same type, a comparison gives a type of its own
+                    TypeRef operand_type = get_expression_type(node);
+                    if (is_cmp_binop(bin_op.op))
+                    {
+                        TypeRef left_type = get_expression_type(bin_op.left);
+                        operand_type = left_type ? left_type : get_expression_type(bin_op.right);
+                    }
+                    else if (!operand_type)
+                    {
+                        operand_type = expected_type;
+                    }
+                    return type_float_literals(bin_op.left, operand_type) && type_float_literals(bin_op.right, operand_type);
+                }
+                case NodeType::UnaryOp:
+                    return type_float_literals(node->unary_op.node, no_type);
+                case NodeType::Subscript:
+                    return type_float_literals(node->subscript.expr_ref, no_type) && type_float_literals(node->subscript.index_ref, no_type);
+                case NodeType::MemberAccess:
+                    return type_float_literals(node->member_access.expr_ref, no_type);
+                case NodeType::VarDecl:
+                    return !node->var_decl.value || type_float_literals(node->var_decl.value, node->var_decl.type);
+                case NodeType::Ret:
+                    return !node->ret.expr || type_float_literals(node->ret.expr, current_function->function.type->type_expr.function_t.ret_type);
+                case NodeType::InvokeExpr:
+                {
+                    Node* function = node->invoke_expr.expr;
+                    auto& arguments = node->invoke_expr.arguments;
+                    for (s64 i = 0; i < arguments.len; i++)
+                    {
+                        auto* arg_types = function ? &function->function.type->type_expr.function_t.arg_types : nullptr;
+                        if (!type_float_literals(arguments[i], arg_types && i < arg_types->len ? (*arg_types)[i] : no_type))
+                        {
+                            return false;
+                        }
+                    }
+                    return true;
+                }
+                case NodeType::Conditional:
+                    return type_float_literals(node->conditional.condition, no_type) && type_float_literals(node->conditional.if_block, no_type) &&
+                        (!node->conditional.else_block || type_float_literals(node->conditional.else_block, no_type));
+                case NodeType::Loop:
+                    return type_float_literals(node->loop.prefix, no_type) && type_float_literals(node->loop.body, no_type) && type_float_literals(node->loop.postfix, no_type);
+                case NodeType::Block:
+                {
+                    for (auto* statement : node->block.statements)
+                    {
+                        if (!type_float_literals(statement, no_type))
+                        {
+                            return false;
+                        }
+                    }
+                    return true;
+                }
+                default:
+                    return true;
+            }
+        }
+
+        bool type_float_literals(FunctionDeclarationBuffer& function_declarations)
+        {
+            for (auto* function_node : function_declarations)
+            {
+                current_function = function_node;
+                if (!type_float_literals(function_node->function.scope_blocks[0], no_type))
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+    };
 }
 
 const char* node_type_to_string(NodeType type)
@@ -1011,6 +1712,7 @@ const char* node_type_to_string(NodeType type)
     switch (type)
     {
         rns_case_to_str(NodeType::IntLit);
+        rns_case_to_str(NodeType::FloatLit);
         rns_case_to_str(NodeType::BinOp);
         rns_case_to_str(NodeType::Ret);
         rns_case_to_str(NodeType::VarDecl);
@@ -1021,17 +1723,17 @@ const char* node_type_to_string(NodeType type)
     }
 }
 
-AST::Result parse(Compiler& compiler, LexerResult& lexer_result, TypeBuffer& type_declarations)
+AST::Result parse(Compiler& compiler, TokenStream& token_stream, TypeBuffer& type_declarations, Allocator& allocator, Arena* arena)
 {
     RNS_PROFILE_FUNCTION();
-    compiler.subsystem = Compiler::Subsystem::Parser;
+    compiler.set_subsystem(Compiler::Subsystem::Parser);
 
     Parser parser = {
-        .ptr = lexer_result.ptr,
+        .tokens = token_stream,
         .parser_it = 0,
-        .len = lexer_result.len,
-        .allocator = create_suballocator(&compiler.page_allocator, RNS_MEGABYTE(300)),
-        .nb = NodeBuffer::create(&parser.allocator, 1024),
+        .allocator = allocator,
+        .arena = arena,
+        .nb = NodeBuffer::create(&parser.allocator, arena),
         .compiler = compiler,
         .function_declarations = FunctionDeclarationBuffer::create(&parser.allocator, 64),
         .struct_declarations = StructBuffer::create(&parser.allocator, 64),
@@ -1039,11 +1741,25 @@ AST::Result parse(Compiler& compiler, LexerResult& lexer_result, TypeBuffer& typ
         .enum_declarations = EnumBuffer::create(&parser.allocator, 64),
         .function_type_declarations = FunctionTypeBuffer::create(&parser.allocator, 64),
         .type_declarations = type_declarations,
+        .variables = ScopedSymbolTable::create(&parser.allocator, compiler.symbols.len > 1024 ? compiler.symbols.len : 1024, arena),
+        .functions = FunctionTable::create(&parser.allocator, compiler.symbols.len > 1024 ? compiler.symbols.len : 1024, arena),
+        .unresolved_invoke_expressions = NodeRefBuffer::create(&parser.allocator, 64),
     };
 
-    while (parser.parser_it < parser.len)
+    while (parser.has_token(parser.parser_it))
     {
+        parser.reserve(2 * (parser.function_declarations.cap * sizeof(*parser.function_declarations.ptr) + parser.function_type_declarations.cap * sizeof(*parser.function_type_declarations.ptr) + parser.struct_declarations.cap * sizeof(*parser.struct_declarations.ptr)));
         bool parsed_ok = false;
+        if (parser.is_struct_declaration())
+        {
+            parser.parse_struct(&parsed_ok);
+            if (parsed_ok)
+            {
+                continue;
+            }
+            return { .node_buffer = parser.nb, .function_type_declarations = parser.function_type_declarations, .function_declarations = parser.function_declarations };
+        }
+
         auto fn_decl = parser.parse_function(&parsed_ok);
         if (compiler.errors_reported)
         {
@@ -1059,5 +1775,20 @@ AST::Result parse(Compiler& compiler, LexerResult& lexer_result, TypeBuffer& typ
         return { .node_buffer = parser.nb, .function_type_declarations = parser.function_type_declarations, .function_declarations = parser.function_declarations };
     }
 
-    return { .node_buffer = parser.nb, .function_type_declarations = parser.function_type_declarations, .function_declarations = parser.function_declarations }; // Omit error message as it's only filled when there's an actual error message
+    // @Info: the errors are reported through the compiler, the result is the same either way
+    parser.resolve_invoke_expressions();
+
+    return { .node_buffer = parser.nb, .function_type_declarations = parser.function_type_declarations, .function_declarations = parser.function_declarations, .external_invoke_expressions = parser.unresolved_invoke_expressions, .float_literal_count = parser.float_literal_count }; // Omit error message as it's only filled when there's an actual error message
+}
+
+bool type_float_literals(Compiler& compiler, RNS::String source, TypeBuffer& type_declarations, FunctionDeclarationBuffer& function_declarations)
+{
+    RNS_PROFILE_FUNCTION();
+    FloatLiteralTyping typing = {
+        .compiler = compiler,
+        .source = source,
+        .type_declarations = type_declarations,
+    };
+
+    return typing.type_float_literals(function_declarations);
 }
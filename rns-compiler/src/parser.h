@@ -1,5 +1,10 @@
 #pragma once
 #include <RNS/types.h>
 #include "compiler_types.h"
+#include "lexer.h"
 
-AST::Result parse(Compiler& compiler, LexerResult& lexer_result, TypeBuffer& type_declarations);
+// @Info: the nodes and declarations go to the allocator, which has to outlive them
+AST::Result parse(Compiler& compiler, TokenStream& token_stream, TypeBuffer& type_declarations, Allocator& allocator, Arena* arena = nullptr);
+// @Info: gives the float literals of the functions the type they are expected to have, which is only known once every call they
+// are in is resolved, so it runs after the files of the module are merged. source is the file the functions were parsed from
+bool type_float_literals(Compiler& compiler, RNS::String source, TypeBuffer& type_declarations, AST::FunctionDeclarationBuffer& function_declarations);
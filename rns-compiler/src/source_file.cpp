@@ -0,0 +1,179 @@
+#include "source_file.h"
+
+#include <stdio.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char empty_file_content[1] = {};
+
+#if defined(_WIN32)
+SourceFile SourceFile::map(const char* path)
+{
+    SourceFile source_file = { .path = path };
+
+    HANDLE file_handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file_handle == INVALID_HANDLE_VALUE)
+    {
+        printf("Couldn't open file %s\n", path);
+        return source_file;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file_handle, &file_size))
+    {
+        printf("Couldn't get the size of file %s\n", path);
+        CloseHandle(file_handle);
+        return source_file;
+    }
+
+    s64 size = file_size.QuadPart;
+    if (size == 0)
+    {
+        CloseHandle(file_handle);
+        source_file.content = { empty_file_content, 0 };
+        return source_file;
+    }
+
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+    s64 page_size = system_info.dwPageSize;
+
+    // @Info: the tail of the last page of a view is zero-filled, which gives us the '\0' sentinel for free. A read-only mapping
+    // can't be extended past the end of the file, so in the rare case the file fills its last page exactly we read it instead.
+    if (size % page_size != 0)
+    {
+        HANDLE mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping_handle)
+        {
+            void* view = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping_handle);
+            if (view)
+            {
+                CloseHandle(file_handle);
+                source_file.content = { (const char*)view, size };
+                source_file.mapping_base = view;
+                source_file.mapping_size = size;
+                source_file.is_mapped = true;
+                return source_file;
+            }
+        }
+    }
+
+    char* buffer = (char*)VirtualAlloc(nullptr, size + 1, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    assert(buffer);
+    s64 read_size = 0;
+    while (read_size < size)
+    {
+        DWORD chunk_size = (DWORD)((size - read_size) > UINT32_MAX ? UINT32_MAX : (size - read_size));
+        DWORD bytes_read = 0;
+        if (!ReadFile(file_handle, buffer + read_size, chunk_size, &bytes_read, nullptr) || bytes_read == 0)
+        {
+            printf("Couldn't read file %s\n", path);
+            VirtualFree(buffer, 0, MEM_RELEASE);
+            CloseHandle(file_handle);
+            return source_file;
+        }
+        read_size += bytes_read;
+    }
+    CloseHandle(file_handle);
+
+    source_file.content = { buffer, size };
+    source_file.mapping_base = buffer;
+    source_file.mapping_size = size + 1;
+    return source_file;
+}
+
+void SourceFile::unmap()
+{
+    if (mapping_base)
+    {
+        if (is_mapped)
+        {
+            UnmapViewOfFile(mapping_base);
+        }
+        else
+        {
+            VirtualFree(mapping_base, 0, MEM_RELEASE);
+        }
+    }
+
+    *this = {};
+}
+#else
+SourceFile SourceFile::map(const char* path)
+{
+    SourceFile source_file = { .path = path };
+
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+    {
+        printf("Couldn't open file %s\n", path);
+        return source_file;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == -1)
+    {
+        printf("Couldn't get the size of file %s\n", path);
+        close(fd);
+        return source_file;
+    }
+
+    s64 size = file_stat.st_size;
+    if (size == 0)
+    {
+        close(fd);
+        source_file.content = { empty_file_content, 0 };
+        return source_file;
+    }
+
+    // @Info: reserve one byte more than the file, rounded up to pages, as anonymous zeroed memory and map the file on top of it.
+    // Whatever lies past the end of the file is then guaranteed to read as zero, even when the file fills its last page exactly.
+    s64 page_size = sysconf(_SC_PAGESIZE);
+    s64 mapping_size = (size + 1 + page_size - 1) & ~(page_size - 1);
+    void* base = mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+    {
+        printf("Couldn't reserve memory for file %s\n", path);
+        close(fd);
+        return source_file;
+    }
+
+    void* file_view = mmap(base, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0);
+    close(fd);
+    if (file_view == MAP_FAILED)
+    {
+        printf("Couldn't map file %s\n", path);
+        munmap(base, mapping_size);
+        return source_file;
+    }
+
+    madvise(file_view, size, MADV_SEQUENTIAL);
+    madvise(file_view, size, MADV_WILLNEED);
+
+    source_file.content = { (const char*)file_view, size };
+    source_file.mapping_base = base;
+    source_file.mapping_size = mapping_size;
+    source_file.is_mapped = true;
+    return source_file;
+}
+
+void SourceFile::unmap()
+{
+    if (mapping_base)
+    {
+        munmap(mapping_base, mapping_size);
+    }
+
+    *this = {};
+}
+#endif
@@ -0,0 +1,17 @@
+#pragma once
+#include <RNS/types.h>
+#include <RNS/data_structures.h>
+
+// @Info: read-only, zero-copy view of a source file on disk. The lexer relies on a '\0' right after the last byte of the file,
+// so the mapping always guarantees that sentinel is readable.
+struct SourceFile
+{
+    RNS::String content;
+    const char* path;
+    void* mapping_base;
+    s64 mapping_size;
+    bool is_mapped;
+
+    static SourceFile map(const char* path);
+    void unmap();
+};
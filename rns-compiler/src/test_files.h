@@ -247,4 +247,68 @@ const RNS::String test_files[] = {
                 }
             }
             ),
+        // @Info: the fields are reordered to x, a, b, so the narrow ones share a word and have to be stored with their own width
+        NEW_TEST(
+            P :: struct
+            {
+                a: u8;
+                b: u8;
+                x: s32;
+            }
+            main :: () -> s32
+            {
+                p: P;
+                p.a = 1;
+                p.b = 2;
+                p.x = p.b;
+                return p.x + p.a;
+            }
+            ),
+        NEW_TEST(
+            Q :: struct
+            {
+                c: s8;
+                w: s64;
+                n: u16;
+            }
+            main :: () -> s32
+            {
+                q: Q;
+                q.c = 3;
+                q.w = q.c;
+                q.n = q.w + 1;
+                q.c = 1 + 2;
+                return q.n;
+            }
+            ),
+        NEW_TEST(
+            N :: struct
+            {
+                v: s32;
+                next: &N;
+            }
+            main :: () -> s32
+            {
+                m: N;
+                m.v = 7;
+                n: N;
+                n.next = &m;
+                n.v = 2;
+                return n.v;
+            }
+            ),
+        NEW_TEST(
+            main :: () -> s32
+            {
+                big: v16u8 = 200;
+                small: v16u8 = 3;
+                gt: v16u8 = big > small;
+                lt: v16u8 = small < big;
+                lit: v16u8 = big > 3;
+                signed_bytes: v16s8 = 100;
+                sgt: v16s8 = signed_bytes > 3;
+                arr: [1]s32 = [3];
+                return arr[0];
+            }
+            ),
 };
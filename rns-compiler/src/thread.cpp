@@ -0,0 +1,141 @@
+#include "thread.h"
+
+#include <string.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+static DWORD WINAPI thread_entry_point(LPVOID parameter)
+{
+    auto* thread = static_cast<Thread*>(parameter);
+    thread->function(thread->argument);
+    return 0;
+}
+
+bool Thread::start(ThreadFunction function, void* argument)
+{
+    this->function = function;
+    this->argument = argument;
+    HANDLE thread_handle = CreateThread(nullptr, 0, thread_entry_point, this, 0, nullptr);
+    handle = reinterpret_cast<u64>(thread_handle);
+
+    return thread_handle != nullptr;
+}
+
+void Thread::join()
+{
+    HANDLE thread_handle = reinterpret_cast<HANDLE>(handle);
+    WaitForSingleObject(thread_handle, INFINITE);
+    CloseHandle(thread_handle);
+    handle = 0;
+}
+
+u32 get_hardware_thread_count()
+{
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+    return system_info.dwNumberOfProcessors;
+}
+
+u32 atomic_increment(volatile u32* value)
+{
+    return static_cast<u32>(InterlockedIncrement(reinterpret_cast<volatile LONG*>(value))) - 1;
+}
+#else
+static_assert(sizeof(pthread_t) <= sizeof(u64));
+
+static void* thread_entry_point(void* parameter)
+{
+    auto* thread = static_cast<Thread*>(parameter);
+    thread->function(thread->argument);
+    return nullptr;
+}
+
+bool Thread::start(ThreadFunction function, void* argument)
+{
+    this->function = function;
+    this->argument = argument;
+    pthread_t thread_handle;
+    if (pthread_create(&thread_handle, nullptr, thread_entry_point, this) != 0)
+    {
+        return false;
+    }
+    handle = 0;
+    memcpy(&handle, &thread_handle, sizeof(thread_handle));
+
+    return true;
+}
+
+void Thread::join()
+{
+    pthread_t thread_handle;
+    memcpy(&thread_handle, &handle, sizeof(thread_handle));
+    pthread_join(thread_handle, nullptr);
+    handle = 0;
+}
+
+u32 get_hardware_thread_count()
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? static_cast<u32>(count) : 1;
+}
+
+u32 atomic_increment(volatile u32* value)
+{
+    return __atomic_fetch_add(value, 1, __ATOMIC_SEQ_CST);
+}
+#endif
+
+struct TaskQueue
+{
+    TaskFunction function;
+    void* context;
+    u32 task_count;
+    volatile u32 next_task;
+};
+
+static void run_queued_tasks(void* argument)
+{
+    auto* queue = static_cast<TaskQueue*>(argument);
+    for (u32 task_index = atomic_increment(&queue->next_task); task_index < queue->task_count; task_index = atomic_increment(&queue->next_task))
+    {
+        queue->function(queue->context, task_index);
+    }
+}
+
+void run_tasks(TaskFunction function, void* context, u32 task_count, u32 thread_count)
+{
+    TaskQueue queue = {
+        .function = function,
+        .context = context,
+        .task_count = task_count,
+        .next_task = 0,
+    };
+
+    u32 worker_count = thread_count < task_count ? thread_count : task_count;
+    worker_count = worker_count < max_worker_count ? worker_count : max_worker_count;
+
+    // @Info: if a thread can't be started the others just take its share of the tasks
+    Thread workers[max_worker_count] = {};
+    for (u32 i = 1; i < worker_count; i++)
+    {
+        workers[i].start(run_queued_tasks, &queue);
+    }
+
+    run_queued_tasks(&queue);
+
+    for (u32 i = 1; i < worker_count; i++)
+    {
+        if (workers[i].handle)
+        {
+            workers[i].join();
+        }
+    }
+}
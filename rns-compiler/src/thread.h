@@ -0,0 +1,29 @@
+#pragma once
+#include <RNS/types.h>
+
+using ThreadFunction = void (*)(void* argument);
+
+// @Info: minimal wrapper over the native threads. The Thread has to stay in place until it is joined, since the native thread
+// reads the function and its argument through it.
+struct Thread
+{
+    ThreadFunction function;
+    void* argument;
+    u64 handle;
+
+    bool start(ThreadFunction function, void* argument);
+    void join();
+};
+
+u32 get_hardware_thread_count();
+
+// @Info: returns the value it had before the increment
+u32 atomic_increment(volatile u32* value);
+
+using TaskFunction = void (*)(void* context, u32 task_index);
+
+const u32 max_worker_count = 64;
+
+// @Info: runs task_count tasks on up to thread_count workers, the calling thread being one of them. Every worker takes the next
+// task as soon as it is done with the previous one, so uneven tasks still keep all of them busy. Returns once every task is done.
+void run_tasks(TaskFunction function, void* context, u32 task_count, u32 thread_count);
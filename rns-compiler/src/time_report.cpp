@@ -0,0 +1,292 @@
+#include "time_report.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+
+using namespace RNS;
+
+static const char* phase_names[] = {
+    "Lexer",
+    "Parser",
+    "IR",
+    "Machine code",
+};
+static const char* phase_json_names[] = {
+    "lexer",
+    "parser",
+    "ir",
+    "machine_code",
+};
+static_assert(rns_array_length(phase_names) == phase_count);
+static_assert(rns_array_length(phase_json_names) == phase_count);
+
+#if defined(_WIN32)
+static u64 filetime_to_ns(FILETIME file_time)
+{
+    return ((static_cast<u64>(file_time.dwHighDateTime) << 32) | file_time.dwLowDateTime) * 100;
+}
+
+u64 get_wall_time_ns()
+{
+    static LARGE_INTEGER frequency;
+    if (!frequency.QuadPart)
+    {
+        QueryPerformanceFrequency(&frequency);
+    }
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return static_cast<u64>(counter.QuadPart / frequency.QuadPart) * 1000000000ull + static_cast<u64>(counter.QuadPart % frequency.QuadPart) * 1000000000ull / frequency.QuadPart;
+}
+
+u64 get_thread_cpu_time_ns()
+{
+    FILETIME creation_time, exit_time, kernel_time, user_time;
+    GetThreadTimes(GetCurrentThread(), &creation_time, &exit_time, &kernel_time, &user_time);
+    return filetime_to_ns(kernel_time) + filetime_to_ns(user_time);
+}
+
+u64 get_process_cpu_time_ns()
+{
+    FILETIME creation_time, exit_time, kernel_time, user_time;
+    GetProcessTimes(GetCurrentProcess(), &creation_time, &exit_time, &kernel_time, &user_time);
+    return filetime_to_ns(kernel_time) + filetime_to_ns(user_time);
+}
+#else
+static u64 get_clock_ns(clockid_t clock)
+{
+    struct timespec time;
+    clock_gettime(clock, &time);
+    return static_cast<u64>(time.tv_sec) * 1000000000ull + time.tv_nsec;
+}
+
+u64 get_wall_time_ns()
+{
+    return get_clock_ns(CLOCK_MONOTONIC);
+}
+
+u64 get_thread_cpu_time_ns()
+{
+    return get_clock_ns(CLOCK_THREAD_CPUTIME_ID);
+}
+
+u64 get_process_cpu_time_ns()
+{
+    return get_clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+}
+#endif
+
+void PhaseStats::add(PhaseStats other)
+{
+    wall_ns += other.wall_ns;
+    cpu_ns += other.cpu_ns;
+    allocated_size += other.allocated_size;
+}
+
+void PhaseTimer::start(Compiler& compiler)
+{
+    *this = {};
+    wall_start = get_wall_time_ns();
+    cpu_start = get_thread_cpu_time_ns();
+    compiler.phase_timer = this;
+}
+
+void PhaseTimer::end_phase(Compiler& compiler)
+{
+    u64 wall_end = get_wall_time_ns();
+    u64 cpu_end = get_thread_cpu_time_ns();
+
+    auto& phase = phases[static_cast<u32>(compiler.subsystem)];
+    phase.add({
+        .wall_ns = wall_end - wall_start,
+        .cpu_ns = cpu_end - cpu_start,
+    });
+
+    wall_start = wall_end;
+    cpu_start = cpu_end;
+}
+
+void PhaseTimer::stop(Compiler& compiler)
+{
+    end_phase(compiler);
+    compiler.phase_timer = nullptr;
+}
+
+void PhaseTimer::add_memory(Compiler::Subsystem phase, s64 used_size)
+{
+    phases[static_cast<u32>(phase)].allocated_size += used_size;
+}
+
+PhaseStats FileTimeReport::get_total()
+{
+    PhaseStats total = {};
+    for (u32 phase = 0; phase < phase_count; phase++)
+    {
+        total.add(timer.phases[phase]);
+    }
+
+    return total;
+}
+
+TimeReport TimeReport::create(Allocator* allocator, const char** file_names, u32 file_count)
+{
+    TimeReport report = {
+        .files = new(allocator) FileTimeReport[file_count],
+        .file_count = file_count,
+    };
+
+    for (u32 i = 0; i < file_count; i++)
+    {
+        report.files[i] = {
+            .name = file_names[i],
+        };
+    }
+
+    return report;
+}
+
+void TimeReport::begin()
+{
+    wall_start = get_wall_time_ns();
+    cpu_start = get_process_cpu_time_ns();
+}
+
+void TimeReport::end()
+{
+    PhaseStats phase_totals[phase_count];
+    get_phase_totals(phase_totals);
+
+    total = {
+        .wall_ns = get_wall_time_ns() - wall_start,
+        .cpu_ns = get_process_cpu_time_ns() - cpu_start,
+    };
+    for (u32 phase = 0; phase < phase_count; phase++)
+    {
+        total.allocated_size += phase_totals[phase].allocated_size;
+    }
+}
+
+void TimeReport::get_phase_totals(PhaseStats* phase_totals)
+{
+    for (u32 phase = 0; phase < phase_count; phase++)
+    {
+        phase_totals[phase] = timer.phases[phase];
+        for (u32 i = 0; i < file_count; i++)
+        {
+            phase_totals[phase].add(files[i].timer.phases[phase]);
+        }
+    }
+}
+
+static void print_phase_stats(const char* indentation, const char* name, PhaseStats stats)
+{
+    printf("%s%-*s %12.3f %12.3f %14" PRId64 "\n", indentation, static_cast<s32>(32 - strlen(indentation)), name, stats.wall_ns / 1e6, stats.cpu_ns / 1e6, stats.allocated_size / 1024);
+}
+
+void TimeReport::print()
+{
+    PhaseStats phase_totals[phase_count];
+    get_phase_totals(phase_totals);
+
+    printf("\nTime report %-20s %12s %12s %14s\n", "", "Wall (ms)", "CPU (ms)", "Memory (KB)");
+    for (u32 phase = 0; phase < phase_count; phase++)
+    {
+        // @Info: phases the compiler never entered are left out, machine code generation isn't there yet
+        if (phase_totals[phase].wall_ns)
+        {
+            print_phase_stats("  ", phase_names[phase], phase_totals[phase]);
+        }
+    }
+
+    for (u32 i = 0; i < file_count; i++)
+    {
+        print_phase_stats("  ", files[i].name, files[i].get_total());
+        for (u32 phase = 0; phase < phase_count; phase++)
+        {
+            if (files[i].timer.phases[phase].wall_ns)
+            {
+                print_phase_stats("    ", phase_names[phase], files[i].timer.phases[phase]);
+            }
+        }
+        printf("    %-28s %12" PRId64 "\n", "Nodes", files[i].node_count);
+    }
+
+    print_phase_stats("  ", "Total", total);
+}
+
+void write_json_string(FILE* file, const char* string)
+{
+    fputc('"', file);
+    for (const char* it = string; *it; it++)
+    {
+        u8 c = static_cast<u8>(*it);
+        if (c == '"' || c == '\\')
+        {
+            fprintf(file, "\\%c", c);
+        }
+        else if (c < 0x20)
+        {
+            fprintf(file, "\\u%04x", c);
+        }
+        else
+        {
+            fputc(c, file);
+        }
+    }
+    fputc('"', file);
+}
+
+static void write_json_stats(FILE* file, PhaseStats stats)
+{
+    fprintf(file, "{ \"wall_ns\": %" PRIu64 ", \"cpu_ns\": %" PRIu64 ", \"allocated_bytes\": %" PRId64 " }", stats.wall_ns, stats.cpu_ns, stats.allocated_size);
+}
+
+static void write_json_phases(FILE* file, PhaseStats* phases)
+{
+    fprintf(file, "{");
+    for (u32 phase = 0; phase < phase_count; phase++)
+    {
+        fprintf(file, "%s \"%s\": ", phase ? "," : "", phase_json_names[phase]);
+        write_json_stats(file, phases[phase]);
+    }
+    fprintf(file, " }");
+}
+
+bool TimeReport::write_json(const char* path)
+{
+    FILE* file = fopen(path, "wb");
+    if (!file)
+    {
+        printf("Couldn't open %s to write the time report\n", path);
+        return false;
+    }
+
+    PhaseStats phase_totals[phase_count];
+    get_phase_totals(phase_totals);
+
+    fprintf(file, "{\n  \"total\": ");
+    write_json_stats(file, total);
+    fprintf(file, ",\n  \"phases\": ");
+    write_json_phases(file, phase_totals);
+    fprintf(file, ",\n  \"files\": [");
+    for (u32 i = 0; i < file_count; i++)
+    {
+        fprintf(file, "%s\n    { \"name\": ", i ? "," : "");
+        write_json_string(file, files[i].name);
+        fprintf(file, ", \"total\": ");
+        write_json_stats(file, files[i].get_total());
+        fprintf(file, ", \"phases\": ");
+        write_json_phases(file, files[i].timer.phases);
+        fprintf(file, ", \"node_count\": %" PRId64 " }", files[i].node_count);
+    }
+    fprintf(file, "\n  ]\n}\n");
+
+    return fclose(file) == 0;
+}
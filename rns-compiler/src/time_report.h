@@ -0,0 +1,76 @@
+#pragma once
+#include <RNS/types.h>
+#include <RNS/data_structures.h>
+#include <stdio.h>
+#include "compiler_types.h"
+
+/* Time report
+ * Wall time, CPU time and memory of every phase of a compilation, for each file and in total. A compiler with a PhaseTimer charges
+ * everything which happens between two subsystem changes to the subsystem it was in, so lexing and parsing are told apart even
+ * though the token stream interleaves them. Each front-end compiler has a timer of its own, running on its worker, and the timer
+ * of the global compiler covers merging the files and the backend.
+ * Memory is the used size of the arenas each phase owns, measured by the driver where it measures them for the memory profile:
+ * the lexer owns the token stream and the front-end common arena its symbols and line index go to, the parser owns its arena and
+ * the type system of the file, and merging the files and the backend charge what they use of theirs. Reserved but unused room
+ * isn't counted, so a phase carving out a suballocator isn't charged for the whole of it.
+ */
+u64 get_wall_time_ns();
+u64 get_thread_cpu_time_ns();
+u64 get_process_cpu_time_ns();
+// @Info: writes the string quoted, escaping what JSON doesn't take as is. Shared with the trace writer
+void write_json_string(FILE* file, const char* string);
+
+const u32 phase_count = static_cast<u32>(Compiler::Subsystem::Count);
+
+struct PhaseStats
+{
+    u64 wall_ns;
+    u64 cpu_ns;
+    s64 allocated_size;
+
+    void add(PhaseStats other);
+};
+
+struct PhaseTimer
+{
+    PhaseStats phases[phase_count];
+    u64 wall_start;
+    u64 cpu_start;
+
+    void start(Compiler& compiler);
+    // @Info: charges the time since the last call to the current subsystem of the compiler
+    void end_phase(Compiler& compiler);
+    void stop(Compiler& compiler);
+    void add_memory(Compiler::Subsystem phase, s64 used_size);
+};
+
+struct FileTimeReport
+{
+    const char* name;
+    PhaseTimer timer;
+    // @Info: AST nodes the parser made for the file, which the time and memory of the parser grow with
+    s64 node_count;
+
+    PhaseStats get_total();
+};
+
+struct TimeReport
+{
+    FileTimeReport* files;
+    u32 file_count;
+    // @Info: the global compiler, once the front-ends are done
+    PhaseTimer timer;
+    PhaseStats total;
+    u64 wall_start;
+    u64 cpu_start;
+
+    static TimeReport create(Allocator* allocator, const char** file_names, u32 file_count);
+    // @Info: the total covers everything in between, with the CPU time of every thread of the process
+    void begin();
+    void end();
+    void print();
+    bool write_json(const char* path);
+
+private:
+    void get_phase_totals(PhaseStats* phase_totals);
+};
@@ -0,0 +1,160 @@
+#include "trace.h"
+#include "thread.h"
+
+#include <RNS/data_structures.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+
+using namespace RNS;
+
+static_assert((trace_buffer_event_count & (trace_buffer_event_count - 1)) == 0, "The ring buffer is indexed with a mask");
+
+struct TraceEvent
+{
+    const char* name;
+    const char* detail;
+    u64 begin_ns;
+    u64 end_ns;
+};
+
+struct TraceBuffer
+{
+    TraceEvent events[trace_buffer_event_count];
+    u64 event_count;
+    Allocator allocator;
+};
+
+bool trace_enabled = false;
+static u64 trace_start_ns;
+static TraceBuffer* trace_buffers[trace_max_thread_count];
+static volatile u32 trace_buffer_count;
+static thread_local TraceBuffer* thread_trace_buffer;
+// @Info: set on the threads which came after the last buffer, so they stop trying
+static thread_local bool thread_trace_dropped;
+
+static TraceBuffer* register_trace_buffer()
+{
+    u32 index = atomic_increment(&trace_buffer_count);
+    if (index >= trace_max_thread_count)
+    {
+        return nullptr;
+    }
+
+    Allocator allocator = default_create_allocator(sizeof(TraceBuffer) + 1024);
+    auto* buffer = new(&allocator) TraceBuffer;
+    buffer->event_count = 0;
+    buffer->allocator = allocator;
+    trace_buffers[index] = buffer;
+    thread_trace_buffer = buffer;
+
+    return buffer;
+}
+
+void record_trace_event(const char* name, const char* detail, u64 begin_ns, u64 end_ns)
+{
+    TraceBuffer* buffer = thread_trace_buffer;
+    if (!buffer)
+    {
+        if (thread_trace_dropped)
+        {
+            return;
+        }
+
+        buffer = register_trace_buffer();
+        if (!buffer)
+        {
+            thread_trace_dropped = true;
+            return;
+        }
+    }
+
+    buffer->events[buffer->event_count & (trace_buffer_event_count - 1)] = {
+        .name = name,
+        .detail = detail,
+        .begin_ns = begin_ns,
+        .end_ns = end_ns,
+    };
+    buffer->event_count++;
+}
+
+void trace_begin()
+{
+    trace_start_ns = get_wall_time_ns();
+    trace_enabled = true;
+    // @Info: the main thread gets the first buffer
+    register_trace_buffer();
+}
+
+// @Info: Chrome Trace Event format, one complete event ("ph": "X") per scope. Timestamps are microseconds from the start of the trace
+static void write_trace(FILE* file, u32 buffer_count)
+{
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    for (u32 thread_index = 0; thread_index < buffer_count; thread_index++)
+    {
+        TraceBuffer* buffer = trace_buffers[thread_index];
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", thread_index ? ",\n" : "", thread_index);
+        if (thread_index)
+        {
+            fprintf(file, "\"Worker %u\"}}", thread_index);
+        }
+        else
+        {
+            fprintf(file, "\"Main thread\"}}");
+        }
+
+        u64 event_count = buffer->event_count;
+        u64 first_event = event_count > trace_buffer_event_count ? event_count - trace_buffer_event_count : 0;
+        for (u64 i = first_event; i < event_count; i++)
+        {
+            TraceEvent& event = buffer->events[i & (trace_buffer_event_count - 1)];
+            u64 begin_ns = event.begin_ns - trace_start_ns;
+            u64 duration_ns = event.end_ns - event.begin_ns;
+            fprintf(file, ",\n{\"name\":");
+            write_json_string(file, event.name);
+            fprintf(file, ",\"cat\":\"rns\",\"ph\":\"X\",\"ts\":%" PRIu64 ".%03" PRIu64 ",\"dur\":%" PRIu64 ".%03" PRIu64 ",\"pid\":1,\"tid\":%u", begin_ns / 1000, begin_ns % 1000, duration_ns / 1000, duration_ns % 1000, thread_index);
+            if (event.detail)
+            {
+                fprintf(file, ",\"args\":{\"detail\":");
+                write_json_string(file, event.detail);
+                fprintf(file, "}");
+            }
+            fprintf(file, "}");
+        }
+    }
+    fprintf(file, "\n]}\n");
+}
+
+bool trace_end(const char* path)
+{
+    trace_enabled = false;
+    u32 buffer_count = trace_buffer_count < trace_max_thread_count ? trace_buffer_count : trace_max_thread_count;
+
+    bool written = false;
+    FILE* file = fopen(path, "wb");
+    if (file)
+    {
+        write_trace(file, buffer_count);
+        written = fclose(file) == 0;
+    }
+    if (!written)
+    {
+        printf("Couldn't write the trace to %s\n", path);
+    }
+    if (trace_buffer_count > trace_max_thread_count)
+    {
+        printf("Only the first %u threads were traced\n", trace_max_thread_count);
+    }
+
+    for (u32 i = 0; i < buffer_count; i++)
+    {
+        Allocator allocator = trace_buffers[i]->allocator;
+        default_free_allocator(&allocator);
+        trace_buffers[i] = nullptr;
+    }
+    trace_buffer_count = 0;
+    thread_trace_buffer = nullptr;
+    thread_trace_dropped = false;
+
+    return written;
+}
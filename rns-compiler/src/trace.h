@@ -0,0 +1,54 @@
+#pragma once
+#include <RNS/types.h>
+#include <RNS/profiler.h>
+#include "time_report.h"
+
+/* Tracing
+ * Portable timeline of the compilation, written as a Chrome Trace Event file which chrome://tracing and Perfetto load. A scope
+ * records one event with its begin and end time in nanoseconds when it closes. Every thread records into a ring buffer of its
+ * own, so recording takes no lock and no atomic: the newest trace_buffer_event_count events of each thread are kept. Threads
+ * only register their buffer, once, with an atomic increment. The events are read once every thread which recorded them is
+ * done, so the trace is written after the compilation.
+ * With tracing off a scope is a load and a branch when it opens and another when it closes.
+ */
+const u32 trace_buffer_event_count = 1 << 16;
+const u32 trace_max_thread_count = 256;
+
+extern bool trace_enabled;
+
+// @Info: starts recording, the calling thread being the main one
+void trace_begin();
+// @Info: stops recording, writes the trace to the path and frees the buffers
+bool trace_end(const char* path);
+void record_trace_event(const char* name, const char* detail, u64 begin_ns, u64 end_ns);
+
+// @Info: name and detail have to outlive the trace, string literals and paths from the command line do
+struct TraceScope
+{
+    const char* name;
+    const char* detail;
+    u64 begin_ns;
+
+    inline TraceScope(const char* name, const char* detail = nullptr) : name(name), detail(detail), begin_ns(trace_enabled ? get_wall_time_ns() : 0)
+    {
+    }
+
+    inline ~TraceScope()
+    {
+        if (begin_ns)
+        {
+            record_trace_event(name, detail, begin_ns, get_wall_time_ns());
+        }
+    }
+};
+
+#define RNS_TRACE_CONCAT_INTERNAL(a, b) a##b
+#define RNS_TRACE_CONCAT(a, b) RNS_TRACE_CONCAT_INTERNAL(a, b)
+#define RNS_TRACE_SCOPE(...) TraceScope RNS_TRACE_CONCAT(trace_scope_, __LINE__)(__VA_ARGS__)
+#define RNS_TRACE_FUNCTION() RNS_TRACE_SCOPE(__FUNCTION__)
+
+// @Info: profiling builds keep sending the functions RNS/profiler.h marks to Superluminal, the rest trace them
+#if !SL_INSTR
+#undef RNS_PROFILE_FUNCTION
+#define RNS_PROFILE_FUNCTION() RNS_TRACE_FUNCTION()
+#endif